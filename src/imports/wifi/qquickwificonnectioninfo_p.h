@@ -0,0 +1,69 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef QQUICKWIFICONNECTIONINFO_P_H
+#define QQUICKWIFICONNECTIONINFO_P_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qmetatype.h>
+#include <WiFi/wifiinfo.h>
+
+/*
+ * WiFiManager.connectionInfo 的值类型，只读。连接信息变化时整体替换并只发出
+ * 一次 connectionInfoChanged ，QML 中依赖多个字段的绑定只重新求值一次。
+ */
+class QQuickWiFiConnectionInfo
+{
+    Q_GADGET
+    Q_PROPERTY(QString macAddress READ macAddress CONSTANT)
+    Q_PROPERTY(QString bssid READ bssid CONSTANT)
+    Q_PROPERTY(QString ssid READ ssid CONSTANT)
+    Q_PROPERTY(int rssi READ rssi CONSTANT)
+    Q_PROPERTY(int frequency READ frequency CONSTANT)
+    Q_PROPERTY(QString ipAddress READ ipAddress CONSTANT)
+    Q_PROPERTY(int networkId READ networkId CONSTANT)
+    Q_PROPERTY(int rxLinkSpeed READ rxLinkSpeed CONSTANT)
+    Q_PROPERTY(int txLinkSpeed READ txLinkSpeed CONSTANT)
+public:
+    QQuickWiFiConnectionInfo() {}
+    explicit QQuickWiFiConnectionInfo(const WiFiInfo &info) : m_info(info) {}
+
+    QString macAddress() const;
+    QString bssid() const;
+    QString ssid() const { return m_info.ssid(); }
+    int rssi() const { return m_info.rssi(); }
+    int frequency() const { return m_info.frequency(); }
+    QString ipAddress() const { return m_info.ipAddress(); }
+    int networkId() const { return m_info.networkId(); }
+    int rxLinkSpeed() const { return m_info.rxLinkSpeed(); }
+    int txLinkSpeed() const { return m_info.txLinkSpeed(); }
+
+    const WiFiInfo &info() const { return m_info; }
+
+    bool operator==(const QQuickWiFiConnectionInfo &other) const
+    { return m_info == other.m_info; }
+    bool operator!=(const QQuickWiFiConnectionInfo &other) const
+    { return m_info != other.m_info; }
+
+private:
+    WiFiInfo m_info;
+};
+
+Q_DECLARE_METATYPE(QQuickWiFiConnectionInfo)
+
+#endif // QQUICKWIFICONNECTIONINFO_P_H
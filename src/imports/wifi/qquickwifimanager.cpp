@@ -38,6 +38,8 @@ QQuickWiFiManager::QQuickWiFiManager(QObject *parent)
             SIGNAL(networkConnected(int)));
     connect(m_manager, SIGNAL(networkErrorOccurred(int)),
             SIGNAL(networkErrorOccurred(int)));
+    connect(m_manager, SIGNAL(addNetworkFinished(int, int)),
+            SIGNAL(addNetworkFinished(int, int)));
 }
 
 bool QQuickWiFiManager::isWiFiServiced() const
@@ -72,6 +74,11 @@ void QQuickWiFiManager::setWiFiAutoScan(bool autoScan)
 }
 
 
+QQuickWiFiConnectionInfo QQuickWiFiManager::connectionInfo() const
+{
+    return m_connectionInfo;
+}
+
 QString QQuickWiFiManager::macAddress() const
 {
     return m_macAddress;
@@ -111,6 +118,21 @@ int QQuickWiFiManager::addNetwork(const QString &ssid, const QString &password,
     return m_manager->addNetwork(net);
 }
 
+/*
+ * 不阻塞界面线程，返回请求 ID ，结果通过 addNetworkFinished 通知。
+ * WiFiManager 在构造时已经创建，组件完成前的调用同样提交并得到结果信号，
+ * 每次调用都会发出一次 addNetworkFinished 。
+ */
+int QQuickWiFiManager::addNetworkAsync(const QString &ssid, const QString &password,
+                                       const QString &bssid)
+{
+    WiFiNetwork net(-1, ssid);
+    net.setAuthFlags(WiFi::WPA2_PSK);
+    net.setPreSharedKey(password);
+    net.setBSSID(WiFiMacAddress(bssid));
+    return m_manager->addNetworkAsync(net);
+}
+
 void QQuickWiFiManager::selectNetwork(int networkId)
 {
     if(!m_componentCompleted) {
@@ -139,14 +161,26 @@ void QQuickWiFiManager::componentComplete()
     m_componentCompleted = true;
 }
 
+/*
+ * WiFiInfo 按 quint64 比较 MAC 地址，整体不变时不发出信号；
+ * 变化时替换缓存的值并发出一次 connectionInfoChanged ，
+ * 再为兼容属性中实际变化的字段发出各自的信号。
+ */
 void QQuickWiFiManager::onConnectionInfoChanged()
 {
-    WiFiInfo info = m_manager->connectionInfo();
-    if(WiFiMacAddress(m_macAddress) != info.macAddress()) {
+    const WiFiInfo info = m_manager->connectionInfo();
+    if(m_connectionInfo.info() == info) {
+        return;
+    }
+    const WiFiInfo previous = m_connectionInfo.info();
+    m_connectionInfo = QQuickWiFiConnectionInfo(info);
+    emit connectionInfoChanged();
+
+    if(previous.macAddress() != info.macAddress()) {
         m_macAddress = info.macAddress().toString();
         emit macAddressChanged();
     }
-    if(WiFiMacAddress(m_bssid) != info.bssid()) {
+    if(previous.bssid() != info.bssid()) {
         m_bssid = info.bssid().toString();
         emit bssidChanged();
     }
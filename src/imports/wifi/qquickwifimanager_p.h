@@ -23,6 +23,8 @@
 #include <QtQml/qqmlparserstatus.h>
 #include <WiFi/wifimanager.h>
 
+#include "qquickwificonnectioninfo_p.h"
+
 class QQuickWiFiManager : public QObject, public QQmlParserStatus
 {
     Q_OBJECT
@@ -32,6 +34,9 @@ class QQuickWiFiManager : public QObject, public QQmlParserStatus
                isWiFiEnabledChanged)
     Q_PROPERTY(bool isWiFiAutoScan READ isWiFiAutoScan WRITE setWiFiAutoScan
                NOTIFY isWiFiAutoScanChanged)
+    Q_PROPERTY(QQuickWiFiConnectionInfo connectionInfo READ connectionInfo
+               NOTIFY connectionInfoChanged)
+    /* 以下属性保留兼容，各自的变化信号与 connectionInfoChanged 一同发出 */
     Q_PROPERTY(QString macAddress READ macAddress NOTIFY macAddressChanged)
     Q_PROPERTY(QString bssid READ bssid NOTIFY bssidChanged)
     Q_PROPERTY(QString ssid READ ssid NOTIFY ssidChanged)
@@ -49,6 +54,8 @@ public:
     bool isWiFiAutoScan() const;
     void setWiFiAutoScan(bool autoScan);
 
+    QQuickWiFiConnectionInfo connectionInfo() const;
+
     QString macAddress() const;
     QString bssid() const;
     QString ssid() const;
@@ -58,6 +65,8 @@ public:
 
     Q_INVOKABLE int addNetwork(const QString &ssid, const QString &password,
                                const QString &bssid = QString());
+    Q_INVOKABLE int addNetworkAsync(const QString &ssid, const QString &password,
+                                    const QString &bssid = QString());
     Q_INVOKABLE void selectNetwork(int networkId);
     Q_INVOKABLE void removeNetwork(int networkId);
 
@@ -69,6 +78,7 @@ signals:
     void isWiFiServicedChanged();
     void isWiFiEnabledChanged();
     void isWiFiAutoScanChanged();
+    void connectionInfoChanged();
     void macAddressChanged();
     void bssidChanged();
     void ssidChanged();
@@ -81,12 +91,15 @@ signals:
     void networkConnected(int networkId);
     void networkErrorOccurred(int networkId);
 
+    void addNetworkFinished(int requestId, int networkId);
+
 private slots:
     void onConnectionInfoChanged();
 
 private:
     bool m_componentCompleted = false;
     WiFiManager *m_manager = NULL;
+    QQuickWiFiConnectionInfo m_connectionInfo;
     QString m_macAddress;
     QString m_bssid;
     QString m_ssid;
@@ -20,35 +20,23 @@
 
 #include <WiFi/wifimacaddress.h>
 
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+
+static inline quint64 bssidKey(const WiFiScanResult &result)
+{
+    return result.bssid().toUInt64();
+}
+
 QQuickWiFiScanResultModel::QQuickWiFiScanResultModel(QObject *parent)
     : QAbstractListModel(parent)
     , m_manager(new WiFiManager(this))
     , m_complete(false)
 {
-    connect(m_manager, &WiFiManager::scanResultFound, [this](const WiFiScanResult &result) {
-        int i = m_scanResults.size();
-        this->beginInsertRows(QModelIndex(), i, i);
-        m_scanResults << result;
-        this->endInsertRows();
-    });
-    connect(m_manager, &WiFiManager::scanResultUpdated, [this](const WiFiScanResult &result) {
-        int i = m_scanResults.indexOf(result);
-        m_scanResults.replace(i, result);
-        this->dataChanged(index(i), index(i));
-    });
-    connect(m_manager, &WiFiManager::scanResultLost, [this](const WiFiScanResult &result) {
-        int i = m_scanResults.indexOf(result);
-        if(i > -1) {
-            this->beginRemoveRows(QModelIndex(), i, i);
-            m_scanResults.removeAt(i);
-            this->endRemoveRows();
-        }
-    });
-    connect(m_manager, &WiFiManager::scanResultsChanged, [this]() {
-        this->beginResetModel();
-        m_scanResults =  m_manager->scanResults();
-        this->endResetModel();
-    });
+    connect(m_manager, &WiFiManager::scanResultsDelta,
+            this, &QQuickWiFiScanResultModel::onScanResultsDelta);
+    connect(m_manager, &WiFiManager::scanResultsChanged,
+            this, &QQuickWiFiScanResultModel::onScanResultsChanged);
 
     connect(m_manager, SIGNAL(networkConnecting(int)),
             SLOT(onNetworkConnecting(int)));
@@ -58,53 +46,262 @@ QQuickWiFiScanResultModel::QQuickWiFiScanResultModel(QObject *parent)
             SLOT(onNetworkConnected(int)));
     connect(m_manager, SIGNAL(networkErrorOccurred(int)),
             SLOT(onNetworkErrorOccurred(int)));
+    connect(m_manager, SIGNAL(connectionInfoChanged()),
+            SLOT(onConnectionInfoChanged()));
 
-    m_scanResults =  m_manager->scanResults();
+    const WiFiScanResultList results = m_manager->scanResults();
+    m_rows.reserve(results.size());
+    for(const WiFiScanResult &result : results) {
+        m_rows << makeRow(result);
+    }
+    m_currentBssid = m_manager->connectionInfo().bssid().toUInt64();
 }
 
-void QQuickWiFiScanResultModel::onNetworkConnecting(int networkId)
+/* \a previous 为同一 BSSID 的旧行时沿用已格式化的 BSSID 字符串 */
+QQuickWiFiScanResultModel::Row QQuickWiFiScanResultModel::makeRow(
+                const WiFiScanResult &result, const Row *previous)
+{
+    Row row;
+    row.bssid = bssidKey(result);
+    row.bssidText = previous ? previous->bssidText : result.bssid().toString();
+    row.ssid = result.ssid();
+    row.flags = result.flags();
+    row.rssi = result.rssi();
+    row.frequency = result.frequency();
+    row.networkId = result.networkId();
+    row.signalLevel = WiFiManager::CalculateSignalLevel(row.rssi, 4);
+    return row;
+}
+
+/*
+ * 一次扫描的全部变化：删除的行按连续区间移除，已有的行只通知变化的角色，
+ * 新增的行一次性追加到末尾。重复或缺失的条目按幂等规则处理。
+ */
+void QQuickWiFiScanResultModel::onScanResultsDelta(const WiFiScanResultList &added,
+        const WiFiScanResultList &updated, const WiFiScanResultList &removed)
 {
-    m_status = qMakePair(networkId, 1);
-    for(int i = 0; i < m_scanResults.size(); ++i) {
-        if(m_scanResults[i].networkId() == networkId) {
-            this->dataChanged(index(i), index(i));
+    if(!removed.isEmpty()) {
+        QSet<quint64> lost;
+        lost.reserve(removed.size());
+        for(const WiFiScanResult &result : removed) {
+            lost.insert(bssidKey(result));
         }
+        QVector<int> rows;
+        for(int i = 0; i < m_rows.size(); ++i) {
+            if(lost.contains(m_rows.at(i).bssid)) {
+                rows << i;
+            }
+        }
+        removeRowList(rows);
+    }
+
+    if(added.isEmpty() && updated.isEmpty()) {
+        return;
+    }
+
+    QHash<quint64, int> rows;
+    rows.reserve(m_rows.size() + added.size());
+    for(int i = 0; i < m_rows.size(); ++i) {
+        rows.insert(m_rows.at(i).bssid, i);
+    }
+    QVector<Row> inserted;
+    auto apply = [&](const WiFiScanResult &result) {
+        const quint64 bssid = bssidKey(result);
+        const int row = rows.value(bssid, -1);
+        if(row < 0) {
+            rows.insert(bssid, m_rows.size() + inserted.size());
+            inserted << makeRow(result);
+        } else if(row >= m_rows.size()) {
+            inserted[row - m_rows.size()] = makeRow(result);
+        } else {
+            updateRow(row, result);
+        }
+    };
+    for(const WiFiScanResult &result : added) {
+        apply(result);
+    }
+    for(const WiFiScanResult &result : updated) {
+        apply(result);
+    }
+
+    if(!inserted.isEmpty()) {
+        const int first = m_rows.size();
+        beginInsertRows(QModelIndex(), first, first + inserted.size() - 1);
+        m_rows += inserted;
+        endInsertRows();
     }
 }
 
-void QQuickWiFiScanResultModel::onNetworkAuthenticated(int networkId)
+/*
+ * 整表替换时以 BSSID 为键与当前行比较，依次发出删除、移动、插入与
+ * dataChanged ，保留未变化的行，不重置模型。
+ */
+void QQuickWiFiScanResultModel::onScanResultsChanged()
 {
-    m_status = qMakePair(networkId, 2);
-    for(int i = 0; i < m_scanResults.size(); ++i) {
-        if(m_scanResults[i].networkId() == networkId) {
-            this->dataChanged(index(i), index(i));
+    const WiFiScanResultList results = m_manager->scanResults();
+
+    QSet<quint64> target;
+    target.reserve(results.size());
+    for(const WiFiScanResult &result : results) {
+        target.insert(bssidKey(result));
+    }
+
+    QVector<int> lost;
+    QSet<quint64> present;
+    present.reserve(m_rows.size());
+    for(int i = 0; i < m_rows.size(); ++i) {
+        const quint64 bssid = m_rows.at(i).bssid;
+        if(target.contains(bssid)) {
+            present.insert(bssid);
+        } else {
+            lost << i;
         }
     }
+    removeRowList(lost);
+
+    /* 此时当前的行都存在于新列表中，逐行对齐到新列表的顺序 */
+    for(int i = 0; i < results.size(); ++i) {
+        const quint64 bssid = bssidKey(results.at(i));
+        if(i < m_rows.size() && m_rows.at(i).bssid == bssid) {
+            updateRow(i, results.at(i));
+            continue;
+        }
+
+        if(present.contains(bssid)) {
+            int from = i + 1;
+            while(m_rows.at(from).bssid != bssid) {
+                ++from;
+            }
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), i);
+            m_rows.move(from, i);
+            endMoveRows();
+            updateRow(i, results.at(i));
+            continue;
+        }
+
+        int last = i;
+        while(last + 1 < results.size() && !present.contains(bssidKey(results.at(last + 1)))) {
+            ++last;
+        }
+        beginInsertRows(QModelIndex(), i, last);
+        for(int k = i; k <= last; ++k) {
+            m_rows.insert(k, makeRow(results.at(k)));
+        }
+        endInsertRows();
+        i = last;
+    }
 }
 
-void QQuickWiFiScanResultModel::onNetworkConnected(int networkId)
+/* \a rows 按升序排列，从后往前按连续区间移除 */
+void QQuickWiFiScanResultModel::removeRowList(const QVector<int> &rows)
+{
+    int last = rows.size() - 1;
+    while(last >= 0) {
+        int first = last;
+        while(first > 0 && rows.at(first - 1) == rows.at(first) - 1) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), rows.at(first), rows.at(last));
+        m_rows.erase(m_rows.begin() + rows.at(first),
+                     m_rows.begin() + rows.at(last) + 1);
+        endRemoveRows();
+        last = first - 1;
+    }
+}
+
+void QQuickWiFiScanResultModel::updateRow(int row, const WiFiScanResult &result)
+{
+    Row &current = m_rows[row];
+    const Row next = makeRow(result, &current);
+    const QVector<int> roles = changedRoles(current, next);
+    if(!roles.isEmpty()) {
+        current = next;
+        const QModelIndex i = index(row);
+        Q_EMIT dataChanged(i, i, roles);
+    }
+}
+
+QVector<int> QQuickWiFiScanResultModel::changedRoles(const Row &before,
+        const Row &after)
 {
-    m_status = qMakePair(networkId, 3);
-    for(int i = 0; i < m_scanResults.size(); ++i) {
-        if(m_scanResults[i].networkId() == networkId) {
-            this->dataChanged(index(i), index(i));
+    QVector<int> roles;
+    if(before.ssid != after.ssid) {
+        roles << SsidRole;
+    }
+    if(before.rssi != after.rssi) {
+        roles << RssiRole;
+    }
+    if(before.signalLevel != after.signalLevel) {
+        roles << SignalLevelRole;
+    }
+    if(before.frequency != after.frequency) {
+        roles << FrequencyRole;
+    }
+    if(before.flags != after.flags) {
+        roles << FlagsRole;
+    }
+    if(before.networkId != after.networkId) {
+        roles << NetworkIdRole << TypeRole << StatusRole;
+    }
+    return roles;
+}
+
+/* 状态只属于一个网络，切换时同时通知之前网络的行 */
+void QQuickWiFiScanResultModel::setStatus(int networkId, int status)
+{
+    const int previous = m_status.first;
+    m_status = qMakePair(networkId, status);
+    const QVector<int> roles = { StatusRole };
+    for(int i = 0; i < m_rows.size(); ++i) {
+        const int id = m_rows.at(i).networkId;
+        if(id == networkId || (id == previous && id >= 0)) {
+            Q_EMIT dataChanged(index(i), index(i), roles);
         }
     }
 }
 
+void QQuickWiFiScanResultModel::onNetworkConnecting(int networkId)
+{
+    setStatus(networkId, 1);
+}
+
+void QQuickWiFiScanResultModel::onNetworkAuthenticated(int networkId)
+{
+    setStatus(networkId, 2);
+}
+
+void QQuickWiFiScanResultModel::onNetworkConnected(int networkId)
+{
+    setStatus(networkId, 3);
+}
+
 void QQuickWiFiScanResultModel::onNetworkErrorOccurred(int networkId)
 {
-    m_status = qMakePair(networkId, 4);
-    for(int i = 0; i < m_scanResults.size(); ++i) {
-        if(m_scanResults[i].networkId() == networkId) {
-            this->dataChanged(index(i), index(i));
+    setStatus(networkId, 4);
+}
+
+/* 只缓存当前连接的 BSSID ，变化时通知新旧两行的 type 角色 */
+void QQuickWiFiScanResultModel::onConnectionInfoChanged()
+{
+    const quint64 bssid = m_manager->connectionInfo().bssid().toUInt64();
+    if(bssid == m_currentBssid) {
+        return;
+    }
+    const quint64 previous = m_currentBssid;
+    m_currentBssid = bssid;
+
+    const QVector<int> roles = { TypeRole };
+    for(int i = 0; i < m_rows.size(); ++i) {
+        const quint64 key = m_rows.at(i).bssid;
+        if(key == bssid || key == previous) {
+            Q_EMIT dataChanged(index(i), index(i), roles);
         }
     }
 }
 
 int QQuickWiFiScanResultModel::rowCount(const QModelIndex &) const
 {
-    return m_scanResults.count();
+    return m_rows.count();
 }
 
 QVariant QQuickWiFiScanResultModel::data(const QModelIndex &index,
@@ -114,57 +311,53 @@ QVariant QQuickWiFiScanResultModel::data(const QModelIndex &index,
         return QVariant();
     }
 
-    if (index.row() >= m_scanResults.count()) {
+    if (index.row() >= m_rows.count()) {
         qWarning() << "WifiAccessPointModel: Index out of bound";
         return QVariant();
     }
 
-    const WiFiScanResult &scanResult = m_scanResults.value(index.row());
-    QVariantMap scanResultMap = scanResult.toMap();
-    QVariant value;
+    const Row &row = m_rows.at(index.row());
     switch (role) {
-        case Qt::DisplayRole + 7: {
-            int rssi = scanResultMap["rssi"].toInt();
-            value = WiFiManager::CalculateSignalLevel(rssi, 4);
-        }
-        break;
-        case Qt::DisplayRole + 8: {
-            WiFiMacAddress bssid = scanResult.bssid();
-            int networkId = scanResult.networkId();
-            if(m_manager->connectionInfo().bssid() == bssid) {
-                value = 2;
-            } else {
-                value = (networkId >= 0) ? 1 : 0;    // 2: Current, 1: Network, 0: ScanResult
-            }
-        }
-        break;
-        case Qt::DisplayRole + 9: {
-            if(scanResult.networkId() == m_status.first) {
-                value = m_status.second;
-            }else{
-                value = 0;
+        case SsidRole:
+            return row.ssid;
+        case BssidRole:
+            return row.bssidText;
+        case RssiRole:
+            return row.rssi;
+        case FrequencyRole:
+            return row.frequency;
+        case FlagsRole:
+            return row.flags;
+        case NetworkIdRole:
+            return row.networkId;
+        case SignalLevelRole:
+            return row.signalLevel;
+        case TypeRole:
+            // 2: Current, 1: Network, 0: ScanResult
+            if(row.bssid == m_currentBssid) {
+                return 2;
             }
-        }
-        break;
+            return (row.networkId >= 0) ? 1 : 0;
+        case StatusRole:
+            return (row.networkId == m_status.first) ? m_status.second : 0;
         default:
-            value = scanResultMap.value(roleNames().value(role));
             break;
     }
-    return value;
+    return QVariant();
 }
 
 QHash<int, QByteArray> QQuickWiFiScanResultModel::roleNames() const
 {
     static QHash<int, QByteArray> roles = {
-        {Qt::DisplayRole + 1, "ssid"},
-        {Qt::DisplayRole + 2, "bssid"},
-        {Qt::DisplayRole + 3, "rssi"},
-        {Qt::DisplayRole + 4, "frequency"},
-        {Qt::DisplayRole + 5, "flags"},
-        {Qt::DisplayRole + 6, "networkId"},
-        {Qt::DisplayRole + 7, "signalLevel"},
-        {Qt::DisplayRole + 8, "type"},
-        {Qt::DisplayRole + 9, "status"}
+        {SsidRole, "ssid"},
+        {BssidRole, "bssid"},
+        {RssiRole, "rssi"},
+        {FrequencyRole, "frequency"},
+        {FlagsRole, "flags"},
+        {NetworkIdRole, "networkId"},
+        {SignalLevelRole, "signalLevel"},
+        {TypeRole, "type"},
+        {StatusRole, "status"}
     };
 
     return roles;
@@ -30,6 +30,18 @@ class QQuickWiFiScanResultModel : public QAbstractListModel,
     Q_OBJECT
     Q_INTERFACES(QQmlParserStatus)
 public:
+    enum Roles {
+        SsidRole = Qt::DisplayRole + 1,
+        BssidRole,
+        RssiRole,
+        FrequencyRole,
+        FlagsRole,
+        NetworkIdRole,
+        SignalLevelRole,
+        TypeRole,
+        StatusRole
+    };
+
     explicit QQuickWiFiScanResultModel(QObject *parent = nullptr);
 
     //From QAbstractListModel
@@ -42,16 +54,44 @@ public:
     void componentComplete();
 
 private slots:
+    void onScanResultsDelta(const WiFiScanResultList &added,
+                            const WiFiScanResultList &updated,
+                            const WiFiScanResultList &removed);
+    void onScanResultsChanged();
     void onNetworkConnecting(int networkId);
     void onNetworkAuthenticated(int networkId);
     void onNetworkConnected(int networkId);
     void onNetworkErrorOccurred(int networkId);
+    void onConnectionInfoChanged();
 
 private:
+    /*
+     * 每行预先计算好的角色值，data() 直接返回，不再经过 toMap() 。
+     * BSSID 字符串只在行创建时格式化一次。
+     */
+    struct Row {
+        quint64 bssid;
+        QString bssidText;
+        QString ssid;
+        QString flags;
+        int rssi;
+        int frequency;
+        int networkId;
+        int signalLevel;
+    };
+
+    static Row makeRow(const WiFiScanResult &result, const Row *previous = nullptr);
+    static QVector<int> changedRoles(const Row &before, const Row &after);
+
+    void removeRowList(const QVector<int> &rows);
+    void updateRow(int row, const WiFiScanResult &result);
+    void setStatus(int networkId, int status);
+
     WiFiManager *m_manager = NULL;
-    WiFiScanResultList m_scanResults;
+    QVector<Row> m_rows;
+    quint64 m_currentBssid = 0;
     bool m_complete;
-    QPair<int,int> m_status;
+    QPair<int,int> m_status = qMakePair(-1, 0);
 };
 
 QML_DECLARE_TYPE(QT_PREPEND_NAMESPACE(QQuickWiFiScanResultModel))
@@ -19,6 +19,10 @@
 #include "qquickwifisortfiltermodel_p.h"
 
 #include <QtQml>
+#include <QtCore/qregularexpression.h>
+
+#include <algorithm>
+#include <functional>
 
 class QQuickWiFiSortFilterModelPrivate
 {
@@ -27,6 +31,24 @@ public:
     QQuickWiFiSortFilterModelPrivate(QQuickWiFiSortFilterModel *p);
     virtual ~QQuickWiFiSortFilterModelPrivate();
 
+    enum CompareKind {
+        UnresolvedCompare,
+        IntegerCompare,
+        RealCompare,
+        StringCompare,
+        GenericCompare
+    };
+
+    /* 排序键：角色 ID 在角色变化时解析一次，比较方式由第一个有效值的类型决定 */
+    struct SortKey {
+        int role;
+        CompareKind kind;
+    };
+
+    static CompareKind compareKind(int userType);
+    static int compare(CompareKind kind, const QVariant &left, const QVariant &right,
+                       Qt::CaseSensitivity cs, bool isLocaleAware, int hysteresis = 0);
+
     static int fuzzyCompare(float left, float right);
     static int fuzzyCompare(double left, double right);
     static qint64 variantCompare(const QVariant &left,
@@ -34,6 +56,26 @@ public:
                                  Qt::CaseSensitivity cs, bool isLocaleAware);
 public:
     QQuickWiFiSortFilterModel *q_ptr;
+
+    mutable QVector<SortKey> m_sortKeys;
+    QVector<int> m_filterRoles;
+    QString m_filterString;
+    QQuickWiFiSortFilterModel::FilterSyntax m_filterSyntax = QQuickWiFiSortFilterModel::RegExp;
+    QRegularExpression m_filterExpression;
+
+    int m_sortColumn = -1;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+    Qt::CaseSensitivity m_sortCaseSensitivity = Qt::CaseSensitive;
+    bool m_sortLocaleAware = false;
+    Qt::CaseSensitivity m_filterCaseSensitivity = Qt::CaseSensitive;
+
+    bool m_incrementalSort = false;
+    int m_sortHysteresis = 0;
+
+    QVector<int> m_proxyToSource;   // 代理行 -> 源行，按排序键有序
+    QVector<int> m_sourceToProxy;   // 源行 -> 代理行，被过滤的行为 -1
+
+    void updateSourceToProxy(int from);
 };
 
 QQuickWiFiSortFilterModelPrivate::QQuickWiFiSortFilterModelPrivate(
@@ -46,6 +88,74 @@ QQuickWiFiSortFilterModelPrivate::~QQuickWiFiSortFilterModelPrivate()
 {
 }
 
+void QQuickWiFiSortFilterModelPrivate::updateSourceToProxy(int from)
+{
+    for (int row = from; row < m_proxyToSource.size(); ++row) {
+        m_sourceToProxy[m_proxyToSource.at(row)] = row;
+    }
+}
+
+QQuickWiFiSortFilterModelPrivate::CompareKind
+QQuickWiFiSortFilterModelPrivate::compareKind(int userType)
+{
+    switch (userType) {
+        case QMetaType::Bool:
+        case QMetaType::Char:
+        case QMetaType::SChar:
+        case QMetaType::UChar:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return IntegerCompare;
+        case QMetaType::Float:
+        case QMetaType::Double:
+            return RealCompare;
+        case QMetaType::QString:
+            return StringCompare;
+        default:
+            return GenericCompare;
+    }
+}
+
+/* \a hysteresis 大于 0 时，数值差不超过它的两个值视为相等 */
+int QQuickWiFiSortFilterModelPrivate::compare(CompareKind kind,
+        const QVariant &left, const QVariant &right,
+        Qt::CaseSensitivity cs, bool isLocaleAware, int hysteresis)
+{
+    if (!left.isValid() || !right.isValid()) {
+        return left.isValid() ? -1 : (right.isValid() ? 1 : 0);
+    }
+    switch (kind) {
+        case IntegerCompare: {
+            const qlonglong l = left.toLongLong();
+            const qlonglong r = right.toLongLong();
+            if (hysteresis > 0 && qAbs(l - r) <= hysteresis) {
+                return 0;
+            }
+            return l < r ? -1 : (r < l ? 1 : 0);
+        }
+        case RealCompare:
+            if (hysteresis > 0 && qAbs(left.toDouble() - right.toDouble()) <= hysteresis) {
+                return 0;
+            }
+            return fuzzyCompare(left.toDouble(), right.toDouble());
+        case StringCompare:
+            if (isLocaleAware) {
+                return left.toString().localeAwareCompare(right.toString());
+            }
+            return left.toString().compare(right.toString(), cs);
+        default: {
+            const qint64 c = variantCompare(left, right, cs, isLocaleAware);
+            return c < 0 ? -1 : (c > 0 ? 1 : 0);
+        }
+    }
+}
+
 int QQuickWiFiSortFilterModelPrivate::fuzzyCompare(float left, float right)
 {
     return qFuzzyCompare(left, right) ? 0 : (left < right ? -1 : 1);
@@ -102,16 +212,23 @@ qint64 QQuickWiFiSortFilterModelPrivate::variantCompare(
 
 
 QQuickWiFiSortFilterModel::QQuickWiFiSortFilterModel(QObject *parent)
-    : QSortFilterProxyModel(parent)
+    : QAbstractProxyModel(parent)
     , d_ptr(new QQuickWiFiSortFilterModelPrivate(this))
     , m_complete(false)
 {
-    connect(this, &QSortFilterProxyModel::rowsInserted, this,
+    connect(this, &QAbstractItemModel::rowsInserted, this,
+            &QQuickWiFiSortFilterModel::countChanged);
+    connect(this, &QAbstractItemModel::rowsRemoved, this,
             &QQuickWiFiSortFilterModel::countChanged);
-    connect(this, &QSortFilterProxyModel::rowsRemoved, this,
+    connect(this, &QAbstractItemModel::modelReset, this,
             &QQuickWiFiSortFilterModel::countChanged);
 }
 
+QQuickWiFiSortFilterModel::~QQuickWiFiSortFilterModel()
+{
+    delete d_ptr;
+}
+
 int QQuickWiFiSortFilterModel::count() const
 {
     return rowCount();
@@ -123,9 +240,22 @@ QObject *QQuickWiFiSortFilterModel::source() const
 }
 
 void QQuickWiFiSortFilterModel::setSource(QObject *source)
+{
+    setSourceModel(qobject_cast<QAbstractItemModel *>(source));
+}
+
+void QQuickWiFiSortFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
 {
     beginResetModel();
-    QSortFilterProxyModel::setSourceModel(qobject_cast<QAbstractItemModel *>(source));
+    if (QAbstractProxyModel::sourceModel()) {
+        disconnect(QAbstractProxyModel::sourceModel(), 0, this, 0);
+    }
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    connectSource();
+    if (m_complete) {
+        resolveRoles();
+    }
+    rebuildRows();
     endResetModel();
 }
 
@@ -139,14 +269,588 @@ void QQuickWiFiSortFilterModel::setSortRole(const QByteArray &role)
     if (m_sortRole != role) {
         m_sortRole = role;
         if (m_complete) {
-            QSortFilterProxyModel::setSortRole(roleKey(role));
+            resolveRoles();
+            invalidate();
         }
     }
 }
 
+int QQuickWiFiSortFilterModel::sortColumn() const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_sortColumn;
+}
+
+Qt::SortOrder QQuickWiFiSortFilterModel::sortOrder() const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_sortOrder;
+}
+
 void QQuickWiFiSortFilterModel::setSortOrder(Qt::SortOrder order)
 {
-    QSortFilterProxyModel::sort(0, order);
+    sort(0, order);
+}
+
+/* \a column 小于 0 时保持源模型的顺序 */
+void QQuickWiFiSortFilterModel::sort(int column, Qt::SortOrder order)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+    d->m_sortColumn = column;
+    d->m_sortOrder = order;
+    sortRows();
+}
+
+Qt::CaseSensitivity QQuickWiFiSortFilterModel::sortCaseSensitivity() const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_sortCaseSensitivity;
+}
+
+void QQuickWiFiSortFilterModel::setSortCaseSensitivity(Qt::CaseSensitivity cs)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+    if (d->m_sortCaseSensitivity != cs) {
+        d->m_sortCaseSensitivity = cs;
+        sortRows();
+    }
+}
+
+bool QQuickWiFiSortFilterModel::isSortLocaleAware() const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_sortLocaleAware;
+}
+
+void QQuickWiFiSortFilterModel::setSortLocaleAware(bool on)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+    if (d->m_sortLocaleAware != on) {
+        d->m_sortLocaleAware = on;
+        sortRows();
+    }
+}
+
+bool QQuickWiFiSortFilterModel::incrementalSort() const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_incrementalSort;
+}
+
+/*
+ * 增量排序：dataChanged 后不再整体重排并发出 layoutChanged ，
+ * 只把位置不再正确的行按二分查找移动到正确位置。
+ */
+void QQuickWiFiSortFilterModel::setIncrementalSort(bool incremental)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+    d->m_incrementalSort = incremental;
+}
+
+int QQuickWiFiSortFilterModel::sortHysteresis() const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_sortHysteresis;
+}
+
+/*
+ * 增量排序时，数值排序键与相邻行的差不超过 \a hysteresis 不移动该行，
+ * 例如设为 2 可以避免信号强度 ±1~2 dBm 的抖动导致相邻两行来回交换。
+ */
+void QQuickWiFiSortFilterModel::setSortHysteresis(int hysteresis)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+    d->m_sortHysteresis = qMax(0, hysteresis);
+}
+
+void QQuickWiFiSortFilterModel::connectSource()
+{
+    QAbstractItemModel *model = sourceModel();
+    if (!model) {
+        return;
+    }
+    connect(model, &QAbstractItemModel::dataChanged,
+            this, &QQuickWiFiSortFilterModel::onSourceDataChanged);
+    connect(model, &QAbstractItemModel::rowsInserted,
+            this, &QQuickWiFiSortFilterModel::onSourceRowsInserted);
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved,
+            this, &QQuickWiFiSortFilterModel::onSourceRowsAboutToBeRemoved);
+    connect(model, &QAbstractItemModel::rowsRemoved,
+            this, &QQuickWiFiSortFilterModel::onSourceRowsRemoved);
+    connect(model, &QAbstractItemModel::rowsMoved,
+            this, &QQuickWiFiSortFilterModel::onSourceRowsMoved);
+    connect(model, &QAbstractItemModel::destroyed,
+            this, &QQuickWiFiSortFilterModel::onSourceDestroyed);
+
+    /* 源模型整体变化时重建映射 */
+    connect(model, &QAbstractItemModel::modelAboutToBeReset,
+            this, &QQuickWiFiSortFilterModel::onSourceAboutToBeReset);
+    connect(model, &QAbstractItemModel::modelReset,
+            this, &QQuickWiFiSortFilterModel::onSourceReset);
+    connect(model, &QAbstractItemModel::layoutAboutToBeChanged,
+            this, &QQuickWiFiSortFilterModel::onSourceAboutToBeReset);
+    connect(model, &QAbstractItemModel::layoutChanged,
+            this, &QQuickWiFiSortFilterModel::onSourceReset);
+    connect(model, &QAbstractItemModel::columnsAboutToBeInserted,
+            this, &QQuickWiFiSortFilterModel::onSourceAboutToBeReset);
+    connect(model, &QAbstractItemModel::columnsInserted,
+            this, &QQuickWiFiSortFilterModel::onSourceReset);
+    connect(model, &QAbstractItemModel::columnsAboutToBeRemoved,
+            this, &QQuickWiFiSortFilterModel::onSourceAboutToBeReset);
+    connect(model, &QAbstractItemModel::columnsRemoved,
+            this, &QQuickWiFiSortFilterModel::onSourceReset);
+}
+
+/* 不发出信号，调用者负责 beginResetModel/endResetModel */
+void QQuickWiFiSortFilterModel::rebuildRows()
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    d->m_proxyToSource.clear();
+    d->m_sourceToProxy.clear();
+    QAbstractItemModel *model = sourceModel();
+    if (!model) {
+        return;
+    }
+    const int rows = model->rowCount();
+    d->m_sourceToProxy.fill(-1, rows);
+    d->m_proxyToSource.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        if (filterAcceptsRow(row, QModelIndex())) {
+            d->m_proxyToSource.append(row);
+        }
+    }
+    std::stable_sort(d->m_proxyToSource.begin(), d->m_proxyToSource.end(),
+    [this](int left, int right) {
+        return rowLessThan(left, right);
+    });
+    d->updateSourceToProxy(0);
+}
+
+/* 整体重新排序，与 QSortFilterProxyModel 一样以 layoutChanged 通知视图 */
+void QQuickWiFiSortFilterModel::sortRows()
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    if (d->m_proxyToSource.size() < 2) {
+        return;
+    }
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(),
+                                QAbstractItemModel::VerticalSortHint);
+    const QModelIndexList from = persistentIndexList();
+    QVector<int> sourceRows;
+    sourceRows.reserve(from.size());
+    for (const QModelIndex &index : from) {
+        sourceRows.append(d->m_proxyToSource.at(index.row()));
+    }
+
+    std::stable_sort(d->m_proxyToSource.begin(), d->m_proxyToSource.end(),
+    [this](int left, int right) {
+        return rowLessThan(left, right);
+    });
+    d->updateSourceToProxy(0);
+
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (int i = 0; i < from.size(); ++i) {
+        to.append(index(d->m_sourceToProxy.at(sourceRows.at(i)), from.at(i).column()));
+    }
+    changePersistentIndexList(from, to);
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+}
+
+/* 只对过滤结果变化的行发出 rowsRemoved/rowsInserted */
+void QQuickWiFiSortFilterModel::invalidateFilter()
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    for (int row = d->m_proxyToSource.size() - 1; row >= 0; --row) {
+        if (!filterAcceptsRow(d->m_proxyToSource.at(row), QModelIndex())) {
+            removeProxyRow(row);
+        }
+    }
+    for (int row = 0; row < d->m_sourceToProxy.size(); ++row) {
+        if (d->m_sourceToProxy.at(row) < 0 && filterAcceptsRow(row, QModelIndex())) {
+            insertSourceRow(row);
+        }
+    }
+}
+
+void QQuickWiFiSortFilterModel::invalidate()
+{
+    invalidateFilter();
+    sortRows();
+}
+
+void QQuickWiFiSortFilterModel::insertSourceRow(int sourceRow)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    const auto it = std::upper_bound(d->m_proxyToSource.cbegin(), d->m_proxyToSource.cend(),
+                                     sourceRow, [this](int left, int right) {
+        return rowLessThan(left, right);
+    });
+    const int row = int(it - d->m_proxyToSource.cbegin());
+    beginInsertRows(QModelIndex(), row, row);
+    d->m_proxyToSource.insert(row, sourceRow);
+    d->updateSourceToProxy(row);
+    endInsertRows();
+}
+
+void QQuickWiFiSortFilterModel::removeProxyRow(int proxyRow)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    beginRemoveRows(QModelIndex(), proxyRow, proxyRow);
+    d->m_sourceToProxy[d->m_proxyToSource.takeAt(proxyRow)] = -1;
+    d->updateSourceToProxy(proxyRow);
+    endRemoveRows();
+}
+
+/*
+ * 把 \a sourceRows 逐个移动到其余行之间的正确位置。其余行的相对顺序不变，
+ * 每一行的目标位置在已就位的行中二分查找。返回是否移动过任何行。
+ */
+bool QQuickWiFiSortFilterModel::moveSourceRows(const QVector<int> &sourceRows)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    QVector<int> settled;
+    settled.reserve(d->m_proxyToSource.size());
+    for (int sourceRow : qAsConst(d->m_proxyToSource)) {
+        if (!sourceRows.contains(sourceRow)) {
+            settled.append(sourceRow);
+        }
+    }
+
+    bool moved = false;
+    for (int sourceRow : sourceRows) {
+        const auto it = std::upper_bound(settled.begin(), settled.end(), sourceRow,
+        [this](int left, int right) {
+            return rowLessThan(left, right);
+        });
+        const int from = d->m_sourceToProxy.at(sourceRow);
+        const int to = (it == settled.end()) ? d->m_proxyToSource.size()
+                       : d->m_sourceToProxy.at(*it);
+        settled.insert(it, sourceRow);
+        if (to == from || to == from + 1) {
+            continue;
+        }
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
+        d->m_proxyToSource.remove(from);
+        d->m_proxyToSource.insert(to > from ? to - 1 : to, sourceRow);
+        d->updateSourceToProxy(qMin(from, to));
+        endMoveRows();
+        moved = true;
+    }
+    return moved;
+}
+
+/*
+ * 排序键变化的行只与相邻行比较，顺序不符时才移动；未启用增量排序时
+ * 整体重新排序。过滤结果变化的行被移除或按二分查找插入。
+ */
+void QQuickWiFiSortFilterModel::onSourceDataChanged(const QModelIndex &topLeft,
+        const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    if (topLeft.parent().isValid()) {
+        return;
+    }
+
+    bool sortAffected = roles.isEmpty();
+    for (const QQuickWiFiSortFilterModelPrivate::SortKey &key : qAsConst(d->m_sortKeys)) {
+        sortAffected = sortAffected || roles.contains(key.role);
+    }
+    bool filterAffected = false;
+    if (!d->m_filterString.isEmpty()) {
+        filterAffected = roles.isEmpty();
+        for (int role : qAsConst(d->m_filterRoles)) {
+            filterAffected = filterAffected || roles.contains(role);
+        }
+    }
+
+    QVector<int> changed;
+    QVector<int> accepted;
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const bool shown = d->m_sourceToProxy.at(row) >= 0;
+        const bool accept = !filterAffected || filterAcceptsRow(row, QModelIndex());
+        if (shown && !accept) {
+            removeProxyRow(d->m_sourceToProxy.at(row));
+        } else if (shown) {
+            changed.append(row);
+        } else if (accept) {
+            accepted.append(row);
+        }
+    }
+
+    if (sortAffected && d->m_sortColumn >= 0 && !d->m_sortKeys.isEmpty()) {
+        const int hysteresis = d->m_incrementalSort ? d->m_sortHysteresis : 0;
+        /* 移动一行后相邻关系改变，重复检查直到所有变化的行都与相邻行顺序一致 */
+        for (int pass = 0; pass <= changed.size(); ++pass) {
+            QVector<int> outOfOrder;
+            for (int row : qAsConst(changed)) {
+                if (isOutOfOrder(d->m_sourceToProxy.at(row), hysteresis)) {
+                    outOfOrder.append(row);
+                }
+            }
+            if (outOfOrder.isEmpty()) {
+                break;
+            }
+            if (!d->m_incrementalSort) {
+                sortRows();
+                break;
+            }
+            if (!moveSourceRows(outOfOrder)) {
+                break;
+            }
+        }
+    }
+
+    for (int row : qAsConst(changed)) {
+        const int proxyRow = d->m_sourceToProxy.at(row);
+        emit dataChanged(index(proxyRow, topLeft.column()),
+                         index(proxyRow, bottomRight.column()), roles);
+    }
+    for (int row : qAsConst(accepted)) {
+        insertSourceRow(row);
+    }
+}
+
+void QQuickWiFiSortFilterModel::onSourceRowsInserted(const QModelIndex &parent,
+        int start, int end)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    if (parent.isValid()) {
+        return;
+    }
+    const int count = end - start + 1;
+    for (int &sourceRow : d->m_proxyToSource) {
+        if (sourceRow >= start) {
+            sourceRow += count;
+        }
+    }
+    d->m_sourceToProxy.insert(start, count, -1);
+    d->updateSourceToProxy(0);
+    for (int row = start; row <= end; ++row) {
+        if (filterAcceptsRow(row, QModelIndex())) {
+            insertSourceRow(row);
+        }
+    }
+}
+
+void QQuickWiFiSortFilterModel::onSourceRowsAboutToBeRemoved(const QModelIndex &parent,
+        int start, int end)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    if (parent.isValid()) {
+        return;
+    }
+    QVector<int> proxyRows;
+    for (int row = start; row <= end; ++row) {
+        if (d->m_sourceToProxy.at(row) >= 0) {
+            proxyRows.append(d->m_sourceToProxy.at(row));
+        }
+    }
+    std::sort(proxyRows.begin(), proxyRows.end(), std::greater<int>());
+    for (int proxyRow : qAsConst(proxyRows)) {
+        removeProxyRow(proxyRow);
+    }
+}
+
+void QQuickWiFiSortFilterModel::onSourceRowsRemoved(const QModelIndex &parent,
+        int start, int end)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    if (parent.isValid()) {
+        return;
+    }
+    const int count = end - start + 1;
+    for (int &sourceRow : d->m_proxyToSource) {
+        if (sourceRow > end) {
+            sourceRow -= count;
+        }
+    }
+    d->m_sourceToProxy.remove(start, count);
+}
+
+/*
+ * 源行移动只改变源行号，代理行的顺序由排序键决定，映射原地更新即可；
+ * 只有排序键相同或不排序的行依赖源行号，顺序不符时再逐行移动。
+ */
+void QQuickWiFiSortFilterModel::onSourceRowsMoved(const QModelIndex &parent, int start, int end,
+        const QModelIndex &destination, int row)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    if (parent.isValid() || destination.isValid()) {
+        return;
+    }
+    const int count = end - start + 1;
+    for (int &sourceRow : d->m_proxyToSource) {
+        if (row > end) {
+            if (sourceRow >= start && sourceRow <= end) {
+                sourceRow += row - end - 1;
+            } else if (sourceRow > end && sourceRow < row) {
+                sourceRow -= count;
+            }
+        } else if (row < start) {
+            if (sourceRow >= start && sourceRow <= end) {
+                sourceRow -= start - row;
+            } else if (sourceRow >= row && sourceRow < start) {
+                sourceRow += count;
+            }
+        }
+    }
+    d->m_sourceToProxy.fill(-1);
+    d->updateSourceToProxy(0);
+    restoreOrder();
+}
+
+/*
+ * 保留按 rowLessThan 有序的最长子序列，只移动其余的行，
+ * 移动次数最少且不发出 layoutChanged 。
+ */
+void QQuickWiFiSortFilterModel::restoreOrder()
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    const QVector<int> rows = d->m_proxyToSource;
+    QVector<int> tails;     // 各长度有序子序列的末尾(rows 下标)
+    QVector<int> previous(rows.size(), -1);
+    for (int i = 0; i < rows.size(); ++i) {
+        const auto it = std::lower_bound(tails.begin(), tails.end(), i,
+        [this, &rows](int left, int right) {
+            return rowLessThan(rows.at(left), rows.at(right));
+        });
+        if (it != tails.begin()) {
+            previous[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.append(i);
+        } else {
+            *it = i;
+        }
+    }
+    if (tails.size() == rows.size()) {
+        return;
+    }
+
+    QVector<bool> ordered(rows.size(), false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = previous.at(i)) {
+        ordered[i] = true;
+    }
+    QVector<int> outOfOrder;
+    for (int i = 0; i < rows.size(); ++i) {
+        if (!ordered.at(i)) {
+            outOfOrder.append(rows.at(i));
+        }
+    }
+    moveSourceRows(outOfOrder);
+}
+
+void QQuickWiFiSortFilterModel::onSourceAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void QQuickWiFiSortFilterModel::onSourceReset()
+{
+    rebuildRows();
+    endResetModel();
+}
+
+void QQuickWiFiSortFilterModel::onSourceDestroyed()
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    beginResetModel();
+    d->m_proxyToSource.clear();
+    d->m_sourceToProxy.clear();
+    endResetModel();
+}
+
+bool QQuickWiFiSortFilterModel::isOutOfOrder(int proxyRow, int hysteresis) const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+
+    const int sign = (d->m_sortOrder == Qt::AscendingOrder) ? 1 : -1;
+    const QModelIndex current = mapToSource(index(proxyRow, 0));
+    if (proxyRow > 0) {
+        const QModelIndex previous = mapToSource(index(proxyRow - 1, 0));
+        if (sign * compareRows(current, previous, hysteresis) < 0) {
+            return true;
+        }
+    }
+    if (proxyRow + 1 < rowCount()) {
+        const QModelIndex next = mapToSource(index(proxyRow + 1, 0));
+        if (sign * compareRows(next, current, hysteresis) < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QModelIndex QQuickWiFiSortFilterModel::index(int row, int column,
+        const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= rowCount()
+        || column < 0 || column >= columnCount()) {
+        return QModelIndex();
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex QQuickWiFiSortFilterModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child)
+    return QModelIndex();
+}
+
+int QQuickWiFiSortFilterModel::rowCount(const QModelIndex &parent) const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return parent.isValid() ? 0 : d->m_proxyToSource.size();
+}
+
+int QQuickWiFiSortFilterModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel()) {
+        return 0;
+    }
+    return sourceModel()->columnCount();
+}
+
+bool QQuickWiFiSortFilterModel::hasChildren(const QModelIndex &parent) const
+{
+    return !parent.isValid() && rowCount() > 0 && columnCount() > 0;
+}
+
+QModelIndex QQuickWiFiSortFilterModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+
+    if (!proxyIndex.isValid() || !sourceModel()
+        || proxyIndex.row() >= d->m_proxyToSource.size()) {
+        return QModelIndex();
+    }
+    return sourceModel()->index(d->m_proxyToSource.at(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex QQuickWiFiSortFilterModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+
+    if (!sourceIndex.isValid() || sourceIndex.parent().isValid()
+        || sourceIndex.row() >= d->m_sourceToProxy.size()) {
+        return QModelIndex();
+    }
+    const int row = d->m_sourceToProxy.at(sourceIndex.row());
+    return row < 0 ? QModelIndex() : createIndex(row, sourceIndex.column());
 }
 
 QByteArray QQuickWiFiSortFilterModel::filterRole() const
@@ -159,34 +863,98 @@ void QQuickWiFiSortFilterModel::setFilterRole(const QByteArray &role)
     if (m_filterRole != role) {
         m_filterRole = role;
         if (m_complete) {
-            QSortFilterProxyModel::setFilterRole(roleKey(role));
+            resolveRoles();
+            invalidateFilter();
         }
     }
 }
 
 QString QQuickWiFiSortFilterModel::filterString() const
 {
-    return filterRegExp().pattern();
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_filterString;
 }
 
 void QQuickWiFiSortFilterModel::setFilterString(const QString &filter)
 {
-    setFilterRegExp(QRegExp(filter, filterCaseSensitivity(),
-                            static_cast<QRegExp::PatternSyntax>(filterSyntax())));
+    Q_D(QQuickWiFiSortFilterModel);
+    if (d->m_filterString != filter) {
+        d->m_filterString = filter;
+        compileFilter();
+    }
 }
 
 QQuickWiFiSortFilterModel::FilterSyntax
 QQuickWiFiSortFilterModel::filterSyntax() const
 {
-    return static_cast<FilterSyntax>(filterRegExp().patternSyntax());
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_filterSyntax;
 }
 
 void QQuickWiFiSortFilterModel::setFilterSyntax(
                 QQuickWiFiSortFilterModel::FilterSyntax
                 syntax)
 {
-    setFilterRegExp(QRegExp(filterString(), filterCaseSensitivity(),
-                            static_cast<QRegExp::PatternSyntax>(syntax)));
+    Q_D(QQuickWiFiSortFilterModel);
+    if (d->m_filterSyntax != syntax) {
+        d->m_filterSyntax = syntax;
+        compileFilter();
+    }
+}
+
+Qt::CaseSensitivity QQuickWiFiSortFilterModel::filterCaseSensitivity() const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
+    return d->m_filterCaseSensitivity;
+}
+
+void QQuickWiFiSortFilterModel::setFilterCaseSensitivity(Qt::CaseSensitivity cs)
+{
+    Q_D(QQuickWiFiSortFilterModel);
+    if (d->m_filterCaseSensitivity != cs) {
+        d->m_filterCaseSensitivity = cs;
+        compileFilter();
+    }
+}
+
+/*
+ * 过滤表达式只在字符串或语法变化时编译一次。
+ * Wildcard 与 QRegExp 一致：* 匹配任意字符串，? 匹配单个字符，不锚定首尾。
+ */
+void QQuickWiFiSortFilterModel::compileFilter()
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    QString pattern;
+    switch (d->m_filterSyntax) {
+        case Wildcard:
+            pattern.reserve(d->m_filterString.size() * 2);
+            for (const QChar c : qAsConst(d->m_filterString)) {
+                if (c == QLatin1Char('*')) {
+                    pattern += QLatin1String(".*");
+                } else if (c == QLatin1Char('?')) {
+                    pattern += QLatin1Char('.');
+                } else {
+                    pattern += QRegularExpression::escape(QString(c));
+                }
+            }
+            break;
+        case FixedString:
+            pattern = QRegularExpression::escape(d->m_filterString);
+            break;
+        case RegExp:
+        default:
+            pattern = d->m_filterString;
+            break;
+    }
+
+    QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+    if (d->m_filterCaseSensitivity == Qt::CaseInsensitive) {
+        options |= QRegularExpression::CaseInsensitiveOption;
+    }
+    d->m_filterExpression = QRegularExpression(pattern, options);
+    d->m_filterExpression.optimize();
+    invalidateFilter();
 }
 
 QJSValue QQuickWiFiSortFilterModel::get(int idx) const
@@ -212,11 +980,41 @@ void QQuickWiFiSortFilterModel::classBegin()
 void QQuickWiFiSortFilterModel::componentComplete()
 {
     m_complete = true;
-    if (!m_sortRole.isEmpty()) {
-        QSortFilterProxyModel::setSortRole(roleKey(m_sortRole));
+    beginResetModel();
+    resolveRoles();
+    rebuildRows();
+    endResetModel();
+}
+
+/*
+ * 把 sortRole(以逗号分隔的多个角色)与 filterRole 解析为角色 ID ，
+ * 只在角色或源模型变化时执行，排序与过滤过程中不再查找角色名称。
+ */
+void QQuickWiFiSortFilterModel::resolveRoles()
+{
+    Q_D(QQuickWiFiSortFilterModel);
+
+    const QHash<int, QByteArray> roles = roleNames();
+
+    d->m_sortKeys.clear();
+    const QList<QByteArray> sortRoles = m_sortRole.split(',');
+    for (const QByteArray &name : sortRoles) {
+        const int role = roles.key(name.trimmed(), -1);
+        if (role >= 0) {
+            d->m_sortKeys.append({ role, QQuickWiFiSortFilterModelPrivate::UnresolvedCompare });
+        }
     }
-    if (!m_filterRole.isEmpty()) {
-        QSortFilterProxyModel::setFilterRole(roleKey(m_filterRole));
+
+    d->m_filterRoles.clear();
+    if (m_filterRole.isEmpty()) {
+        for (auto it = roles.cbegin(); it != roles.cend(); ++it) {
+            d->m_filterRoles.append(it.key());
+        }
+    } else {
+        const int role = roles.key(m_filterRole, -1);
+        if (role >= 0) {
+            d->m_filterRoles.append(role);
+        }
     }
 }
 
@@ -244,94 +1042,67 @@ QHash<int, QByteArray> QQuickWiFiSortFilterModel::roleNames() const
 bool QQuickWiFiSortFilterModel::filterAcceptsRow(int sourceRow,
         const QModelIndex &sourceParent) const
 {
-    QRegExp rx = filterRegExp();
-    if (rx.isEmpty()) {
+    Q_D(const QQuickWiFiSortFilterModel);
+
+    if (d->m_filterString.isEmpty()) {
         return true;
     }
     QAbstractItemModel *model = sourceModel();
-    if (filterRole().isEmpty()) {
-        QHash<int, QByteArray> roles = roleNames();
-        QHashIterator<int, QByteArray> it(roles);
-        while (it.hasNext()) {
-            it.next();
-            QModelIndex sourceIndex = model->index(sourceRow, 0, sourceParent);
-            QString key = model->data(sourceIndex, it.key()).toString();
-            if (key.contains(rx)) {
-                return true;
-            }
-        }
-        return false;
-    }
     QModelIndex sourceIndex = model->index(sourceRow, 0, sourceParent);
     if (!sourceIndex.isValid()) {
         return true;
     }
-    QString key = model->data(sourceIndex, roleKey(filterRole())).toString();
-    return key.contains(rx);
+    for (int role : d->m_filterRoles) {
+        if (model->data(sourceIndex, role).toString().contains(d->m_filterExpression)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-//From QSortFilterProxyModel
-bool QQuickWiFiSortFilterModel::lessThan(const QModelIndex &source_left,
-        const QModelIndex &source_right) const
+/* 排序键相同的行保持源模型中的先后顺序 */
+bool QQuickWiFiSortFilterModel::rowLessThan(int sourceLeft, int sourceRight) const
 {
-    QList<QByteArray> sortRoles = m_sortRole.split(',');
+    Q_D(const QQuickWiFiSortFilterModel);
 
-    if(sortRoles.isEmpty()) {
-        return source_left.row() < source_right.row();
+    if (d->m_sortColumn < 0 || d->m_sortKeys.isEmpty()) {
+        return sourceLeft < sourceRight;
     }
-
-    for(const QByteArray &name : sortRoles) {
-        int role = roleNames().key(name);
-        QVariant l = (source_left.model() ? source_left.model()->data(source_left,
-                      role) : QVariant());
-        QVariant r = (source_right.model() ? source_right.model()->data(source_right,
-                      role) : QVariant());
-        qint64 compare = QQuickWiFiSortFilterModelPrivate::variantCompare(l, r,
-                         sortCaseSensitivity(), isSortLocaleAware());
-        if(compare < 0) {
-            return true;
-        } else if(compare > 0) {
-            return false;
-        }
+    QAbstractItemModel *model = sourceModel();
+    int compare = compareRows(model->index(sourceLeft, 0), model->index(sourceRight, 0), 0);
+    if (d->m_sortOrder == Qt::DescendingOrder) {
+        compare = -compare;
     }
-    return false;
+    return compare != 0 ? compare < 0 : sourceLeft < sourceRight;
 }
 
+int QQuickWiFiSortFilterModel::compareRows(const QModelIndex &source_left,
+        const QModelIndex &source_right, int hysteresis) const
+{
+    Q_D(const QQuickWiFiSortFilterModel);
 
-//void QQuickWiFiSortFilterModel::_q_sourceRowsAboutToBeInserted(const QModelIndex &parent, int start, int end)
-//{
-//    Q_ASSERT(parent.isValid() ? parent.model() == sourceModel() : true);
-//    beginInsertRows(mapFromSource(parent), start, end);
-//}
-
-//void QQuickWiFiSortFilterModel::_q_sourceRowsInserted(const QModelIndex &parent, int start, int end)
-//{
-//    Q_ASSERT(parent.isValid() ? parent.model() == sourceModel() : true);
-//    Q_UNUSED(parent)
-//    Q_UNUSED(start)
-//    Q_UNUSED(end)
-//    endInsertRows();
-//}
-
-//void QQuickWiFiSortFilterModel::_q_sourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
-//{
-//    Q_ASSERT(parent.isValid() ? parent.model() == sourceModel() : true);
-//    beginRemoveRows(mapFromSource(parent), start, end);
-//}
-
-//void QQuickWiFiSortFilterModel::_q_sourceRowsRemoved(const QModelIndex &parent, int start, int end)
-//{
-//    Q_ASSERT(parent.isValid() ? parent.model() == sourceModel() : true);
-//    Q_UNUSED(parent)
-//    Q_UNUSED(start)
-//    Q_UNUSED(end)
-//    endRemoveRows();
-//}
-
-//void QQuickWiFiSortFilterModel::_q_sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
-//{
-//    Q_ASSERT(topLeft.isValid() ? topLeft.model() == sourceModel() : true);
-//    Q_ASSERT(bottomRight.isValid() ? bottomRight.model() == sourceModel() : true);
-//    dataChanged(mapFromSource(topLeft), mapFromSource(bottomRight), roles);
-//}
+    const QAbstractItemModel *model = source_left.model();
+    if (!model) {
+        return 0;
+    }
 
+    const Qt::CaseSensitivity cs = d->m_sortCaseSensitivity;
+    const bool localeAware = d->m_sortLocaleAware;
+    for (QQuickWiFiSortFilterModelPrivate::SortKey &key : d->m_sortKeys) {
+        const QVariant l = model->data(source_left, key.role);
+        const QVariant r = model->data(source_right, key.role);
+        if (key.kind == QQuickWiFiSortFilterModelPrivate::UnresolvedCompare && l.isValid()) {
+            key.kind = QQuickWiFiSortFilterModelPrivate::compareKind(l.userType());
+        }
+        const int compare = QQuickWiFiSortFilterModelPrivate::compare(key.kind, l, r,
+                            cs, localeAware, hysteresis);
+        if (compare != 0) {
+            return compare;
+        }
+        /* 在回差范围内的差异不再由后续排序键决定先后 */
+        if (hysteresis > 0 && l != r) {
+            return 0;
+        }
+    }
+    return 0;
+}
@@ -20,12 +20,17 @@
 #define QQUICKWIFISORTFILTERMODEL_P_H
 
 #include <QtQml/qqml.h>
-#include <QtCore/qsortfilterproxymodel.h>
+#include <QtCore/qabstractproxymodel.h>
 #include <QtQml/qqmlparserstatus.h>
 #include <QtQml/qjsvalue.h>
 
+/*
+ * 一维列表模型的排序过滤代理。代理行到源行的映射自行维护：
+ * 新增的行按二分查找插入，排序键变化的行以 beginMoveRows/endMoveRows 移动，
+ * 视图不会因为单行变化而收到整个列表的 layoutChanged 。
+ */
 class QQuickWiFiSortFilterModelPrivate;
-class QQuickWiFiSortFilterModel : public QSortFilterProxyModel,
+class QQuickWiFiSortFilterModel : public QAbstractProxyModel,
     public QQmlParserStatus
 {
     Q_OBJECT
@@ -36,24 +41,47 @@ class QQuickWiFiSortFilterModel : public QSortFilterProxyModel,
 
     Q_PROPERTY(QByteArray sortRole READ sortRole WRITE setSortRole)
     Q_PROPERTY(Qt::SortOrder sortOrder READ sortOrder WRITE setSortOrder)
+    Q_PROPERTY(Qt::CaseSensitivity sortCaseSensitivity READ sortCaseSensitivity
+               WRITE setSortCaseSensitivity)
+    Q_PROPERTY(bool isSortLocaleAware READ isSortLocaleAware WRITE setSortLocaleAware)
+    Q_PROPERTY(bool incrementalSort READ incrementalSort WRITE setIncrementalSort)
+    Q_PROPERTY(int sortHysteresis READ sortHysteresis WRITE setSortHysteresis)
 
     Q_PROPERTY(QByteArray filterRole READ filterRole WRITE setFilterRole)
     Q_PROPERTY(QString filterString READ filterString WRITE setFilterString)
     Q_PROPERTY(FilterSyntax filterSyntax READ filterSyntax WRITE setFilterSyntax)
+    Q_PROPERTY(Qt::CaseSensitivity filterCaseSensitivity READ filterCaseSensitivity
+               WRITE setFilterCaseSensitivity)
 
     Q_ENUMS(FilterSyntax)
 
 public:
     explicit QQuickWiFiSortFilterModel(QObject *parent = 0);
+    ~QQuickWiFiSortFilterModel();
 
     QObject *source() const;
     void setSource(QObject *source);
+    void setSourceModel(QAbstractItemModel *sourceModel) Q_DECL_OVERRIDE;
 
     QByteArray sortRole() const;
     void setSortRole(const QByteArray &role);
 
+    int sortColumn() const;
+    Qt::SortOrder sortOrder() const;
     void setSortOrder(Qt::SortOrder order);
 
+    Qt::CaseSensitivity sortCaseSensitivity() const;
+    void setSortCaseSensitivity(Qt::CaseSensitivity cs);
+
+    bool isSortLocaleAware() const;
+    void setSortLocaleAware(bool on);
+
+    bool incrementalSort() const;
+    void setIncrementalSort(bool incremental);
+
+    int sortHysteresis() const;
+    void setSortHysteresis(int hysteresis);
+
     QByteArray filterRole() const;
     void setFilterRole(const QByteArray &role);
 
@@ -69,30 +97,62 @@ public:
     FilterSyntax filterSyntax() const;
     void setFilterSyntax(FilterSyntax syntax);
 
+    Qt::CaseSensitivity filterCaseSensitivity() const;
+    void setFilterCaseSensitivity(Qt::CaseSensitivity cs);
+
     int count() const;
     Q_INVOKABLE QJSValue get(int index) const;
 
     void classBegin();
     void componentComplete();
 
+    //From QAbstractProxyModel
+    QModelIndex index(int row, int column,
+                      const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    QModelIndex parent(const QModelIndex &child) const Q_DECL_OVERRIDE;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const Q_DECL_OVERRIDE;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const Q_DECL_OVERRIDE;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) Q_DECL_OVERRIDE;
+
+public slots:
+    void invalidate();
+
 signals:
     void countChanged();
 
 protected:
     int roleKey(const QByteArray &role) const;
+    void resolveRoles();
+    void compileFilter();
+    void connectSource();
+    void invalidateFilter();
+    void sortRows();
+    void rebuildRows();
+    void insertSourceRow(int sourceRow);
+    void removeProxyRow(int proxyRow);
+    bool moveSourceRows(const QVector<int> &sourceRows);
+    void restoreOrder();
+    int compareRows(const QModelIndex &source_left, const QModelIndex &source_right,
+                    int hysteresis) const;
+    bool rowLessThan(int sourceLeft, int sourceRight) const;
+    bool isOutOfOrder(int proxyRow, int hysteresis) const;
     QHash<int, QByteArray> roleNames() const;
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
 
-    //From QSortFilterProxyModel
-    bool lessThan(const QModelIndex &source_left,
-                  const QModelIndex &source_right) const Q_DECL_OVERRIDE;
-
-//private slots:
-//    void _q_sourceRowsAboutToBeInserted(const QModelIndex &parent, int start, int end);
-//    void _q_sourceRowsInserted(const QModelIndex &parent, int start, int end);
-//    void _q_sourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
-//    void _q_sourceRowsRemoved(const QModelIndex &parent, int start, int end);
-//    void _q_sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+private slots:
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                             const QVector<int> &roles);
+    void onSourceRowsInserted(const QModelIndex &parent, int start, int end);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+    void onSourceRowsRemoved(const QModelIndex &parent, int start, int end);
+    void onSourceRowsMoved(const QModelIndex &parent, int start, int end,
+                           const QModelIndex &destination, int row);
+    void onSourceAboutToBeReset();
+    void onSourceReset();
+    void onSourceDestroyed();
 
 protected:
     QQuickWiFiSortFilterModelPrivate *d_ptr;
@@ -12,10 +12,12 @@ load(qml_plugin)
 SOURCES = \
     wifiplugin.cpp \
     qquickwifimanager.cpp \
+    qquickwificonnectioninfo.cpp \
     qquickwifisortfiltermodel.cpp \
     qquickwifiscanresultmodel.cpp
 
 HEADERS = \
     qquickwifimanager_p.h \
+    qquickwificonnectioninfo_p.h \
     qquickwifisortfiltermodel_p.h \
     qquickwifiscanresultmodel_p.h
@@ -22,6 +22,7 @@
 #include <QtQml/qqmlcomponent.h>
 
 #include "qquickwifimanager_p.h"
+#include "qquickwificonnectioninfo_p.h"
 #include "qquickwifiscanresultmodel_p.h"
 #include "qquickwifisortfiltermodel_p.h"
 
@@ -47,6 +48,7 @@ public:
     {
         Q_ASSERT(QLatin1String(uri) == QLatin1String("WiFi"));
 
+        qRegisterMetaType<QQuickWiFiConnectionInfo>();
         qmlRegisterType<QQuickWiFiManager>(uri, 1, 0, "WiFiManager");
         qmlRegisterType<QQuickWiFiScanResultModel>(uri, 1, 0, "WiFiScanResultModel");
         qmlRegisterType<QQuickWiFiSortFilterModel>(uri, 1, 0, "WiFiSortFilterModel");
@@ -19,7 +19,9 @@ win32 {
     DEFINES += CONFIG_CTRL_IFACE_UNIX
     SOURCES += $$PWD/../3rdparty/wpa_supplicant/src/utils/os_unix.c \
                $$PWD/../3rdparty/wpa_supplicant/src/utils/common.c \
-               $$PWD/../3rdparty/wpa_supplicant/src/common/wpa_ctrl.c
+               $$PWD/../3rdparty/wpa_supplicant/src/common/wpa_ctrl.c \
+               $$PWD/wifidhcpclient.cpp
+    HEADERS += $$PWD/wifidhcpclient_p.h
 }
 
 INCLUDEPATH += $$PWD/../3rdparty/wpa_supplicant/src \
@@ -40,8 +42,11 @@ HEADERS += \
     $$PWD/wifinativestub_p.h \
     $$PWD/wifiservice.h \
     $$PWD/wifisupplicantparser_p.h \
+    $$PWD/wifiscanresultstore_p.h \
     $$PWD/wifinativeproxy_p.h \
-    $$PWD/wifidbus_p.h
+    $$PWD/wifidbus_p.h \
+    $$PWD/wifinativetransport_p.h \
+    $$PWD/wifiactionrunner_p.h
 
 SOURCES += \
     $$PWD/wifimacaddress.cpp \
@@ -55,4 +60,8 @@ SOURCES += \
     $$PWD/wifinativestub.cpp \
     $$PWD/wifiservice.cpp \
     $$PWD/wifisupplicantparser.cpp \
-    $$PWD/wifinativeproxy.cpp
+    $$PWD/wifiscanresultstore.cpp \
+    $$PWD/wifinativeproxy.cpp \
+    $$PWD/wifidbus.cpp \
+    $$PWD/wifinativetransport.cpp \
+    $$PWD/wifiactionrunner.cpp
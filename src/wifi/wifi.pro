@@ -10,8 +10,13 @@ QT_PRIVATE += core-private gui-private qml-private quick-private
 
 DEFINES += QT_NO_CAST_TO_ASCII QT_NO_CAST_FROM_ASCII QT_NO_CAST_FROM_BYTEARRAY QT_NO_URL_CAST_FROM_STRING
 
-DBUS_ADAPTORS += wifi.native.station.xml
-DBUS_INTERFACES += wifi.native.station.xml
+# the station interface uses typed structs marshalled in wifidbus_p.h
+station_adaptor.files = wifi.native.station.xml
+station_adaptor.header_flags = -i wifidbus_p.h
+station_interface.files = wifi.native.station.xml
+station_interface.header_flags = -i wifidbus_p.h
+DBUS_ADAPTORS += station_adaptor
+DBUS_INTERFACES += station_interface
 DBUS_ADAPTORS += wifi.native.peers.xml
 DBUS_INTERFACES += wifi.native.peers.xml
 
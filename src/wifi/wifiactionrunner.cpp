@@ -0,0 +1,213 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "wifiactionrunner_p.h"
+
+#include <WiFi/wifiglobal.h>
+
+#include <QtCore/qtimer.h>
+#include <QtCore/qloggingcategory.h>
+
+// in a header
+Q_DECLARE_LOGGING_CATEGORY(logWPA)
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class WiFiActionRunner
+    \inmodule WiFi
+    \brief 类 WiFiActionRunner 按网络接口顺序异步执行外部动作脚本。
+*/
+
+WiFiActionRunner::WiFiActionRunner(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<WiFiActionRunner::Result>();
+}
+
+/* 正在执行的脚本随 QProcess 一起被终止，等待执行的动作直接丢弃。
+ */
+WiFiActionRunner::~WiFiActionRunner()
+{
+    for(auto it = m_queues.begin(); it != m_queues.end(); ++it) {
+        if(it->process) {
+            it->process->disconnect(this);
+        }
+    }
+}
+
+int WiFiActionRunner::timeout() const
+{
+    return m_timeout;
+}
+
+void WiFiActionRunner::setTimeout(int msecs)
+{
+    m_timeout = msecs;
+}
+
+int WiFiActionRunner::enqueue(const QString &key, const QString &program,
+                              const QStringList &arguments)
+{
+    Action action;
+    action.id = ++m_nextId;
+    action.program = program;
+    action.arguments = arguments;
+
+    Queue &queue = m_queues[key];
+    queue.actions.enqueue(action);
+    if(queue.process) {
+        qCDebug(logWPA, "[ DEBUG ] Action(%d) %s queued behind %d on %s.", action.id,
+                qUtf8Printable(program), queue.actions.size() - 1, qUtf8Printable(key));
+    } else {
+        this->startNext(key);
+    }
+    return action.id;
+}
+
+int WiFiActionRunner::pendingCount(const QString &key) const
+{
+    if(!key.isEmpty()) {
+        return m_queues.value(key).actions.size();
+    }
+    int count = 0;
+    for(const Queue &queue : m_queues) {
+        count += queue.actions.size();
+    }
+    return count;
+}
+
+void WiFiActionRunner::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    const QString key = this->keyOf(sender());
+    if(!m_queues.contains(key)) {
+        return;
+    }
+
+    Result result = Success;
+    if(m_queues[key].timedOut) {
+        result = TimedOut;
+    } else if(exitStatus == QProcess::CrashExit) {
+        result = Crashed;
+    } else if(exitCode != 0) {
+        result = Failed;
+    }
+    this->finish(key, result, exitCode);
+}
+
+void WiFiActionRunner::onErrorOccurred(QProcess::ProcessError error)
+{
+    // 其余错误随后还会有 finished 信号
+    if(error != QProcess::FailedToStart) {
+        return;
+    }
+    const QString key = this->keyOf(sender());
+    if(m_queues.contains(key)) {
+        this->finish(key, FailedToStart, -1);
+    }
+}
+
+void WiFiActionRunner::onTimeout()
+{
+    const QString key = this->keyOf(sender()->parent());
+    if(!m_queues.contains(key)) {
+        return;
+    }
+    Queue &queue = m_queues[key];
+    queue.timedOut = true;
+    queue.process->kill();
+}
+
+void WiFiActionRunner::startNext(const QString &key)
+{
+    Queue &queue = m_queues[key];
+    if(queue.process) {
+        // actionFinished 的接收者已经启动了下一个动作
+        return;
+    }
+    if(queue.actions.isEmpty()) {
+        m_queues.remove(key);
+        return;
+    }
+
+    const Action action = queue.actions.head();
+    QProcess *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(process, SIGNAL(finished(int, QProcess::ExitStatus)),
+            this, SLOT(onFinished(int, QProcess::ExitStatus)));
+    connect(process, SIGNAL(errorOccurred(QProcess::ProcessError)),
+            this, SLOT(onErrorOccurred(QProcess::ProcessError)));
+    QTimer *timer = NULL;
+    if(m_timeout > 0) {
+        timer = new QTimer(process);
+        timer->setSingleShot(true);
+        connect(timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+        timer->start(m_timeout);
+    }
+    queue.process = process;
+    queue.timer = timer;
+    queue.timedOut = false;
+    queue.elapsed.start();
+
+    // 接收者可能再次调用 enqueue ，此后不再访问 queue
+    Q_EMIT actionStarted(action.id, key);
+    process->start(action.program, action.arguments);
+}
+
+void WiFiActionRunner::finish(const QString &key, Result result, int exitCode)
+{
+    Queue &queue = m_queues[key];
+    const Action action = queue.actions.dequeue();
+    const qint64 elapsed = queue.elapsed.elapsed();
+    queue.process->disconnect(this);
+    if(queue.timer) {
+        queue.timer->stop();
+        queue.timer = NULL;
+    }
+    queue.process->deleteLater();
+    queue.process = NULL;
+
+    if(result == Success) {
+        qCInfo(logWPA, "[ OK ] Action(%d) %s %s done.%s", action.id,
+               qUtf8Printable(action.program),
+               qUtf8Printable(action.arguments.join(QLatin1Char(' '))),
+               wifiPrintTimes(elapsed));
+    } else {
+        qCWarning(logWPA, "[FAIL] Action(%d) %s %s result %d exit %d.%s", action.id,
+                  qUtf8Printable(action.program),
+                  qUtf8Printable(action.arguments.join(QLatin1Char(' '))),
+                  int(result), exitCode, wifiPrintTimes(elapsed));
+    }
+
+    Q_EMIT actionFinished(action.id, key, action.arguments, result, exitCode);
+    this->startNext(key);
+}
+
+QString WiFiActionRunner::keyOf(QObject *object) const
+{
+    for(auto it = m_queues.constBegin(); it != m_queues.constEnd(); ++it) {
+        if(it->process && it->process == object) {
+            return it.key();
+        }
+    }
+    return QString();
+}
+
+QT_END_NAMESPACE
+
+#include "moc_wifiactionrunner_p.cpp"
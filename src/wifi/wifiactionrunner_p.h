@@ -0,0 +1,100 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef WIFIACTIONRUNNER_P_H
+#define WIFIACTIONRUNNER_P_H
+
+#include <WiFi/private/wifiglobal_p.h>
+
+#include <QtCore/qobject.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qprocess.h>
+#include <QtCore/qelapsedtimer.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+/*
+ * 异步执行外部动作脚本(例如 WIFI_WPA_ACTION_DHCPD)，调用方不等待脚本结束。
+ * 同一 key (网络接口)的动作按提交顺序逐个执行，不同 key 之间互不等待；
+ * 超过 timeout() 毫秒仍未结束的脚本被终止，结果由 actionFinished 报告。
+ */
+class Q_WIFI_PRIVATE_EXPORT WiFiActionRunner : public QObject
+{
+    Q_OBJECT
+public:
+    enum Result {
+        Success,        // 退出码为 0
+        Failed,         // 退出码非 0
+        Crashed,
+        FailedToStart,
+        TimedOut
+    };
+    Q_ENUM(Result)
+
+    explicit WiFiActionRunner(QObject *parent = nullptr);
+    ~WiFiActionRunner();
+
+    /* 单个动作的时限(毫秒)，小于等于 0 表示不限时 */
+    int timeout() const;
+    void setTimeout(int msecs);
+
+    /* 将动作加入 key 的队列，返回动作编号，用于匹配 actionStarted/actionFinished 。 */
+    int enqueue(const QString &key, const QString &program, const QStringList &arguments);
+
+    /* key 为空时返回所有队列中正在执行和等待执行的动作数 */
+    int pendingCount(const QString &key = QString()) const;
+
+signals:
+    void actionStarted(int id, const QString &key);
+    void actionFinished(int id, const QString &key, const QStringList &arguments,
+                        WiFiActionRunner::Result result, int exitCode);
+
+private slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onErrorOccurred(QProcess::ProcessError error);
+    void onTimeout();
+
+private:
+    struct Action {
+        int id = 0;
+        QString program;
+        QStringList arguments;
+    };
+    struct Queue {
+        QQueue<Action> actions;     // 队首为正在执行的动作
+        QProcess *process = NULL;
+        QTimer *timer = NULL;       // 执行时限，随 process 一起删除
+        QElapsedTimer elapsed;
+        bool timedOut = false;
+    };
+
+    void startNext(const QString &key);
+    void finish(const QString &key, Result result, int exitCode);
+    QString keyOf(QObject *object) const;
+
+    int m_timeout = 10000;
+    int m_nextId = 0;
+    QHash<QString, Queue> m_queues;
+};
+
+QT_END_NAMESPACE
+
+#endif // WIFIACTIONRUNNER_P_H
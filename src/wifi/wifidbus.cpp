@@ -0,0 +1,312 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "wifidbus_p.h"
+
+#include <WiFi/wifimacaddress.h>
+
+#include <QtCore/qdir.h>
+#include <QtCore/qfileinfo.h>
+#include <QtDBus/qdbusmetatype.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace WiFiDBus
+{
+    void registerMetaTypes()
+    {
+        static bool initDone = false;
+        if (!initDone) {
+            qDBusRegisterMetaType<WiFiScanResult>();
+            qDBusRegisterMetaType<WiFiScanResultList>();
+            qDBusRegisterMetaType<WiFiInfo>();
+            qDBusRegisterMetaType<WiFiNetwork>();
+            qDBusRegisterMetaType<WiFiNetworkList>();
+            qDBusRegisterMetaType<WiFiStationChanges>();
+            initDone = true;
+        }
+    }
+
+    QString peerSocketPath()
+    {
+        const QString address = peerAddress();
+        const QString prefix = QStringLiteral("unix:path=");
+        if(!address.startsWith(prefix)) {
+            return QString();
+        }
+        QString path = address.mid(prefix.length());
+        int comma = path.indexOf(QLatin1Char(','));
+        if(comma >= 0) {
+            path.truncate(comma);
+        }
+        return path;
+    }
+
+    bool preparePeerSocket()
+    {
+        const QString path = peerSocketPath();
+        if(path.isEmpty()) {
+            return true;
+        }
+        const QString dir = QFileInfo(path).absolutePath();
+        if(!QDir().mkpath(dir)) {
+            return false;
+        }
+#ifdef Q_OS_UNIX
+        if(::chmod(QFile::encodeName(dir).constData(), 0755) != 0) {
+            return false;
+        }
+#endif
+        // 服务异常退出时遗留的套接字文件会使监听失败
+        QFile::remove(path);
+        return true;
+    }
+
+    bool isPeerTrusted()
+    {
+        const QString path = peerSocketPath();
+        if(path.isEmpty()) {
+            return true;
+        }
+#ifdef Q_OS_UNIX
+        struct stat dirStat;
+        struct stat socketStat;
+        const QString dir = QFileInfo(path).absolutePath();
+        if(::stat(QFile::encodeName(dir).constData(), &dirStat) != 0
+           || ::lstat(QFile::encodeName(path).constData(), &socketStat) != 0) {
+            return false;
+        }
+        const uid_t uid = ::geteuid();
+        if(!S_ISDIR(dirStat.st_mode) || (dirStat.st_mode & (S_IWGRP | S_IWOTH))
+           || (dirStat.st_uid != 0 && dirStat.st_uid != uid)) {
+            return false;
+        }
+        if(!S_ISSOCK(socketStat.st_mode)
+           || (socketStat.st_uid != 0 && socketStat.st_uid != uid)) {
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const WiFiScanResult &result)
+{
+    argument.beginStructure();
+    argument << result.bssid().toUInt64()
+             << result.ssid()
+             << result.rssi()
+             << result.frequency()
+             << result.flags()
+             << result.timestamp()
+             << result.networkId();
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, WiFiScanResult &result)
+{
+    quint64 bssid = 0;
+    QString ssid;
+    qint16 rssi = 0;
+    int frequency = 0;
+    QString flags;
+    qint64 timestamp = 0;
+    int networkId = -1;
+
+    argument.beginStructure();
+    argument >> bssid >> ssid >> rssi >> frequency >> flags >> timestamp >> networkId;
+    argument.endStructure();
+
+    /* 与 fromMap() 一致，BSSID 为空时得到无效对象 */
+    if (bssid == 0) {
+        result = WiFiScanResult();
+        return argument;
+    }
+
+    result = WiFiScanResult(WiFiMacAddress(bssid), ssid);
+    result.setRssi(rssi);
+    result.setFrequency(frequency);
+    result.setFlags(flags);
+    result.setTimestamp(timestamp);
+    result.setNetworkId(networkId);
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const WiFiScanResultList &results)
+{
+    argument.beginArray(qMetaTypeId<WiFiScanResult>());
+    for (const WiFiScanResult &result : results) {
+        argument << result;
+    }
+    argument.endArray();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, WiFiScanResultList &results)
+{
+    results.clear();
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        WiFiScanResult result;
+        argument >> result;
+        results.append(result);
+    }
+    argument.endArray();
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const WiFiInfo &info)
+{
+    argument.beginStructure();
+    argument << info.macAddress().toUInt64()
+             << info.bssid().toUInt64()
+             << info.ssid()
+             << info.rssi()
+             << info.frequency()
+             << info.ipAddress()
+             << info.networkId()
+             << info.rxLinkSpeed()
+             << info.txLinkSpeed();
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, WiFiInfo &info)
+{
+    quint64 address = 0;
+    quint64 bssid = 0;
+    QString ssid;
+    qint16 rssi = 0;
+    int frequency = 0;
+    QString ipAddress;
+    int networkId = -1;
+    int rxLinkSpeed = 0;
+    int txLinkSpeed = 0;
+
+    argument.beginStructure();
+    argument >> address >> bssid >> ssid >> rssi >> frequency >> ipAddress
+             >> networkId >> rxLinkSpeed >> txLinkSpeed;
+    argument.endStructure();
+
+    info = WiFiInfo();
+    info.setMacAddress(WiFiMacAddress(address));
+    info.setBSSID(WiFiMacAddress(bssid));
+    info.setSSID(ssid);
+    info.setRssi(rssi);
+    info.setFrequency(frequency);
+    info.setIpAddress(ipAddress);
+    info.setNetworkId(networkId);
+    info.setRxLinkSpeed(rxLinkSpeed);
+    info.setTxLinkSpeed(txLinkSpeed);
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const WiFiNetwork &network)
+{
+    argument.beginStructure();
+    argument << network.networkId()
+             << network.ssid()
+             << network.bssid().toUInt64()
+             << static_cast<int>(network.authFlags())
+             << static_cast<int>(network.encrFlags())
+             << network.preSharedKey();
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, WiFiNetwork &network)
+{
+    int networkId = -1;
+    QString ssid;
+    quint64 bssid = 0;
+    int auths = 0;
+    int encrs = 0;
+    QString psk;
+
+    argument.beginStructure();
+    argument >> networkId >> ssid >> bssid >> auths >> encrs >> psk;
+    argument.endStructure();
+
+    network = WiFiNetwork(networkId, ssid);
+    network.setBSSID(WiFiMacAddress(bssid));
+    network.setAuthFlags(static_cast<WiFi::AuthFlags>(auths));
+    network.setEncrFlags(static_cast<WiFi::EncrytionFlags>(encrs));
+    network.setPreSharedKey(psk);
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const WiFiNetworkList &networks)
+{
+    argument.beginArray(qMetaTypeId<WiFiNetwork>());
+    for (const WiFiNetwork &network : networks) {
+        argument << network;
+    }
+    argument.endArray();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, WiFiNetworkList &networks)
+{
+    networks.clear();
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        WiFiNetwork network;
+        argument >> network;
+        networks.append(network);
+    }
+    argument.endArray();
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const WiFiStationChanges &changes)
+{
+    argument.beginStructure();
+    argument << changes.epoch
+             << changes.generation
+             << changes.reset
+             << changes.scanResults
+             << changes.removedScanResults
+             << changes.networksChanged
+             << changes.networks;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, WiFiStationChanges &changes)
+{
+    argument.beginStructure();
+    argument >> changes.epoch
+             >> changes.generation
+             >> changes.reset
+             >> changes.scanResults
+             >> changes.removedScanResults
+             >> changes.networksChanged
+             >> changes.networks;
+    argument.endStructure();
+    return argument;
+}
+
+QT_END_NAMESPACE
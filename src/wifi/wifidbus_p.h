@@ -20,6 +20,12 @@
 #define WIFIDBUS_P_H
 
 #include <QtDBus/qdbusconnection.h>
+#include <QtDBus/qdbusargument.h>
+
+#include <WiFi/wifiinfo.h>
+#include <WiFi/wifiscanresult.h>
+#include <WiFi/wifinetwork.h>
+#include <WiFi/private/wifiglobal_p.h>
 
 namespace WiFiDBus
 {
@@ -31,6 +37,87 @@ namespace WiFiDBus
     {
         return QDBusConnection::systemBus();
     }
+
+    /*
+        服务端点对点套接字地址，同一台设备上的客户端可不经过 dbus-daemon 直接连接。
+        默认放在只有服务用户可写的目录中，其它用户无法抢先占用该地址冒充服务；
+        连接本身由 D-Bus EXTERNAL 认证限制为与服务相同的用户。
+    */
+    const static QString peerConnectionName = QStringLiteral("wifi.native.peer");
+    static QString peerAddress()
+    {
+        if(!qEnvironmentVariableIsEmpty("WIFI_DBUS_PEER_ADDRESS")) {
+            return QString::fromLocal8Bit(qgetenv("WIFI_DBUS_PEER_ADDRESS"));
+        }
+        return QStringLiteral("unix:path=/var/run/wifi/native.peer");
+    }
+
+    /* peerAddress() 为 unix:path= 时返回套接字文件路径，否则返回空字符串 */
+    Q_WIFI_PRIVATE_EXPORT QString peerSocketPath();
+    /* 服务端：创建套接字目录(0755)并删除上次遗留的套接字文件 */
+    Q_WIFI_PRIVATE_EXPORT bool preparePeerSocket();
+    /*
+        客户端：套接字目录与文件属于 root 或当前用户，且目录不允许其他用户写入。
+        WIFI_DBUS_PEER_ADDRESS 指定的非文件系统地址由配置者负责，视为可信。
+    */
+    Q_WIFI_PRIVATE_EXPORT bool isPeerTrusted();
+
+    /* 注册 wifi.native.Station 接口使用的 D-Bus 结构类型，可重复调用 */
+    Q_WIFI_PRIVATE_EXPORT void registerMetaTypes();
 }
 
+/*
+    GetChangesSince 的返回值。epoch 标识服务进程，generation 是服务端状态的代数。
+    reset 为 true 时 scanResults 与 networks 是完整快照；否则 scanResults 只包含
+    给定代数之后变化的条目，removedScanResults 是之后被删除的 BSSID ，
+    networks 仅在 networksChanged 为 true 时有效（完整列表）。
+*/
+struct WiFiStationChanges
+{
+    WiFiStationChanges() : epoch(0), generation(0), reset(false), networksChanged(false) {}
+
+    quint64 epoch;
+    quint64 generation;
+    bool reset;
+    WiFiScanResultList scanResults;
+    QList<quint64> removedScanResults;
+    bool networksChanged;
+    WiFiNetworkList networks;
+};
+Q_DECLARE_METATYPE(WiFiStationChanges)
+
+/*
+    wifi.native.Station 接口的二进制结构签名：
+        WiFiScanResult  (tsnisxi)   bssid, ssid, rssi, frequency, flags, timestamp, networkId
+        WiFiInfo        (ttsnisiii) macAddress, bssid, ssid, rssi, frequency, ipAddress,
+                                    networkId, rxLinkSpeed, txLinkSpeed
+        WiFiNetwork     (istiis)    networkId, ssid, bssid, authFlags, encrFlags, preSharedKey
+        WiFiStationChanges (ttba(tsnisxi)atba(istiis))
+    MAC 地址以 quint64 传输。
+*/
+Q_WIFI_PRIVATE_EXPORT QDBusArgument &operator<<(QDBusArgument &argument,
+                                                const WiFiScanResult &result);
+Q_WIFI_PRIVATE_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument,
+                                                      WiFiScanResult &result);
+Q_WIFI_PRIVATE_EXPORT QDBusArgument &operator<<(QDBusArgument &argument,
+                                                const WiFiScanResultList &results);
+Q_WIFI_PRIVATE_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument,
+                                                      WiFiScanResultList &results);
+Q_WIFI_PRIVATE_EXPORT QDBusArgument &operator<<(QDBusArgument &argument,
+                                                const WiFiInfo &info);
+Q_WIFI_PRIVATE_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument,
+                                                      WiFiInfo &info);
+Q_WIFI_PRIVATE_EXPORT QDBusArgument &operator<<(QDBusArgument &argument,
+                                                const WiFiNetwork &network);
+Q_WIFI_PRIVATE_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument,
+                                                      WiFiNetwork &network);
+Q_WIFI_PRIVATE_EXPORT QDBusArgument &operator<<(QDBusArgument &argument,
+                                                const WiFiNetworkList &networks);
+Q_WIFI_PRIVATE_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument,
+                                                      WiFiNetworkList &networks);
+Q_WIFI_PRIVATE_EXPORT QDBusArgument &operator<<(QDBusArgument &argument,
+                                                const WiFiStationChanges &changes);
+Q_WIFI_PRIVATE_EXPORT const QDBusArgument &operator>>(const QDBusArgument &argument,
+                                                      WiFiStationChanges &changes);
+
 #endif // WIFIDBUS_P_H
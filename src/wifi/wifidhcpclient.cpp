@@ -0,0 +1,895 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "wifidhcpclient_p.h"
+
+#include <WiFi/wifiglobal.h>
+
+#include <QtCore/qtimer.h>
+#include <QtCore/qsocketnotifier.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qloggingcategory.h>
+
+extern "C"
+{
+#include "utils/os.h"
+#include "utils/common.h"
+#include "common/dhcp.h"
+}
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/route.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <limits>
+
+// in a header
+Q_DECLARE_LOGGING_CATEGORY(logDhcp)
+// in one source file
+Q_LOGGING_CATEGORY(logDhcp, "wifi.dhcp", QtInfoMsg)
+
+QT_BEGIN_NAMESPACE
+
+static QByteArray WIFI_DHCPC_LEASES = "/var/run/wifi/dhcpc.leases";
+static QByteArray WIFI_DHCPC_RESOLV_CONF = "/etc/resolv.conf";
+static int WIFI_DHCPC_RETRY = 500; // msecs, 首次重发间隔，之后加倍
+static int WIFI_DHCPC_TIMEOUT = 30000; // msecs, 获取租约的总时限, 0 表示不限时
+static const int WIFI_DHCPC_RETRY_SHIFT = 4; // 重发间隔最多加倍到 16 倍
+static const int WIFI_DHCPC_REBOOT_TRIES = 2; // INIT-REBOOT 无应答时回到 DISCOVER
+static const int WIFI_DHCPC_REQUEST_TRIES = 4; // REQUEST 无应答时回到 DISCOVER
+static const int WIFI_DHCPC_MIN_PACKET = 300; // BOOTP 报文的最小长度
+static const quint32 WIFI_DHCPC_INFINITE = 0xffffffff;
+
+static QString wifiAddressString(quint32 address)
+{
+    return QStringLiteral("%1.%2.%3.%4").arg(address >> 24).arg((address >> 16) & 0xff)
+           .arg((address >> 8) & 0xff).arg(address & 0xff);
+}
+
+static quint32 wifiReadAddress(const uchar *data)
+{
+    return qFromBigEndian<quint32>(data);
+}
+
+static void wifiAppendOption(QByteArray &packet, quint8 code, const QByteArray &value)
+{
+    packet.append(char(code));
+    packet.append(char(value.size()));
+    packet.append(value);
+}
+
+static QByteArray wifiAddressOption(quint32 address)
+{
+    QByteArray value(4, 0);
+    qToBigEndian<quint32>(address, reinterpret_cast<uchar *>(value.data()));
+    return value;
+}
+
+static void wifiSetSockAddr(struct sockaddr *sa, quint32 address)
+{
+    struct sockaddr_in *sin = reinterpret_cast<struct sockaddr_in *>(sa);
+    memset(sin, 0, sizeof(*sin));
+    sin->sin_family = AF_INET;
+    sin->sin_addr.s_addr = htonl(address);
+}
+
+/* 通过 ioctl 配置接口地址，address 为 0 时移除接口上的 IPv4 地址及相关路由。
+ */
+static bool wifiSetInterfaceAddress(const QByteArray &ifname, quint32 address,
+                                    quint32 netmask)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        return false;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname.constData(), IFNAMSIZ - 1);
+
+    bool ok = true;
+    wifiSetSockAddr(&ifr.ifr_addr, address);
+    if(::ioctl(fd, SIOCSIFADDR, &ifr) < 0 && address != 0) {
+        ok = false;
+    }
+    if(ok && address != 0) {
+        wifiSetSockAddr(&ifr.ifr_netmask, netmask);
+        ok = ::ioctl(fd, SIOCSIFNETMASK, &ifr) == 0;
+    }
+    if(ok && address != 0) {
+        wifiSetSockAddr(&ifr.ifr_broadaddr, address | ~netmask);
+        ok = ::ioctl(fd, SIOCSIFBRDADDR, &ifr) == 0;
+    }
+    if(!ok) {
+        qCWarning(logDhcp, "[FAIL] Set %s address %s: %s", ifname.constData(),
+                  qUtf8Printable(wifiAddressString(address)),
+                  qUtf8Printable(qt_error_string(errno)));
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+static bool wifiAddDefaultRoute(const QByteArray &ifname, quint32 router)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        return false;
+    }
+
+    QByteArray device = ifname;
+    struct rtentry route;
+    memset(&route, 0, sizeof(route));
+    wifiSetSockAddr(&route.rt_dst, 0);
+    wifiSetSockAddr(&route.rt_genmask, 0);
+    wifiSetSockAddr(&route.rt_gateway, router);
+    route.rt_flags = RTF_UP | RTF_GATEWAY;
+    route.rt_dev = device.data();
+
+    bool ok = ::ioctl(fd, SIOCADDRT, &route) == 0 || errno == EEXIST;
+    if(!ok) {
+        qCWarning(logDhcp, "[FAIL] Add default route via %s: %s",
+                  qUtf8Printable(wifiAddressString(router)),
+                  qUtf8Printable(qt_error_string(errno)));
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+static void wifiWriteResolvConf(const QList<quint32> &dns)
+{
+    if(dns.isEmpty()) {
+        return;
+    }
+
+    QSaveFile file(QString::fromLocal8Bit(WIFI_DHCPC_RESOLV_CONF));
+    file.setDirectWriteFallback(true);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCWarning(logDhcp, "[FAIL] Write %s: %s", WIFI_DHCPC_RESOLV_CONF.constData(),
+                  qUtf8Printable(file.errorString()));
+        return;
+    }
+    for(quint32 server : dns) {
+        file.write("nameserver ");
+        file.write(wifiAddressString(server).toLatin1());
+        file.write("\n");
+    }
+    file.commit();
+}
+
+/*!
+    如果租约已经到期，则返回 true 。
+*/
+bool WiFiDhcpLease::isExpired() const
+{
+    if(!isValid()) {
+        return true;
+    }
+    if(leaseTime == WIFI_DHCPC_INFINITE) {
+        return false;
+    }
+    return QDateTime::currentMSecsSinceEpoch() >= obtained + qint64(leaseTime) * 1000;
+}
+
+QString WiFiDhcpLease::toString() const
+{
+    QStringList servers;
+    for(quint32 server : dns) {
+        servers << wifiAddressString(server);
+    }
+    return QStringLiteral("%1/%2 router %3 server %4 dns [%5] lease %6s")
+           .arg(wifiAddressString(address)).arg(wifiAddressString(netmask))
+           .arg(wifiAddressString(router)).arg(wifiAddressString(server))
+           .arg(servers.join(QLatin1Char(' '))).arg(leaseTime);
+}
+
+QVariantMap WiFiDhcpLease::toMap() const
+{
+    QVariantMap map;
+
+    map[QLatin1String("address")] = address;
+    map[QLatin1String("netmask")] = netmask;
+    map[QLatin1String("router")] = router;
+    map[QLatin1String("server")] = server;
+    QVariantList servers;
+    for(quint32 server : dns) {
+        servers << server;
+    }
+    map[QLatin1String("dns")] = servers;
+    map[QLatin1String("leaseTime")] = leaseTime;
+    map[QLatin1String("renewalTime")] = renewalTime;
+    map[QLatin1String("rebindingTime")] = rebindingTime;
+    map[QLatin1String("obtained")] = obtained;
+
+    return map;
+}
+
+WiFiDhcpLease WiFiDhcpLease::fromMap(const QVariantMap &map)
+{
+    WiFiDhcpLease lease;
+
+    lease.address = map[QLatin1String("address")].toUInt();
+    lease.netmask = map[QLatin1String("netmask")].toUInt();
+    lease.router = map[QLatin1String("router")].toUInt();
+    lease.server = map[QLatin1String("server")].toUInt();
+    const QVariantList servers = map[QLatin1String("dns")].toList();
+    for(const QVariant &server : servers) {
+        lease.dns << server.toUInt();
+    }
+    lease.leaseTime = map[QLatin1String("leaseTime")].toUInt();
+    lease.renewalTime = map[QLatin1String("renewalTime")].toUInt();
+    lease.rebindingTime = map[QLatin1String("rebindingTime")].toUInt();
+    lease.obtained = map[QLatin1String("obtained")].toLongLong();
+
+    return lease;
+}
+
+/*!
+    \class WiFiDhcpClient
+    \inmodule WiFi
+    \brief 类 WiFiDhcpClient 在进程内为一个网络接口获取 DHCP 租约。
+*/
+
+WiFiDhcpClient::WiFiDhcpClient(const QString &interface, QObject *parent)
+    : QObject(parent)
+    , m_interface(interface)
+{
+    if(!qEnvironmentVariableIsEmpty("WIFI_DHCPC_LEASES")) {
+        WIFI_DHCPC_LEASES = qgetenv("WIFI_DHCPC_LEASES");
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_DHCPC_RESOLV_CONF")) {
+        WIFI_DHCPC_RESOLV_CONF = qgetenv("WIFI_DHCPC_RESOLV_CONF");
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_DHCPC_RETRY")) {
+        bool ok;
+        int retry = qgetenv("WIFI_DHCPC_RETRY").toInt(&ok);
+        if(ok && retry > 0) {
+            WIFI_DHCPC_RETRY = retry;
+        }
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_DHCPC_TIMEOUT")) {
+        bool ok;
+        int timeout = qgetenv("WIFI_DHCPC_TIMEOUT").toInt(&ok);
+        if(ok && timeout >= 0) {
+            WIFI_DHCPC_TIMEOUT = timeout;
+        }
+    }
+
+    qRegisterMetaType<WiFiDhcpLease>();
+
+    m_retransmitTimer = new QTimer(this);
+    m_retransmitTimer->setSingleShot(true);
+    connect(m_retransmitTimer, &QTimer::timeout, this, &WiFiDhcpClient::onRetransmit);
+    m_renewTimer = new QTimer(this);
+    m_renewTimer->setSingleShot(true);
+    connect(m_renewTimer, &QTimer::timeout, this, &WiFiDhcpClient::onRenew);
+    m_rebindTimer = new QTimer(this);
+    m_rebindTimer->setSingleShot(true);
+    connect(m_rebindTimer, &QTimer::timeout, this, &WiFiDhcpClient::onRebind);
+    m_expireTimer = new QTimer(this);
+    m_expireTimer->setSingleShot(true);
+    connect(m_expireTimer, &QTimer::timeout, this, &WiFiDhcpClient::onExpire);
+
+    this->loadLeases();
+}
+
+WiFiDhcpClient::~WiFiDhcpClient()
+{
+    this->closeSocket();
+}
+
+QString WiFiDhcpClient::interface() const
+{
+    return m_interface;
+}
+
+WiFiDhcpClient::State WiFiDhcpClient::state() const
+{
+    return m_state;
+}
+
+WiFiDhcpLease WiFiDhcpClient::lease() const
+{
+    return m_lease;
+}
+
+bool WiFiDhcpClient::isApplyLease() const
+{
+    return m_applyLease;
+}
+
+void WiFiDhcpClient::setApplyLease(bool apply)
+{
+    m_applyLease = apply;
+}
+
+WiFiDhcpLease WiFiDhcpClient::cachedLease(const QString &bssid, const QString &ssid) const
+{
+    if(!bssid.isEmpty()) {
+        const WiFiDhcpLease lease = m_leases.value(QLatin1String("bssid:") + bssid);
+        if(!lease.isExpired()) {
+            return lease;
+        }
+    }
+    if(!ssid.isEmpty()) {
+        const WiFiDhcpLease lease = m_leases.value(QLatin1String("ssid:") + ssid);
+        if(!lease.isExpired()) {
+            return lease;
+        }
+    }
+    return WiFiDhcpLease();
+}
+
+/*
+ * 有未过期的缓存租约时跳过 DISCOVER/OFFER ，直接广播 REQUEST 请求上次的地址，
+ * 同一网络重新连接只需要一次往返。
+ */
+void WiFiDhcpClient::start(const QString &bssid, const QString &ssid)
+{
+    this->stopTimers();
+    m_bssid = bssid.toLower();
+    m_ssid = ssid;
+
+    if(!this->openSocket()) {
+        this->setState(Stopped);
+        emit failed();
+        return;
+    }
+
+    m_startTime = QDateTime::currentMSecsSinceEpoch();
+    m_xid = quint32(qrand()) ^ (quint32(m_startTime) << 8);
+
+    const WiFiDhcpLease cached = this->cachedLease(m_bssid, m_ssid);
+    if(cached.isValid()) {
+        qCDebug(logDhcp, "[ DEBUG ] DHCP %s reboot with %s.", qUtf8Printable(m_interface),
+                qUtf8Printable(wifiAddressString(cached.address)));
+        m_offer = cached;
+        m_tries = 0;
+        this->setState(Rebooting);
+        this->sendRequest();
+        m_retransmitTimer->start(this->retryDelay());
+    } else {
+        this->enterInit();
+    }
+}
+
+void WiFiDhcpClient::stop()
+{
+    this->stopTimers();
+    this->clearLease();
+    this->closeSocket();
+    this->setState(Stopped);
+}
+
+void WiFiDhcpClient::release()
+{
+    if(m_lease.isValid() && m_fd >= 0) {
+        this->sendRelease();
+    }
+    this->forgetLease();
+    this->stop();
+}
+
+void WiFiDhcpClient::onReadyRead()
+{
+    QByteArray buffer(1500, Qt::Uninitialized);
+    for(;;) {
+        ssize_t length = ::recv(m_fd, buffer.data(), buffer.size(), MSG_DONTWAIT);
+        if(length < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        this->processPacket(QByteArray::fromRawData(buffer.constData(), int(length)));
+        if(m_fd < 0) {
+            break;
+        }
+    }
+}
+
+void WiFiDhcpClient::onRetransmit()
+{
+    m_tries++;
+
+    switch(m_state) {
+    case Rebooting:
+        if(m_tries >= WIFI_DHCPC_REBOOT_TRIES) {
+            qCDebug(logDhcp, "[ DEBUG ] DHCP %s reboot not answered, discover.",
+                    qUtf8Printable(m_interface));
+            this->enterInit();
+            return;
+        }
+        this->sendRequest();
+        break;
+    case Selecting:
+    case Requesting:
+        if(WIFI_DHCPC_TIMEOUT > 0 &&
+           QDateTime::currentMSecsSinceEpoch() - m_startTime >= WIFI_DHCPC_TIMEOUT) {
+            qCWarning(logDhcp, "[FAIL] DHCP %s get lease failed.%s",
+                      qUtf8Printable(m_interface),
+                      wifiPrintTimes(QDateTime::currentMSecsSinceEpoch() - m_startTime));
+            this->stop();
+            emit failed();
+            return;
+        }
+        if(m_state == Requesting && m_tries >= WIFI_DHCPC_REQUEST_TRIES) {
+            this->enterInit();
+            return;
+        }
+        if(m_state == Selecting) {
+            this->sendDiscover();
+        } else {
+            this->sendRequest();
+        }
+        break;
+    case Renewing:
+    case Rebinding:
+        this->sendRequest();
+        break;
+    default:
+        return;
+    }
+
+    m_retransmitTimer->start(this->retryDelay());
+}
+
+/* T1 到期：向租约服务器单播 REQUEST 续租。
+ */
+void WiFiDhcpClient::onRenew()
+{
+    m_startTime = QDateTime::currentMSecsSinceEpoch();
+    m_xid++;
+    m_tries = 0;
+    this->setState(Renewing);
+    this->sendRequest();
+    m_retransmitTimer->start(this->retryDelay());
+}
+
+/* T2 到期：广播 REQUEST ，任何服务器都可以延长租约。
+ */
+void WiFiDhcpClient::onRebind()
+{
+    m_xid++;
+    m_tries = 0;
+    this->setState(Rebinding);
+    this->sendRequest();
+    m_retransmitTimer->start(this->retryDelay());
+}
+
+void WiFiDhcpClient::onExpire()
+{
+    qCWarning(logDhcp, "[FAIL] DHCP %s lease %s expired.", qUtf8Printable(m_interface),
+              qUtf8Printable(wifiAddressString(m_lease.address)));
+    this->forgetLease();
+    this->clearLease();
+    m_startTime = QDateTime::currentMSecsSinceEpoch();
+    this->enterInit();
+}
+
+/* 绑定到网络接口的 UDP 套接字，未配置地址时也可以收发广播。
+ */
+bool WiFiDhcpClient::openSocket()
+{
+    if(m_fd >= 0) {
+        return true;
+    }
+
+    const QByteArray ifname = m_interface.toLocal8Bit();
+    m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if(m_fd < 0) {
+        qCCritical(logDhcp, "[FAIL] DHCP socket: %s", qUtf8Printable(qt_error_string(errno)));
+        return false;
+    }
+
+    int on = 1;
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname.constData(), IFNAMSIZ - 1);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(DHCP_CLIENT_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if(::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+       ::setsockopt(m_fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on)) < 0 ||
+       ::setsockopt(m_fd, SOL_SOCKET, SO_BINDTODEVICE, ifname.constData(),
+                    socklen_t(ifname.size() + 1)) < 0 ||
+       ::bind(m_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+       ::ioctl(m_fd, SIOCGIFHWADDR, &ifr) < 0) {
+        qCCritical(logDhcp, "[FAIL] DHCP socket on %s: %s", ifname.constData(),
+                   qUtf8Printable(qt_error_string(errno)));
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_hwAddress = QByteArray(ifr.ifr_hwaddr.sa_data, 6);
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &WiFiDhcpClient::onReadyRead);
+    return true;
+}
+
+void WiFiDhcpClient::closeSocket()
+{
+    if(m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = NULL;
+    }
+    if(m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void WiFiDhcpClient::setState(State state)
+{
+    if(m_state == state) {
+        return;
+    }
+    m_state = state;
+    emit stateChanged(state);
+}
+
+void WiFiDhcpClient::sendDiscover()
+{
+    this->sendPacket(DHCPDISCOVER, 0, 0, 0, INADDR_BROADCAST);
+}
+
+void WiFiDhcpClient::sendRequest()
+{
+    switch(m_state) {
+    case Requesting:
+        this->sendPacket(DHCPREQUEST, 0, m_offer.address, m_offer.server, INADDR_BROADCAST);
+        break;
+    case Rebooting:
+        this->sendPacket(DHCPREQUEST, 0, m_offer.address, 0, INADDR_BROADCAST);
+        break;
+    case Renewing:
+        this->sendPacket(DHCPREQUEST, m_lease.address, 0, 0,
+                         m_lease.server ? m_lease.server : INADDR_BROADCAST);
+        break;
+    case Rebinding:
+        this->sendPacket(DHCPREQUEST, m_lease.address, 0, 0, INADDR_BROADCAST);
+        break;
+    default:
+        break;
+    }
+}
+
+void WiFiDhcpClient::sendRelease()
+{
+    m_xid++;
+    this->sendPacket(DHCPRELEASE, m_lease.address, 0, m_lease.server,
+                     m_lease.server ? m_lease.server : INADDR_BROADCAST);
+}
+
+/* 按 common/dhcp.h 的 struct dhcp_data 组织 BOOTP 报文，后接 magic cookie 和选项。
+ * 没有地址时置位广播标志，服务器以广播回复。
+ */
+bool WiFiDhcpClient::sendPacket(quint8 type, quint32 clientAddress,
+                                quint32 requestedAddress, quint32 serverId,
+                                quint32 destination)
+{
+    if(m_fd < 0) {
+        return false;
+    }
+
+    QByteArray packet(sizeof(struct dhcp_data), 0);
+    struct dhcp_data *data = reinterpret_cast<struct dhcp_data *>(packet.data());
+    data->op = 1; // BOOTREQUEST
+    data->htype = 1; // Ethernet
+    data->hlen = 6;
+    data->xid = qToBigEndian<quint32>(m_xid);
+    qint64 secs = (QDateTime::currentMSecsSinceEpoch() - m_startTime) / 1000;
+    data->secs = qToBigEndian<quint16>(quint16(qBound<qint64>(0, secs, 0xffff)));
+    data->flags = qToBigEndian<quint16>(clientAddress ? 0 : 0x8000);
+    data->client_ip = qToBigEndian<quint32>(clientAddress);
+    memcpy(data->hw_addr, m_hwAddress.constData(), qMin(m_hwAddress.size(), 16));
+
+    packet.append(wifiAddressOption(DHCP_MAGIC));
+    wifiAppendOption(packet, DHCP_OPT_MSG_TYPE, QByteArray(1, char(type)));
+    wifiAppendOption(packet, DHCP_OPT_CLIENT_ID, QByteArray(1, 1) + m_hwAddress);
+    if(requestedAddress) {
+        wifiAppendOption(packet, DHCP_OPT_REQUESTED_IP_ADDRESS,
+                         wifiAddressOption(requestedAddress));
+    }
+    if(serverId) {
+        wifiAppendOption(packet, DHCP_OPT_SERVER_ID, wifiAddressOption(serverId));
+    }
+    if(type == DHCPDISCOVER || type == DHCPREQUEST) {
+        static const char parameters[] = {
+            DHCP_OPT_SUBNET_MASK, DHCP_OPT_ROUTER, DHCP_OPT_DOMAIN_NAME_SERVER,
+            DHCP_OPT_IP_ADDRESS_LEASE_TIME, DHCP_OPT_SERVER_ID,
+            DHCP_OPT_RENEWAL_TIME, DHCP_OPT_REBINDING_TIME
+        };
+        wifiAppendOption(packet, DHCP_OPT_PARAMETER_REQ_LIST,
+                         QByteArray::fromRawData(parameters, sizeof(parameters)));
+    }
+    packet.append(char(DHCP_OPT_END));
+    if(packet.size() < WIFI_DHCPC_MIN_PACKET) {
+        packet.append(QByteArray(WIFI_DHCPC_MIN_PACKET - packet.size(), 0));
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(DHCP_SERVER_PORT);
+    addr.sin_addr.s_addr = htonl(destination);
+    if(::sendto(m_fd, packet.constData(), packet.size(), MSG_DONTWAIT,
+                reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+        qCWarning(logDhcp, "[FAIL] DHCP %s send type %d: %s", qUtf8Printable(m_interface),
+                  type, qUtf8Printable(qt_error_string(errno)));
+        return false;
+    }
+    qCDebug(logDhcp, "[ DEBUG ] DHCP %s send type %d xid %08x.", qUtf8Printable(m_interface),
+            type, m_xid);
+    return true;
+}
+
+void WiFiDhcpClient::processPacket(const QByteArray &packet)
+{
+    const int size = packet.size();
+    const int optionsOffset = int(sizeof(struct dhcp_data)) + 4;
+    if(size < optionsOffset) {
+        return;
+    }
+
+    const uchar *bytes = reinterpret_cast<const uchar *>(packet.constData());
+    const struct dhcp_data *data = reinterpret_cast<const struct dhcp_data *>(bytes);
+    if(data->op != 2 || qFromBigEndian<quint32>(data->xid) != m_xid ||
+       memcmp(data->hw_addr, m_hwAddress.constData(), m_hwAddress.size()) != 0 ||
+       qFromBigEndian<quint32>(bytes + sizeof(struct dhcp_data)) != DHCP_MAGIC) {
+        return;
+    }
+
+    int type = 0;
+    WiFiDhcpLease lease;
+    lease.address = qFromBigEndian<quint32>(data->your_ip);
+    for(int pos = optionsOffset; pos < size;) {
+        const quint8 code = bytes[pos++];
+        if(code == DHCP_OPT_PAD) {
+            continue;
+        }
+        if(code == DHCP_OPT_END || pos >= size) {
+            break;
+        }
+        const int length = bytes[pos++];
+        if(pos + length > size) {
+            break;
+        }
+        const uchar *value = bytes + pos;
+        switch(code) {
+        case DHCP_OPT_MSG_TYPE:
+            type = length >= 1 ? value[0] : 0;
+            break;
+        case DHCP_OPT_SUBNET_MASK:
+            lease.netmask = length >= 4 ? wifiReadAddress(value) : 0;
+            break;
+        case DHCP_OPT_ROUTER:
+            lease.router = length >= 4 ? wifiReadAddress(value) : 0;
+            break;
+        case DHCP_OPT_DOMAIN_NAME_SERVER:
+            for(int i = 0; i + 4 <= length; i += 4) {
+                lease.dns << wifiReadAddress(value + i);
+            }
+            break;
+        case DHCP_OPT_IP_ADDRESS_LEASE_TIME:
+            lease.leaseTime = length >= 4 ? wifiReadAddress(value) : 0;
+            break;
+        case DHCP_OPT_RENEWAL_TIME:
+            lease.renewalTime = length >= 4 ? wifiReadAddress(value) : 0;
+            break;
+        case DHCP_OPT_REBINDING_TIME:
+            lease.rebindingTime = length >= 4 ? wifiReadAddress(value) : 0;
+            break;
+        case DHCP_OPT_SERVER_ID:
+            lease.server = length >= 4 ? wifiReadAddress(value) : 0;
+            break;
+        default:
+            break;
+        }
+        pos += length;
+    }
+
+    qCDebug(logDhcp, "[ DEBUG ] DHCP %s receive type %d: %s", qUtf8Printable(m_interface),
+            type, qUtf8Printable(lease.toString()));
+
+    if(type == DHCPOFFER && m_state == Selecting && lease.isValid()) {
+        m_offer = lease;
+        m_tries = 0;
+        this->setState(Requesting);
+        this->sendRequest();
+        m_retransmitTimer->start(this->retryDelay());
+    } else if(type == DHCPACK && (m_state == Requesting || m_state == Rebooting ||
+                                  m_state == Renewing || m_state == Rebinding)) {
+        if(!lease.isValid()) {
+            lease.address = m_state == Rebooting ? m_offer.address : m_lease.address;
+        }
+        if(!lease.server) {
+            lease.server = m_state == Renewing ? m_lease.server : m_offer.server;
+        }
+        this->enterBound(lease);
+    } else if(type == DHCPNAK && m_state != Selecting && m_state != Bound) {
+        qCWarning(logDhcp, "[FAIL] DHCP %s request %s refused.", qUtf8Printable(m_interface),
+                  qUtf8Printable(wifiAddressString(m_state == Rebooting || m_state == Requesting
+                                 ? m_offer.address : m_lease.address)));
+        this->forgetLease();
+        this->clearLease();
+        this->enterInit();
+    }
+}
+
+int WiFiDhcpClient::retryDelay() const
+{
+    return WIFI_DHCPC_RETRY << qMin(m_tries, WIFI_DHCPC_RETRY_SHIFT);
+}
+
+void WiFiDhcpClient::enterInit()
+{
+    m_offer = WiFiDhcpLease();
+    m_tries = 0;
+    m_xid++;
+    this->setState(Selecting);
+    this->sendDiscover();
+    m_retransmitTimer->start(this->retryDelay());
+}
+
+void WiFiDhcpClient::enterBound(WiFiDhcpLease lease)
+{
+    this->stopTimers();
+
+    lease.obtained = QDateTime::currentMSecsSinceEpoch();
+    if(lease.leaseTime == 0) {
+        lease.leaseTime = WIFI_DHCPC_INFINITE;
+    }
+    if(lease.leaseTime != WIFI_DHCPC_INFINITE) {
+        if(lease.renewalTime == 0 || lease.renewalTime >= lease.leaseTime) {
+            lease.renewalTime = lease.leaseTime / 2;
+        }
+        if(lease.rebindingTime == 0 || lease.rebindingTime >= lease.leaseTime) {
+            lease.rebindingTime = lease.leaseTime / 8 * 7;
+        }
+    }
+
+    const bool changed = lease.address != m_lease.address ||
+                         lease.netmask != m_lease.netmask ||
+                         lease.router != m_lease.router ||
+                         lease.dns != m_lease.dns;
+    m_lease = lease;
+    m_offer = WiFiDhcpLease();
+    if(m_applyLease && changed) {
+        const QByteArray ifname = m_interface.toLocal8Bit();
+        wifiSetInterfaceAddress(ifname, lease.address, lease.netmask);
+        if(lease.router) {
+            wifiAddDefaultRoute(ifname, lease.router);
+        }
+        wifiWriteResolvConf(lease.dns);
+    }
+    this->cacheLease(lease);
+    this->setState(Bound);
+
+    if(lease.leaseTime != WIFI_DHCPC_INFINITE) {
+        // QTimer 的间隔不能超过 int ，超长的租约按上限计时
+        const qint64 limit = std::numeric_limits<int>::max();
+        m_renewTimer->start(int(qMin<qint64>(qint64(lease.renewalTime) * 1000, limit)));
+        m_rebindTimer->start(int(qMin<qint64>(qint64(lease.rebindingTime) * 1000, limit)));
+        m_expireTimer->start(int(qMin<qint64>(qint64(lease.leaseTime) * 1000, limit)));
+    }
+
+    qCInfo(logDhcp, "[ OK ] DHCP %s bound %s.%s", qUtf8Printable(m_interface),
+           qUtf8Printable(lease.toString()),
+           wifiPrintTimes(QDateTime::currentMSecsSinceEpoch() - m_startTime));
+    emit leaseObtained(lease);
+}
+
+void WiFiDhcpClient::clearLease()
+{
+    if(!m_lease.isValid()) {
+        return;
+    }
+    if(m_applyLease) {
+        wifiSetInterfaceAddress(m_interface.toLocal8Bit(), 0, 0);
+    }
+    m_lease = WiFiDhcpLease();
+    emit leaseLost();
+}
+
+void WiFiDhcpClient::stopTimers()
+{
+    m_retransmitTimer->stop();
+    m_renewTimer->stop();
+    m_rebindTimer->stop();
+    m_expireTimer->stop();
+}
+
+void WiFiDhcpClient::loadLeases()
+{
+    QFile file(QString::fromLocal8Bit(WIFI_DHCPC_LEASES));
+    if(!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QVariantMap map = QJsonDocument::fromJson(file.readAll()).toVariant().toMap();
+    for(auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        const WiFiDhcpLease lease = WiFiDhcpLease::fromMap(it.value().toMap());
+        if(!lease.isExpired()) {
+            m_leases.insert(it.key(), lease);
+        }
+    }
+}
+
+void WiFiDhcpClient::saveLeases() const
+{
+    const QString path = QString::fromLocal8Bit(WIFI_DHCPC_LEASES);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QVariantMap map;
+    for(auto it = m_leases.constBegin(); it != m_leases.constEnd(); ++it) {
+        map.insert(it.key(), it.value().toMap());
+    }
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly) ||
+       file.write(QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact)) < 0 ||
+       !file.commit()) {
+        qCWarning(logDhcp, "[FAIL] Save leases %s: %s", qUtf8Printable(path),
+                  qUtf8Printable(file.errorString()));
+    }
+}
+
+void WiFiDhcpClient::cacheLease(const WiFiDhcpLease &lease)
+{
+    if(m_bssid.isEmpty() && m_ssid.isEmpty()) {
+        return;
+    }
+    if(!m_bssid.isEmpty()) {
+        m_leases.insert(QLatin1String("bssid:") + m_bssid, lease);
+    }
+    if(!m_ssid.isEmpty()) {
+        m_leases.insert(QLatin1String("ssid:") + m_ssid, lease);
+    }
+    this->saveLeases();
+}
+
+void WiFiDhcpClient::forgetLease()
+{
+    bool removed = m_leases.remove(QLatin1String("bssid:") + m_bssid) > 0;
+    removed = m_leases.remove(QLatin1String("ssid:") + m_ssid) > 0 || removed;
+    if(removed) {
+        this->saveLeases();
+    }
+}
+
+QT_END_NAMESPACE
+
+#include "moc_wifidhcpclient_p.cpp"
@@ -0,0 +1,162 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef WIFIDHCPCLIENT_P_H
+#define WIFIDHCPCLIENT_P_H
+
+#include <WiFi/private/wifiglobal_p.h>
+
+#include <QtCore/qobject.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qvariant.h>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+class QSocketNotifier;
+
+/* DHCP 租约，地址均为主机字节序。
+ */
+struct Q_WIFI_PRIVATE_EXPORT WiFiDhcpLease
+{
+    quint32 address = 0;
+    quint32 netmask = 0;
+    quint32 router = 0;
+    quint32 server = 0;         // DHCP 服务器标识(option 54)
+    QList<quint32> dns;
+    quint32 leaseTime = 0;      // seconds
+    quint32 renewalTime = 0;    // seconds, T1
+    quint32 rebindingTime = 0;  // seconds, T2
+    qint64 obtained = 0;        // msecs since epoch
+
+    bool isValid() const { return address != 0; }
+    bool isExpired() const;
+    QString toString() const;
+
+    QVariantMap toMap() const;
+    static WiFiDhcpLease fromMap(const QVariantMap &map);
+};
+
+/*
+ * 进程内的异步 DHCP 客户端，替代同步执行 WIFI_WPA_ACTION_DHCPC 脚本。
+ * 报文格式使用 wpa_supplicant 的 common/dhcp.h ，通过绑定到网络接口的非阻塞 UDP
+ * 套接字收发(广播标志置位，未配置地址时也能收到回复)，由 QSocketNotifier 驱动，
+ * 不阻塞事件循环。
+ *
+ * 获得的租约按 BSSID 和 SSID 缓存并写入 WIFI_DHCPC_LEASES ，再次连接同一网络时先以
+ * INIT-REBOOT 直接请求上次的地址，服务器拒绝或无应答时再回到 DISCOVER 。
+ * 租约生效后直接配置接口地址、默认路由，并写入 WIFI_DHCPC_RESOLV_CONF 。
+ */
+class Q_WIFI_PRIVATE_EXPORT WiFiDhcpClient : public QObject
+{
+    Q_OBJECT
+public:
+    enum State {
+        Stopped,
+        Selecting,
+        Requesting,
+        Rebooting,
+        Bound,
+        Renewing,
+        Rebinding
+    };
+    Q_ENUM(State)
+
+    explicit WiFiDhcpClient(const QString &interface, QObject *parent = nullptr);
+    ~WiFiDhcpClient();
+
+    QString interface() const;
+    State state() const;
+    WiFiDhcpLease lease() const;
+
+    /* 为 false 时只获取租约，不修改网络接口配置 */
+    bool isApplyLease() const;
+    void setApplyLease(bool apply);
+
+    /* 返回 BSSID 或 SSID 对应的缓存租约，二者都有时优先使用 BSSID 。 */
+    WiFiDhcpLease cachedLease(const QString &bssid, const QString &ssid) const;
+
+public slots:
+    /* 为 bssid/ssid 标识的网络获取租约，有缓存租约时先尝试 INIT-REBOOT 。 */
+    void start(const QString &bssid = QString(), const QString &ssid = QString());
+    /* 停止并移除接口地址，保留缓存租约，用于链路断开。 */
+    void stop();
+    /* 向服务器发送 DHCPRELEASE ，然后停止并丢弃缓存租约。 */
+    void release();
+
+signals:
+    void stateChanged(WiFiDhcpClient::State state);
+    void leaseObtained(const WiFiDhcpLease &lease);
+    void leaseLost();
+    void failed();
+
+private slots:
+    void onReadyRead();
+    void onRetransmit();
+    void onRenew();
+    void onRebind();
+    void onExpire();
+
+private:
+    bool openSocket();
+    void closeSocket();
+    void setState(State state);
+    void sendDiscover();
+    void sendRequest();
+    void sendRelease();
+    bool sendPacket(quint8 type, quint32 clientAddress, quint32 requestedAddress,
+                    quint32 serverId, quint32 destination);
+    void processPacket(const QByteArray &packet);
+    int retryDelay() const;
+    void enterInit();
+    void enterBound(WiFiDhcpLease lease);
+    void clearLease();
+    void stopTimers();
+
+    void loadLeases();
+    void saveLeases() const;
+    void cacheLease(const WiFiDhcpLease &lease);
+    void forgetLease();
+
+    QString m_interface;
+    QByteArray m_hwAddress;
+    bool m_applyLease = true;
+
+    State m_state = Stopped;
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = NULL;
+    QTimer *m_retransmitTimer = NULL;
+    QTimer *m_renewTimer = NULL;
+    QTimer *m_rebindTimer = NULL;
+    QTimer *m_expireTimer = NULL;
+    int m_tries = 0;
+    quint32 m_xid = 0;
+    qint64 m_startTime = 0; // msecs since epoch, 用于 secs 字段、超时和耗时统计
+
+    QString m_bssid;
+    QString m_ssid;
+    WiFiDhcpLease m_offer;  // 正在请求的地址
+    WiFiDhcpLease m_lease;  // 当前租约
+    QHash<QString, WiFiDhcpLease> m_leases; // BSSID/SSID -> 缓存租约
+};
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(WiFiDhcpLease)
+
+#endif // WIFIDHCPCLIENT_P_H
@@ -24,7 +24,7 @@
 
 QT_BEGIN_NAMESPACE
 
-class WiFiInfoPrivate
+class WiFiInfoPrivate : public QSharedData
 {
 public:
     WiFiInfoPrivate();
@@ -52,10 +52,13 @@ WiFiInfoPrivate::WiFiInfoPrivate() :
 /*!
     \class WiFiInfo
     \inmodule WiFi
+    \ingroup shared
     \brief 类 WiFiInfo 保存了关于 WiFi 连接的所有相关信息。
     \since 5.8
 
     该类描述任何处于活动状态或正在设置中的 WiFi 连接的状态。
+
+    WiFiInfo 是隐式共享的值类型：复制只增加引用计数，修改时才分离数据。
 */
 
 
@@ -63,7 +66,7 @@ WiFiInfoPrivate::WiFiInfoPrivate() :
     构造一个空的 WiFiInfo 对象。
 */
 WiFiInfo::WiFiInfo() :
-    d_ptr(new WiFiInfoPrivate)
+    d(new WiFiInfoPrivate)
 {
 }
 
@@ -71,9 +74,8 @@ WiFiInfo::WiFiInfo() :
     构造一个 WiFiInfo 对象，它是 \a other 的副本。
 */
 WiFiInfo::WiFiInfo(const WiFiInfo &other) :
-    d_ptr(new WiFiInfoPrivate)
+    d(other.d)
 {
-    *this = other;
 }
 
 /*!
@@ -81,7 +83,6 @@ WiFiInfo::WiFiInfo(const WiFiInfo &other) :
 */
 WiFiInfo::~WiFiInfo()
 {
-    delete d_ptr;
 }
 
 /*!
@@ -89,18 +90,7 @@ WiFiInfo::~WiFiInfo()
 */
 WiFiInfo &WiFiInfo::operator=(const WiFiInfo &other)
 {
-    Q_D(WiFiInfo);
-
-    d->address = other.d_func()->address;
-    d->bssid = other.d_func()->bssid;
-    d->ssid = other.d_func()->ssid;
-    d->rssi = other.d_func()->rssi;
-    d->frequency = other.d_func()->frequency;
-    d->ipAddress = other.d_func()->ipAddress;
-    d->networkId = other.d_func()->networkId;
-    d->rxLinkSpeedMbps = other.d_func()->rxLinkSpeedMbps;
-    d->txLinkSpeedMbps = other.d_func()->txLinkSpeedMbps;
-
+    d = other.d;
     return *this;
 }
 
@@ -111,17 +101,18 @@ WiFiInfo &WiFiInfo::operator=(const WiFiInfo &other)
   */
 bool WiFiInfo::operator==(const WiFiInfo &other) const
 {
-    Q_D(const WiFiInfo);
-
-    return d->address == other.d_func()->address &&
-           d->bssid == other.d_func()->bssid &&
-           d->ssid == other.d_func()->ssid &&
-           d->rssi == other.d_func()->rssi &&
-           d->frequency == other.d_func()->frequency &&
-           d->ipAddress == other.d_func()->ipAddress &&
-           d->networkId == other.d_func()->networkId &&
-           d->rxLinkSpeedMbps == other.d_func()->rxLinkSpeedMbps &&
-           d->txLinkSpeedMbps == other.d_func()->txLinkSpeedMbps;
+    if (d == other.d)
+        return true;
+
+    return d->address == other.d->address &&
+           d->bssid == other.d->bssid &&
+           d->ssid == other.d->ssid &&
+           d->rssi == other.d->rssi &&
+           d->frequency == other.d->frequency &&
+           d->ipAddress == other.d->ipAddress &&
+           d->networkId == other.d->networkId &&
+           d->rxLinkSpeedMbps == other.d->rxLinkSpeedMbps &&
+           d->txLinkSpeedMbps == other.d->txLinkSpeedMbps;
 }
 
 /*!
@@ -139,13 +130,11 @@ bool WiFiInfo::operator!=(const WiFiInfo &other) const
 */
 WiFiMacAddress WiFiInfo::macAddress() const
 {
-    Q_D(const WiFiInfo);
     return d->address;
 }
 
 void WiFiInfo::setMacAddress(const WiFiMacAddress &address)
 {
-    Q_D(WiFiInfo);
     d->address = address;
 }
 
@@ -154,13 +143,11 @@ void WiFiInfo::setMacAddress(const WiFiMacAddress &address)
 */
 WiFiMacAddress WiFiInfo::bssid() const
 {
-    Q_D(const WiFiInfo);
     return d->bssid;
 }
 
 void WiFiInfo::setBSSID(const WiFiMacAddress &bssid)
 {
-    Q_D(WiFiInfo);
     d->bssid = bssid;
 }
 
@@ -169,13 +156,11 @@ void WiFiInfo::setBSSID(const WiFiMacAddress &bssid)
 */
 QString WiFiInfo::ssid() const
 {
-    Q_D(const WiFiInfo);
     return d->ssid;
 }
 
 void WiFiInfo::setSSID(const QString &ssid)
 {
-    Q_D(WiFiInfo);
     d->ssid = ssid;
 }
 
@@ -184,7 +169,6 @@ void WiFiInfo::setSSID(const QString &ssid)
 */
 qint16 WiFiInfo::rssi() const
 {
-    Q_D(const WiFiInfo);
     return d->rssi;
 }
 
@@ -193,7 +177,6 @@ qint16 WiFiInfo::rssi() const
   */
 void WiFiInfo::setRssi(qint16 rssi)
 {
-    Q_D(WiFiInfo);
     d->rssi = rssi;
 }
 
@@ -202,7 +185,6 @@ void WiFiInfo::setRssi(qint16 rssi)
 */
 int WiFiInfo::frequency() const
 {
-    Q_D(const WiFiInfo);
     return d->frequency;
 }
 
@@ -211,7 +193,6 @@ int WiFiInfo::frequency() const
   */
 void WiFiInfo::setFrequency(int frequency)
 {
-    Q_D(WiFiInfo);
     d->frequency = frequency;
 }
 
@@ -220,7 +201,6 @@ void WiFiInfo::setFrequency(int frequency)
 */
 QString WiFiInfo::ipAddress() const
 {
-    Q_D(const WiFiInfo);
     return d->ipAddress;
 }
 
@@ -229,7 +209,6 @@ QString WiFiInfo::ipAddress() const
   */
 void WiFiInfo::setIpAddress(const QString &ipAddress)
 {
-    Q_D(WiFiInfo);
     d->ipAddress = ipAddress;
 }
 
@@ -238,7 +217,6 @@ void WiFiInfo::setIpAddress(const QString &ipAddress)
   */
 int WiFiInfo::networkId() const
 {
-    Q_D(const WiFiInfo);
     return d->networkId;
 }
 
@@ -247,7 +225,6 @@ int WiFiInfo::networkId() const
   */
 void WiFiInfo::setNetworkId(int id)
 {
-    Q_D(WiFiInfo);
     d->networkId = id;
 }
 
@@ -256,7 +233,6 @@ void WiFiInfo::setNetworkId(int id)
   */
 int WiFiInfo::rxLinkSpeed() const
 {
-    Q_D(const WiFiInfo);
     return d->rxLinkSpeedMbps;
 }
 
@@ -265,7 +241,6 @@ int WiFiInfo::rxLinkSpeed() const
   */
 void WiFiInfo::setRxLinkSpeed(int speed)
 {
-    Q_D(WiFiInfo);
     d->rxLinkSpeedMbps = speed;
 }
 
@@ -274,7 +249,6 @@ void WiFiInfo::setRxLinkSpeed(int speed)
   */
 int WiFiInfo::txLinkSpeed() const
 {
-    Q_D(const WiFiInfo);
     return d->txLinkSpeedMbps;
 }
 
@@ -283,13 +257,11 @@ int WiFiInfo::txLinkSpeed() const
   */
 void WiFiInfo::setTxLinkSpeed(int speed)
 {
-    Q_D(WiFiInfo);
     d->txLinkSpeedMbps = speed;
 }
 
 QString WiFiInfo::toString() const
 {
-    Q_D(const WiFiInfo);
     QString s(QStringLiteral("BSSID = %1\n"
                              "SSID  = %2\n"
                              "RSSI  = %3\n"
@@ -311,7 +283,6 @@ QString WiFiInfo::toString() const
 
 QVariantMap WiFiInfo::toMap() const
 {
-    Q_D(const WiFiInfo);
     QVariantMap map;
     map[QLatin1String("macAddress")] = d->address.toString();
     map[QLatin1String("bssid")] = d->bssid.toString();
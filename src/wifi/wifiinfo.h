@@ -20,6 +20,7 @@
 #define WIFIINFO_H
 
 #include <WiFi/wifiglobal.h>
+#include <QtCore/qshareddata.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -30,9 +31,18 @@ class WIFI_EXPORT WiFiInfo
 public:
     WiFiInfo();
     WiFiInfo(const WiFiInfo &other);
+#ifdef Q_COMPILER_RVALUE_REFS
+    WiFiInfo(WiFiInfo &&other) Q_DECL_NOTHROW : d(std::move(other.d)) {}
+#endif
     ~WiFiInfo();
 
     WiFiInfo &operator=(const WiFiInfo &other);
+#ifdef Q_COMPILER_RVALUE_REFS
+    WiFiInfo &operator=(WiFiInfo &&other) Q_DECL_NOTHROW
+    { swap(other); return *this; }
+#endif
+    void swap(WiFiInfo &other) Q_DECL_NOTHROW { qSwap(d, other.d); }
+
     bool operator==(const WiFiInfo &other) const;
     bool operator!=(const WiFiInfo &other) const;
 
@@ -72,13 +82,12 @@ public:
 
     static QString FrequencyUnits();
 
-protected:
-    WiFiInfoPrivate *d_ptr;
-
 private:
-    Q_DECLARE_PRIVATE(WiFiInfo)
+    QSharedDataPointer<WiFiInfoPrivate> d;
 };
 
+Q_DECLARE_SHARED(WiFiInfo)
+
 QT_END_NAMESPACE
 
 Q_DECLARE_METATYPE(WiFiInfo)
@@ -24,14 +24,6 @@
 
 QT_BEGIN_NAMESPACE
 
-class WiFiMacAddressPrivate
-{
-public:
-    WiFiMacAddressPrivate();
-
-    quint64 m_address;
-};
-
 /*!
     \class WiFiMacAddress
     \inmodule WiFi
@@ -39,172 +31,98 @@ public:
     \since 5.8
 
     该类以独立于平台和协议的方式保存 WiFi 地址。
-*/
-
-/*!
-    \fn inline bool WiFiMacAddress::operator!=(const WiFiMacAddress &other) const
-
-
-    将此 WiFi 地址与其他地址进行比较。
 
-    如果 WiFi 地址不相等，返回 true ，否则返回 false 。
+    WiFiMacAddress 只包含一个 quint64 ，可以平凡复制，构造时不分配内存。
 */
 
-static void registerWiFiMacAddressMetaType()
-{
-    static bool initDone = false;
-    if (!initDone) {
-        qRegisterMetaType<WiFiMacAddress>();
-        initDone = true;
-    }
-}
-
 /*!
+    \fn WiFiMacAddress::WiFiMacAddress()
+
     构造一个空的 WiFiMacAddress 对象。
 */
-WiFiMacAddress::WiFiMacAddress() :
-    d_ptr(new WiFiMacAddressPrivate)
-{
-    registerWiFiMacAddressMetaType();
-}
 
 /*!
+    \fn WiFiMacAddress::WiFiMacAddress(quint64 address)
+
     构造一个新的 WiFiMacAddress 对象并为其分配一个地址。
 */
-WiFiMacAddress::WiFiMacAddress(quint64 address) :
-    d_ptr(new WiFiMacAddressPrivate)
-{
-    registerWiFiMacAddressMetaType();
-
-    Q_D(WiFiMacAddress);
-    d->m_address = address;
-}
 
 /*!
+    \fn WiFiMacAddress::WiFiMacAddress(const QString &address)
+
     构造一个新的 WiFiMacAddress 对象并为其分配一个地址。
 
     地址 \a address 的格式可以是 XX:XX:XX:XX:XX:XX 或者 XXXXXXXXXXXX ，
-    其中 X 是一个十六进制数字。
+    其中 X 是一个十六进制数字。格式错误时构造一个空地址。
 */
-WiFiMacAddress::WiFiMacAddress(const QString &address) :
-    d_ptr(new WiFiMacAddressPrivate)
-{
-    registerWiFiMacAddressMetaType();
-
-    Q_D(WiFiMacAddress);
-
-    QString a = address;
-
-    if (a.length() == 17) {
-        a.remove(QLatin1Char(':'));
-    }
-
-    if (a.length() == 12) {
-        bool ok;
-        d->m_address = a.toULongLong(&ok, 16);
-        if (!ok) {
-            clear();
-        }
-    } else {
-        d->m_address = 0;
-    }
-}
 
 /*!
-    构造一个新的 WiFiMacAddress 对象，该对象是 \a other 的副本。
-*/
-WiFiMacAddress::WiFiMacAddress(const WiFiMacAddress &other) :
-    d_ptr(new WiFiMacAddressPrivate)
-{
-    *this = other;
-}
+    \fn WiFiMacAddress::WiFiMacAddress(QLatin1String address)
 
-/*!
-    销毁该 WiFiMacAddress 对象。
+    与 QString 版本相同，直接解析 Latin-1 字符，不进行编码转换。
 */
-WiFiMacAddress::~WiFiMacAddress()
-{
-    delete d_ptr;
-}
 
 /*!
-    将\a other分配到此 WiFiMacAddress 对象。
-*/
-WiFiMacAddress &WiFiMacAddress::operator=(const WiFiMacAddress &other)
-{
-    Q_D(WiFiMacAddress);
-
-    d->m_address = other.d_func()->m_address;
+    \fn void WiFiMacAddress::clear()
 
-    return *this;
-}
-
-/*!
     将 WiFi 地址设置为 00:00:00:00:00。
 */
-void WiFiMacAddress::clear()
-{
-    Q_D(WiFiMacAddress);
-    d->m_address = 0;
-}
 
 /*!
+    \fn bool WiFiMacAddress::isNull() const
+
     如果 WiFi 地址为空，返回 true ，否则返回 false 。
 */
-bool WiFiMacAddress::isNull() const
-{
-    Q_D(const WiFiMacAddress);
-    return d->m_address == 0;
-}
 
 /*!
+    \fn bool WiFiMacAddress::operator<(const WiFiMacAddress &other) const
+
     如果 WiFi 地址小于 \a other ，则返回 true ，否则返回 false 。
 */
-bool WiFiMacAddress::operator<(const WiFiMacAddress &other) const
-{
-    Q_D(const WiFiMacAddress);
-    return d->m_address < other.d_func()->m_address;
-}
 
 /*!
+    \fn bool WiFiMacAddress::operator==(const WiFiMacAddress &other) const
+
     将此 WiFi 地址与 \a other 地址进行比较。
 
     如果两个 WiFi 地址相等，返回 true ，否则返回 false 。
 */
-bool WiFiMacAddress::operator==(const WiFiMacAddress &other) const
-{
-    Q_D(const WiFiMacAddress);
-    return d->m_address == other.d_func()->m_address;
-}
 
 /*!
+    \fn inline bool WiFiMacAddress::operator!=(const WiFiMacAddress &other) const
+
+    将此 WiFi 地址与其他地址进行比较。
+
+    如果 WiFi 地址不相等，返回 true ，否则返回 false 。
+*/
+
+/*!
+    \fn quint64 WiFiMacAddress::toUInt64() const
+
     返回此 WiFi 地址为 quint64 类型格式。
 */
-quint64 WiFiMacAddress::toUInt64() const
+
+/*!
+    \fn uint qHash(const WiFiMacAddress &key, uint seed)
+    \relates WiFiMacAddress
+
+    返回 \a key 的哈希值，可用作 QHash 和 QSet 的键。
+*/
+
+static void registerWiFiMacAddressMetaType()
 {
-    Q_D(const WiFiMacAddress);
-    return d->m_address;
+    qRegisterMetaType<WiFiMacAddress>();
 }
+Q_CONSTRUCTOR_FUNCTION(registerWiFiMacAddressMetaType)
 
 /*!
     以格式化的字符串形式返回 WiFi 地址，XX:XX:XX:XX:XX:XX 。
 */
 QString WiFiMacAddress::toString() const
 {
-    Q_D(const WiFiMacAddress);
-    QString s(QStringLiteral("%1:%2:%3:%4:%5:%6"));
-
-    for (int i = 5; i >= 0; --i) {
-        const quint8 a = (d->m_address >> (i * 8)) & 0xff;
-        s = s.arg(a, 2, 16, QLatin1Char('0'));
-    }
-
-    return s.toUpper();
-}
-
-WiFiMacAddressPrivate::WiFiMacAddressPrivate()
-{
-    m_address = 0;
+    QString s(17, Qt::Uninitialized);
+    format(m_address, reinterpret_cast<ushort *>(s.data()));
+    return s;
 }
 
 #ifndef QT_NO_DEBUG_STREAM
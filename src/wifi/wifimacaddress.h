@@ -15,7 +15,6 @@
  ** You should have received a copy of the GNU General Public License
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  **/
-
 #ifndef WIFIMACADDRESS_H
 #define WIFIMACADDRESS_H
 
@@ -23,37 +22,112 @@
 
 #include <QtCore/QByteArray>
 #include <QtCore/QString>
+#include <QtCore/QHash>
 #include <QtCore/QMetaType>
 
 QT_BEGIN_NAMESPACE
 
-class WiFiMacAddressPrivate;
-
 class WIFI_EXPORT WiFiMacAddress
 {
 public:
-    WiFiMacAddress();
-    explicit WiFiMacAddress(quint64 address);
-    explicit WiFiMacAddress(const QString &address);
-    WiFiMacAddress(const WiFiMacAddress &other);
-    ~WiFiMacAddress();
-    WiFiMacAddress &operator=(const WiFiMacAddress &other);
-    bool isNull() const;
-    void clear();
-    bool operator<(const WiFiMacAddress &other) const;
-    bool operator==(const WiFiMacAddress &other) const;
-    inline bool operator!=(const WiFiMacAddress &other) const
+    Q_DECL_CONSTEXPR WiFiMacAddress() Q_DECL_NOTHROW : m_address(0) {}
+    explicit Q_DECL_CONSTEXPR WiFiMacAddress(quint64 address) Q_DECL_NOTHROW
+        : m_address(address) {}
+    explicit WiFiMacAddress(const QString &address) Q_DECL_NOTHROW
+        : m_address(parse(reinterpret_cast<const ushort *>(address.constData()),
+                           address.size())) {}
+    explicit Q_DECL_RELAXED_CONSTEXPR WiFiMacAddress(QLatin1String address) Q_DECL_NOTHROW
+        : m_address(parse(address.data(), address.size())) {}
+
+    Q_DECL_CONSTEXPR bool isNull() const Q_DECL_NOTHROW
+    {
+        return m_address == 0;
+    }
+    Q_DECL_RELAXED_CONSTEXPR void clear() Q_DECL_NOTHROW
+    {
+        m_address = 0;
+    }
+
+    Q_DECL_CONSTEXPR bool operator<(const WiFiMacAddress &other) const Q_DECL_NOTHROW
+    {
+        return m_address < other.m_address;
+    }
+    Q_DECL_CONSTEXPR bool operator==(const WiFiMacAddress &other) const Q_DECL_NOTHROW
+    {
+        return m_address == other.m_address;
+    }
+    Q_DECL_CONSTEXPR bool operator!=(const WiFiMacAddress &other) const Q_DECL_NOTHROW
+    {
+        return m_address != other.m_address;
+    }
+
+    Q_DECL_CONSTEXPR quint64 toUInt64() const Q_DECL_NOTHROW
     {
-        return !operator==(other);
+        return m_address;
     }
-    quint64 toUInt64() const;
     QString toString() const;
 
+    /* 将 "XX:XX:XX:XX:XX:XX" 或 "XXXXXXXXXXXX" 解析为地址，格式错误时返回 0 */
+    template <typename Char>
+    static Q_DECL_RELAXED_CONSTEXPR quint64 parse(const Char *str, int length) Q_DECL_NOTHROW;
+    /* 将地址格式化为 "XX:XX:XX:XX:XX:XX" 写入 \a out ，固定写入 17 个字符 */
+    template <typename Char>
+    static Q_DECL_RELAXED_CONSTEXPR void format(quint64 address, Char *out) Q_DECL_NOTHROW;
+
 private:
-    Q_DECLARE_PRIVATE(WiFiMacAddress)
-    WiFiMacAddressPrivate *d_ptr;
+    static Q_DECL_CONSTEXPR int hexDigit(uint c) Q_DECL_NOTHROW
+    {
+        return c - '0' < 10u ? int(c - '0') :
+               (c | 0x20) - 'a' < 6u ? int((c | 0x20) - 'a' + 10) : -1;
+    }
+
+    quint64 m_address;
 };
 
+template <typename Char>
+Q_DECL_RELAXED_CONSTEXPR quint64 WiFiMacAddress::parse(const Char *str, int length) Q_DECL_NOTHROW
+{
+    if (length != 17 && length != 12) {
+        return 0;
+    }
+    const int step = length == 17 ? 3 : 2;
+    quint64 address = 0;
+    for (int i = 0; i < length; i += step) {
+        if (step == 3 && i + 2 < length && uint(str[i + 2]) != ':') {
+            return 0;
+        }
+        const int high = hexDigit(uint(str[i]));
+        const int low = hexDigit(uint(str[i + 1]));
+        if ((high | low) < 0) {
+            return 0;
+        }
+        address = (address << 8) | quint64(high << 4 | low);
+    }
+    return address;
+}
+
+template <typename Char>
+Q_DECL_RELAXED_CONSTEXPR void WiFiMacAddress::format(quint64 address, Char *out) Q_DECL_NOTHROW
+{
+    for (int i = 5; i >= 0; --i) {
+        const uint octet = uint(address >> (i * 8)) & 0xff;
+        const uint high = octet >> 4;
+        const uint low = octet & 0xf;
+        *out++ = Char(high < 10 ? '0' + high : 'A' + high - 10);
+        *out++ = Char(low < 10 ? '0' + low : 'A' + low - 10);
+        if (i > 0) {
+            *out++ = Char(':');
+        }
+    }
+}
+
+Q_DECLARE_TYPEINFO(WiFiMacAddress, Q_PRIMITIVE_TYPE);
+
+inline uint qHash(const WiFiMacAddress &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    return qHash(key.toUInt64(), seed);
+}
+
 #ifndef QT_NO_DEBUG_STREAM
     WIFI_EXPORT QDebug operator<<(QDebug, const WiFiMacAddress &address);
 #endif
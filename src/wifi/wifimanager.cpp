@@ -64,6 +64,9 @@ WiFiManager::WiFiManager(QObject * parent)
     connect(d->m_proxy, SIGNAL(scanResultFound(WiFiScanResult)), SIGNAL(scanResultFound(WiFiScanResult)));
     connect(d->m_proxy, SIGNAL(scanResultUpdated(WiFiScanResult)), SIGNAL(scanResultUpdated(WiFiScanResult)));
     connect(d->m_proxy, SIGNAL(scanResultLost(WiFiScanResult)), SIGNAL(scanResultLost(WiFiScanResult)));
+    connect(d->m_proxy,
+            SIGNAL(scanResultsDelta(WiFiScanResultList, WiFiScanResultList, WiFiScanResultList)),
+            SIGNAL(scanResultsDelta(WiFiScanResultList, WiFiScanResultList, WiFiScanResultList)));
     connect(d->m_proxy, SIGNAL(scanResultsChanged()), SIGNAL(scanResultsChanged()));
     connect(d->m_proxy, SIGNAL(networksChanged()), SIGNAL(networksChanged()));
 
@@ -75,6 +78,8 @@ WiFiManager::WiFiManager(QObject * parent)
             SIGNAL(networkConnected(int)));
     connect(d->m_proxy, SIGNAL(networkErrorOccurred(int)), this,
             SIGNAL(networkErrorOccurred(int)));
+    connect(d->m_proxy, SIGNAL(addNetworkFinished(int, int)), this,
+            SIGNAL(addNetworkFinished(int, int)));
 }
 
 bool WiFiManager::isWiFiServiced() const
@@ -173,6 +178,16 @@ int WiFiManager::addNetwork(const WiFiNetwork &network)
     Q_D(WiFiManager);
     return d->m_proxy->addNetwork(network);
 }
+
+/*!
+ * 异步添加网络，不等待服务端应答。返回请求 ID ，完成后发出
+ * addNetworkFinished(requestId, networkId) ，失败时 networkId 为 -1 。
+ */
+int WiFiManager::addNetworkAsync(const WiFiNetwork &network)
+{
+    Q_D(WiFiManager);
+    return d->m_proxy->addNetworkAsync(network);
+}
 void WiFiManager::selectNetwork(int networkId)
 {
     Q_D(WiFiManager);
@@ -51,6 +51,7 @@ public:
 
 public slots:
     int addNetwork(const WiFiNetwork &network);
+    int addNetworkAsync(const WiFiNetwork &network);
     void selectNetwork(int networkId);
     void removeNetwork(int networkId);
 
@@ -62,6 +63,9 @@ signals:
     void scanResultFound(const WiFiScanResult &result);
     void scanResultUpdated(const WiFiScanResult &result);
     void scanResultLost(const WiFiScanResult &result);
+    void scanResultsDelta(const WiFiScanResultList &added,
+                          const WiFiScanResultList &updated,
+                          const WiFiScanResultList &removed);
     void scanResultsChanged();
     void networksChanged();
 
@@ -70,6 +74,8 @@ signals:
     void networkConnected(int networkId);
     void networkErrorOccurred(int networkId);
 
+    void addNetworkFinished(int requestId, int networkId);
+
 private:
     Q_DECLARE_PRIVATE(WiFiManager)
 };
@@ -21,12 +21,75 @@
 
 #include "common/wpa_ctrl.h"
 
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qjsondocument.h>
+
 // in a header
 Q_DECLARE_LOGGING_CATEGORY(logNat)
 // in one source file
 Q_LOGGING_CATEGORY(logNat, "wifi.native", QtInfoMsg)
 
+#ifndef WPA_EVENT_NETWORK_ADDED
+#define WPA_EVENT_NETWORK_ADDED "CTRL-EVENT-NETWORK-ADDED "
+#endif
+#ifndef WPA_EVENT_NETWORK_REMOVED
+#define WPA_EVENT_NETWORK_REMOVED "CTRL-EVENT-NETWORK-REMOVED "
+#endif
+
 static int WIFI_NATIVE_NETWORK_TIMEOUT = 25; // seconds
+static int WIFI_NATIVE_INFO_INTERVAL = 60; // seconds, 0 表示关闭兜底轮询
+static const int WIFI_NATIVE_ACQUIRE_INTERVAL = 1000; // msecs
+/* 扫描结果与网络列表的快照，服务重启后在 wpa_supplicant 就绪前先行显示 */
+static QByteArray WIFI_NATIVE_SNAPSHOT = "/var/run/wifi/native.json";
+static const int WIFI_NATIVE_SNAPSHOT_DELAY = 2000; // msecs, 合并连续的变化再写入
+static const int WIFI_NATIVE_SNAPSHOT_VERSION = 1;
+static const int WIFI_NATIVE_BSS_RETRY = 100; // msecs, BSS 获取无进展时的首次重试间隔，之后加倍
+static const int WIFI_NATIVE_BSS_RETRIES = 5;
+
+/* 与 common/defs.h 中的 enum wpa_states 取值保持一致 */
+static const int WIFI_WPA_DISCONNECTED = 0;
+static const int WIFI_WPA_INACTIVE = 2;
+static const int WIFI_WPA_COMPLETED = 9;
+
+static bool equalNetworks(const WiFiNetworkList &a, const WiFiNetworkList &b)
+{
+    if(a.length() != b.length()) {
+        return false;
+    }
+    for(int i = 0; i < a.length(); ++i) {
+        if(a.at(i).networkId() != b.at(i).networkId() ||
+           a.at(i).ssid() != b.at(i).ssid() ||
+           a.at(i).bssid() != b.at(i).bssid() ||
+           a.at(i).preSharedKey() != b.at(i).preSharedKey() ||
+           a.at(i).authFlags() != b.at(i).authFlags() ||
+           a.at(i).encrFlags() != b.at(i).encrFlags()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 从事件消息中取出 key=value 形式的值，例如：
+ * CTRL-EVENT-SIGNAL-CHANGE above=1 signal=-60 noise=-95 txrate=65000
+ */
+static QString wifiEventValue(const QString &msg, const QString &key)
+{
+    const QString prefix = key + QLatin1Char('=');
+    int start = msg.indexOf(prefix);
+    while(start > 0 && msg.at(start - 1) != QLatin1Char(' ')
+          && msg.at(start - 1) != QLatin1Char('[')) {
+        start = msg.indexOf(prefix, start + 1);
+    }
+    if(start < 0) {
+        return QString();
+    }
+    start += prefix.length();
+    int end = msg.indexOf(QLatin1Char(' '), start);
+    return msg.mid(start, end < 0 ? -1 : end - start);
+}
 
 /*!
     \class WiFiNative
@@ -48,6 +111,16 @@ WiFiNativePrivate::WiFiNativePrivate()
             WIFI_NATIVE_NETWORK_TIMEOUT = timeout;
         }
     }
+    if(!qEnvironmentVariableIsEmpty("WIFI_NATIVE_INFO_INTERVAL")) {
+        bool ok;
+        int interval = qgetenv("WIFI_NATIVE_INFO_INTERVAL").toInt(&ok);
+        if(ok && interval >= 0) {
+            WIFI_NATIVE_INFO_INTERVAL = interval;
+        }
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_NATIVE_SNAPSHOT")) {
+        WIFI_NATIVE_SNAPSHOT = qgetenv("WIFI_NATIVE_SNAPSHOT");
+    }
 }
 
 WiFiNativePrivate::~WiFiNativePrivate()
@@ -59,50 +132,135 @@ void WiFiNativePrivate::syncWiFiNetworks()
     Q_Q(WiFiNative);
 
     WiFiNetworkList list = parser.fromListNetworks(tool->list_networks());
-    m_networks.clear();
+
+    QList<int> ids;
+    QSet<int> listed;
+    for(const WiFiNetwork &network : list) {
+        int id = network.networkId();
+        listed.insert(id);
+        const auto it = m_networkCache.constFind(id);
+        if(it == m_networkCache.constEnd() || it->ssid() != network.ssid() ||
+           it->bssid() != network.bssid()) {
+            ids << id;
+        }
+    }
+    for(auto it = m_networkCache.begin(); it != m_networkCache.end();) {
+        if(listed.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_networkCache.erase(it);
+        }
+    }
+    for(const WiFiNetwork &network : list) {
+        if(ids.contains(network.networkId())) {
+            m_networkCache.insert(network.networkId(), network);
+        }
+    }
+    this->fetchNetworkDetails(ids);
+
+    WiFiNetworkList networks;
     WiFiNetwork wlan(m_info.networkId(), m_info.ssid());
     if(wlan.isValid()) {
+        if(!listed.contains(wlan.networkId())) {
+            // 当前连接的网络不在列表中时，单独获取其配置
+            m_networkCache.insert(wlan.networkId(), wlan);
+            this->fetchNetworkDetails(QList<int>() << wlan.networkId());
+        }
+        const WiFiNetwork &cached = m_networkCache.value(wlan.networkId());
         wlan.setBSSID(m_info.bssid());
-        int id = wlan.networkId();
-        QString proto = tool->get_network(id, QStringLiteral("proto"));
-        QString key_mgmt = tool->get_network(id, QStringLiteral("key_mgmt"));
-        QString pairwise = tool->get_network(id, QStringLiteral("pairwise"));
-        QString psk = tool->get_network(id, QStringLiteral("psk"));
-        wlan.setPreSharedKey(psk);
-        wlan.setAuthFlags(parser.fromProtoKeyMgmt(proto, key_mgmt));
-        wlan.setEncrFlags(parser.fromPairwise(pairwise));
-        m_networks << wlan;
-    }
-    for(int i = 0; i < list.length(); ++i) {
-        WiFiNetwork network = list.at(i);
-        int id = network.networkId();
-        WiFiMacAddress bssid = WiFiMacAddress(tool->get_network(id,
-                                              QStringLiteral("bssid")));
-        QString proto = tool->get_network(id, QStringLiteral("proto"));
-        QString key_mgmt = tool->get_network(id, QStringLiteral("key_mgmt"));
-        QString pairwise = tool->get_network(id, QStringLiteral("pairwise"));
-        QString psk = tool->get_network(id, QStringLiteral("psk"));
-        network.setBSSID(bssid);
-        network.setPreSharedKey(psk);
-        network.setAuthFlags(parser.fromProtoKeyMgmt(proto, key_mgmt));
-        network.setEncrFlags(parser.fromPairwise(pairwise));
-
-        if(!m_networks.contains(network)) {
-            m_networks << network;
+        wlan.setPreSharedKey(cached.preSharedKey());
+        wlan.setAuthFlags(cached.authFlags());
+        wlan.setEncrFlags(cached.encrFlags());
+        networks << wlan;
+        if(!listed.contains(wlan.networkId())) {
+            m_networkCache.remove(wlan.networkId());
+        }
+    }
+    for(const WiFiNetwork &network : list) {
+        const WiFiNetwork &cached = m_networkCache.value(network.networkId());
+        if(!networks.contains(cached)) {
+            networks << cached;
         }
+    }
 
+    if(!equalNetworks(networks, m_networks)) {
+        m_networks = networks;
+        Q_EMIT q->networksChanged();
+        this->updateAssociationIndex();
+        this->scheduleSaveSnapshot();
     }
-    Q_EMIT q->networksChanged();
 }
 
-void WiFiNativePrivate::_q_updateInfoTimeout()
+/* 以流水线方式批量获取网络配置，结果写入 m_networkCache 。
+ */
+void WiFiNativePrivate::fetchNetworkDetails(const QList<int> &ids)
+{
+    if(ids.isEmpty()) {
+        return;
+    }
+
+    static const QStringList variables = QStringList()
+                                         << QStringLiteral("proto")
+                                         << QStringLiteral("key_mgmt")
+                                         << QStringLiteral("pairwise")
+                                         << QStringLiteral("psk");
+    QList<QStringList> values = tool->get_networks(ids, variables);
+    for(int i = 0; i < ids.length(); ++i) {
+        const QStringList &value = values.at(i);
+        WiFiNetwork &network = m_networkCache[ids.at(i)];
+        network.setPreSharedKey(value.at(3));
+        network.setAuthFlags(parser.fromProtoKeyMgmt(value.at(0), value.at(1)));
+        network.setEncrFlags(parser.fromPairwise(value.at(2)));
+    }
+    qCDebug(logNat, "[ DEBUG ] Fetched %d network(s) configuration.", ids.length());
+}
+
+/* 异步获取 STATUS 更新连接信息，请求未完成时的再次调用会合并为一次。
+ */
+void WiFiNativePrivate::updateConnectionInfo()
+{
+    Q_Q(WiFiNative);
+
+    if(m_statusPending) {
+        m_statusDirty = true;
+        return;
+    }
+
+    m_statusPending = true;
+    tool->status(q, [this](const QByteArray & reply) {
+        m_statusPending = false;
+        if(m_state != WiFi::StateEnabled) {
+            m_statusDirty = false;
+            return;
+        }
+        if(!reply.isEmpty()) {
+            WiFiInfo info = parser.fromStatus(reply);
+            if(info.bssid() == m_info.bssid()) {
+                // STATUS 不包含信号强度，沿用 CTRL-EVENT-SIGNAL-CHANGE 上报的值
+                info.setRssi(m_info.rssi());
+                info.setTxLinkSpeed(m_info.txLinkSpeed());
+            }
+            this->applyConnectionInfo(info);
+        }
+        if(m_statusDirty) {
+            m_statusDirty = false;
+            this->updateConnectionInfo();
+        }
+    });
+}
+
+void WiFiNativePrivate::applyConnectionInfo(const WiFiInfo &info)
 {
     Q_Q(WiFiNative);
 
-    WiFiInfo info = parser.fromStatus(tool->status());
     bool ipChanged = m_info.ipAddress() != info.ipAddress();
+    bool linkChanged = m_info.networkId() != info.networkId() ||
+                       m_info.bssid() != info.bssid();
     if(info != m_info) {
         m_info = info;
+        if(m_info.networkId() >= 0) {
+            m_selectedNetworkId = m_info.networkId();
+        }
         qCDebug(logNat, "[ DEBUG ] ConnectionInfo:\n%s",
                 qUtf8Printable(m_info.toString()));
         Q_EMIT q->connectionInfoChanged();
@@ -120,18 +278,356 @@ void WiFiNativePrivate::_q_updateInfoTimeout()
         Q_EMIT q->networkConnected(m_info.networkId());
     }
 
-    this->syncWiFiNetworks();
+    if(linkChanged) {
+        // 当前连接的网络会携带 BSSID ，连接变化时需要重新同步网络列表
+        this->scheduleSyncNetworks();
+    }
+
+    this->updateInfoTimer();
+}
+
+/* 连接信息由 monitor 事件驱动更新，timer_Info 仅作为兜底的慢速轮询：
+ * 已关联但尚未获取 IP 时按 WIFI_NATIVE_ACQUIRE_INTERVAL 快速刷新，
+ * 其余时间按 WIFI_NATIVE_INFO_INTERVAL 刷新。
+ */
+void WiFiNativePrivate::updateInfoTimer()
+{
+    if(!timer_Info || m_state != WiFi::StateEnabled) {
+        return;
+    }
+
+    bool acquiring = m_info.networkId() >= 0 && m_info.ipAddress().isEmpty();
+    int interval = acquiring ? WIFI_NATIVE_ACQUIRE_INTERVAL :
+                   WIFI_NATIVE_INFO_INTERVAL * 1000;
+    if(interval <= 0) {
+        timer_Info->stop();
+    } else if(!timer_Info->isActive() || timer_Info->interval() != interval) {
+        timer_Info->start(interval);
+    }
+}
+
+void WiFiNativePrivate::scheduleSyncNetworks()
+{
+    if(timer_Sync && !timer_Sync->isActive()) {
+        timer_Sync->start();
+    }
+}
+
+/* 根据 m_networks 重建网络与扫描结果的关联索引：BSSID 或 SSID -> 网络在列表中的
+ * 位置，与 compare() 一致，指定了 BSSID 的网络只按 BSSID 关联，同一个键只保留
+ * 列表中最靠前的网络。只重新计算关联发生变化的键所对应的扫描结果，并且只在
+ * 扫描结果的网络 id 实际变化时发出 scanResultUpdated 。
+ */
+void WiFiNativePrivate::updateAssociationIndex()
+{
+    Q_Q(WiFiNative);
+
+    QHash<quint64, WiFiAssociation> byBssid;
+    QHash<QString, WiFiAssociation> bySsid;
+    for(int i = 0; i < m_networks.length(); ++i) {
+        const WiFiNetwork &network = m_networks.at(i);
+        const WiFiAssociation association(i, network.networkId());
+        if(!network.bssid().isNull()) {
+            if(!byBssid.contains(network.bssid().toUInt64())) {
+                byBssid.insert(network.bssid().toUInt64(), association);
+            }
+        } else if(!bySsid.contains(network.ssid())) {
+            bySsid.insert(network.ssid(), association);
+        }
+    }
 
-    for(int i = 0; i < m_scanResults.length(); ++i) {
-        int id = getNetworkByScanResult(m_scanResults[i]).networkId();
+    QSet<WiFiScanResultStore::Handle> affected;
+    for(auto it = byBssid.constBegin(); it != byBssid.constEnd(); ++it) {
+        if(!(m_assocByBssid.value(it.key()) == it.value())) {
+            affected.insert(m_scanResults.find(it.key()));
+        }
+    }
+    for(auto it = m_assocByBssid.constBegin(); it != m_assocByBssid.constEnd(); ++it) {
+        if(!byBssid.contains(it.key())) {
+            affected.insert(m_scanResults.find(it.key()));
+        }
+    }
+    for(auto it = bySsid.constBegin(); it != bySsid.constEnd(); ++it) {
+        if(!(m_assocBySsid.value(it.key()) == it.value())) {
+            for(WiFiScanResultStore::Handle handle : m_scanResults.findBySsid(it.key())) {
+                affected.insert(handle);
+            }
+        }
+    }
+    for(auto it = m_assocBySsid.constBegin(); it != m_assocBySsid.constEnd(); ++it) {
+        if(!bySsid.contains(it.key())) {
+            for(WiFiScanResultStore::Handle handle : m_scanResults.findBySsid(it.key())) {
+                affected.insert(handle);
+            }
+        }
+    }
+    affected.remove(-1);
+
+    m_assocByBssid = byBssid;
+    m_assocBySsid = bySsid;
 
-        if(m_scanResults[i].networkId() != id) {
+    for(WiFiScanResultStore::Handle handle : qAsConst(affected)) {
+        const WiFiScanResult &result = m_scanResults.at(handle);
+        int id = getNetworkByScanResult(result).networkId();
+
+        if(result.networkId() != id) {
             qCDebug(logNat, "[ DEBUG ] Update ScanResult NetworkId (%s = %d) ",
-                    qUtf8Printable(m_scanResults[i].ssid()), id);
-            m_scanResults[i].setNetworkId(id);
-            Q_EMIT q->scanResultUpdated(m_scanResults[i]);
+                    qUtf8Printable(result.ssid()), id);
+            m_scanResults.setNetworkId(handle, id);
+            Q_EMIT q->scanResultUpdated(result);
+        }
+    }
+}
+
+/* 将 BSS RANGE 获取到的扫描结果加入扫描列表，快照中缓存的同一 BSS 被新结果替换。
+ */
+void WiFiNativePrivate::addScanResults(const WiFiScanResultList &results)
+{
+    Q_Q(WiFiNative);
+
+    bool changed = false;
+    for(WiFiScanResult result : results) {
+        if(!result.isValid() || result.bssid().isNull()) {
+            continue;
+        }
+        WiFiScanResultStore::Handle handle = m_scanResults.find(result.bssid());
+        if(handle < 0) {
+            int id = getNetworkByScanResult(result).networkId();
+            result.setNetworkId(id);
+
+            m_scanResults.insert(result);
+            Q_EMIT q->scanResultFound(result);
+            changed = true;
+        } else if(m_scanResults.at(handle).isCached() && !result.isCached()) {
+            int id = getNetworkByScanResult(result).networkId();
+            result.setNetworkId(id);
+
+            m_scanResults.update(handle, result);
+            Q_EMIT q->scanResultUpdated(result);
+            changed = true;
+        }
+    }
+    if(changed) {
+        this->scheduleSaveSnapshot();
+    }
+}
+
+/* 移除仍未被新结果替换的缓存扫描结果，在 wpa_supplicant 的扫描结果全部获取后调用。
+ */
+void WiFiNativePrivate::dropCachedScanResults()
+{
+    Q_Q(WiFiNative);
+
+    m_dropCachedPending = false;
+    int dropped = 0;
+    for(WiFiScanResultStore::Handle handle : m_scanResults.handles()) {
+        if(m_scanResults.at(handle).isCached()) {
+            Q_EMIT q->scanResultLost(m_scanResults.take(handle));
+            dropped++;
+        }
+    }
+    if(dropped > 0) {
+        qCDebug(logNat, "[ DEBUG ] Drop %d cached scan result(s).", dropped);
+        this->scheduleSaveSnapshot();
+    }
+}
+
+/* 从快照恢复扫描结果和网络列表，均标记为缓存数据，
+ * 由 wpa_supplicant 的 BSS 表或下一次扫描结果替换。
+ */
+void WiFiNativePrivate::loadSnapshot()
+{
+    Q_Q(WiFiNative);
+
+    if(!m_scanResults.isEmpty() || !m_networks.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    const QString path = QString::fromLocal8Bit(WIFI_NATIVE_SNAPSHOT);
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if(error.error != QJsonParseError::NoError) {
+        qCWarning(logNat, "[FAIL] Load snapshot %s: %s", qUtf8Printable(path),
+                  qUtf8Printable(error.errorString()));
+        return;
+    }
+    const QVariantMap map = doc.toVariant().toMap();
+    if(map.value(QStringLiteral("version")).toInt() != WIFI_NATIVE_SNAPSHOT_VERSION) {
+        return;
+    }
+
+    WiFiNetworkList networks = WiFiNetworkList::fromMapList(
+                                   map.value(QStringLiteral("networks")).toList());
+    for(WiFiNetwork &network : networks) {
+        network.setCached(true);
+    }
+    if(!networks.isEmpty()) {
+        m_networks = networks;
+        Q_EMIT q->networksChanged();
+        this->updateAssociationIndex();
+    }
+
+    WiFiScanResultList results = WiFiScanResultList::fromMapList(
+                                     map.value(QStringLiteral("scanResults")).toList());
+    for(WiFiScanResult &result : results) {
+        result.setCached(true);
+    }
+    this->addScanResults(results);
+
+    qCInfo(logNat, "[ OK ] Restore %d scan result(s), %d network(s) from snapshot.%s",
+           m_scanResults.count(), m_networks.length(), wifiPrintTimes(elapsed.elapsed()));
+}
+
+/* 快照不保存密码，密码在 wpa_supplicant 就绪后重新获取。
+ */
+void WiFiNativePrivate::saveSnapshot()
+{
+    if(m_state != WiFi::StateEnabled) {
+        return;
+    }
+
+    const QString path = QString::fromLocal8Bit(WIFI_NATIVE_SNAPSHOT);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    WiFiNetworkList networks = m_networks;
+    for(WiFiNetwork &network : networks) {
+        network.setPreSharedKey(QString());
+    }
+    QVariantMap map;
+    map[QLatin1String("version")] = WIFI_NATIVE_SNAPSHOT_VERSION;
+    map[QLatin1String("networks")] = networks.toMapList();
+    map[QLatin1String("scanResults")] = m_scanResults.toList().toMapList();
+
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly) ||
+       file.write(QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact)) < 0 ||
+       !file.commit()) {
+        qCWarning(logNat, "[FAIL] Save snapshot %s: %s", qUtf8Printable(path),
+                  qUtf8Printable(file.errorString()));
+    }
+}
+
+void WiFiNativePrivate::scheduleSaveSnapshot()
+{
+    if(timer_Save && m_state == WiFi::StateEnabled && !timer_Save->isActive()) {
+        timer_Save->start();
+    }
+}
+
+/* 以 BSS RANGE 分块异步获取 m_pendingBssIds 中的 BSS ，每次回复受控制接口缓冲区
+ * 限制只包含部分 BSS ，从剩余的最小 id 继续获取，直到全部获取完成。
+ * m_bssWalkFrom >= 0 时先从该 id 继续遍历整个 BSS 表(启动时同步遍历未完成)。
+ *
+ * 只有回复中返回的 id 和收到 CTRL-EVENT-BSS-REMOVED 的 id 才从集合中移除；
+ * 回复失败、为空或没有进展时保留集合，按 WIFI_NATIVE_BSS_RETRY 加倍退避重试，
+ * 连续 WIFI_NATIVE_BSS_RETRIES 次仍无进展才放弃剩余的 id 。
+ */
+void WiFiNativePrivate::fetchScanResults()
+{
+    Q_Q(WiFiNative);
+
+    if(m_bssRangePending || (m_pendingBssIds.isEmpty() && m_bssWalkFrom < 0)) {
+        return;
+    }
+
+    int first = m_bssWalkFrom;
+    int last = -1;
+    if(m_bssWalkFrom < 0) {
+        first = *m_pendingBssIds.constBegin();
+        last = first;
+        for(int id : qAsConst(m_pendingBssIds)) {
+            first = qMin(first, id);
+            last = qMax(last, id);
         }
     }
+
+    m_bssRangePending = true;
+    tool->bss_range(first, last, q, [this](const QByteArray & reply) {
+        m_bssRangePending = false;
+        if(m_state != WiFi::StateEnabled) {
+            m_pendingBssIds.clear();
+            m_bssWalkFrom = -1;
+            m_bssRetries = 0;
+            return;
+        }
+
+        QList<int> ids;
+        bool finished;
+        WiFiScanResultList results = parser.fromBSSRange(reply, &ids, &finished);
+        const bool walking = m_bssWalkFrom >= 0;
+        bool progress = false;
+        WiFiScanResultList added;
+        for(int i = 0; i < ids.length(); ++i) {
+            if(m_pendingBssIds.remove(ids.at(i))) {
+                progress = true;
+                added << results.at(i);
+            } else if(walking) {
+                added << results.at(i);
+            }
+        }
+        this->addScanResults(added);
+
+        if(walking && finished) {
+            // BSS 表遍历完成，未被替换的缓存结果已经过时
+            m_bssWalkFrom = -1;
+            progress = true;
+            this->dropCachedScanResults();
+        } else if(walking && !ids.isEmpty()) {
+            m_bssWalkFrom = ids.last() + 1;
+            progress = true;
+        }
+
+        if(progress) {
+            m_bssRetries = 0;
+            this->fetchScanResults();
+        } else if(m_bssRetries < WIFI_NATIVE_BSS_RETRIES) {
+            timer_Bss->start(WIFI_NATIVE_BSS_RETRY << m_bssRetries);
+            m_bssRetries++;
+        } else {
+            qCWarning(logNat, "[FAIL] Fetch %d BSS(s) failed after %d attempts.",
+                      m_pendingBssIds.size() + (walking ? 1 : 0), m_bssRetries + 1);
+            m_pendingBssIds.clear();
+            m_bssWalkFrom = -1;
+            m_bssRetries = 0;
+        }
+
+        if(m_dropCachedPending && !m_bssRangePending && m_pendingBssIds.isEmpty() &&
+           m_bssWalkFrom < 0) {
+            this->dropCachedScanResults();
+        }
+    });
+}
+
+void WiFiNativePrivate::_q_updateInfoTimeout()
+{
+    this->updateConnectionInfo();
+    this->syncWiFiNetworks();
+}
+
+void WiFiNativePrivate::_q_fetchScanResultsTimeout()
+{
+    this->fetchScanResults();
+}
+
+void WiFiNativePrivate::_q_saveSnapshotTimeout()
+{
+    this->saveSnapshot();
+}
+
+void WiFiNativePrivate::_q_syncNetworksTimeout()
+{
+    if(m_state != WiFi::StateEnabled) {
+        return;
+    }
+
+    this->syncWiFiNetworks();
 }
 
 void WiFiNativePrivate::_q_autoScanTimeout()
@@ -156,11 +652,17 @@ void WiFiNativePrivate::onSupplicantStarted()
 {
     Q_Q(WiFiNative);
 
-    if(m_state != WiFi::StateEnabling) {
+    if(m_state == WiFi::StateDisabled) {
+        // 禁用前已经开始的重新启动仍然完成了，断开其自动发起的连接
+        tool->disconnect();
+        return;
+    }
+    if(m_state != WiFi::StateEnabling && !m_recovering) {
         return;
     }
 
-    tool->reassociate();
+    const bool recovered = m_recovering;
+    m_recovering = false;
     m_state = WiFi::StateEnabled;
 
     if(!timer_Scan) {
@@ -181,20 +683,63 @@ void WiFiNativePrivate::onSupplicantStarted()
 
     if(!timer_Info) {
         timer_Info = new QTimer(q);
-        timer_Info->setInterval(1000);
+        timer_Info->setInterval(WIFI_NATIVE_INFO_INTERVAL * 1000);
         timer_Info->connect(timer_Info, SIGNAL(timeout()), q,
                             SLOT(_q_updateInfoTimeout()));
     }
 
+    if(!timer_Bss) {
+        timer_Bss = new QTimer(q);
+        timer_Bss->setSingleShot(true);
+        timer_Bss->setInterval(0);
+        timer_Bss->connect(timer_Bss, SIGNAL(timeout()), q,
+                           SLOT(_q_fetchScanResultsTimeout()));
+    }
+
+    if(!timer_Sync) {
+        timer_Sync = new QTimer(q);
+        timer_Sync->setSingleShot(true);
+        timer_Sync->setInterval(0);
+        timer_Sync->connect(timer_Sync, SIGNAL(timeout()), q,
+                            SLOT(_q_syncNetworksTimeout()));
+    }
+
+    if(!timer_Save) {
+        timer_Save = new QTimer(q);
+        timer_Save->setSingleShot(true);
+        timer_Save->setInterval(WIFI_NATIVE_SNAPSHOT_DELAY);
+        timer_Save->connect(timer_Save, SIGNAL(timeout()), q,
+                            SLOT(_q_saveSnapshotTimeout()));
+    }
+
     this->initWiFiNativeInfo();
 
-    timer_Info->start();
+    if(m_info.networkId() < 0) {
+        if(recovered && getNetworkById(m_selectedNetworkId).isValid()) {
+            // 重新启动后恢复之前选择的网络
+            tool->select_network(m_selectedNetworkId);
+        } else {
+            tool->reassociate();
+        }
+    } else {
+        // 连接到已在运行的 wpa_supplicant 时沿用其当前关联，不重新关联
+        qCInfo(logNat, "[ OK ] Network(%d, %s) association reused."
+               , m_info.networkId(), qUtf8Printable(m_info.ssid()));
+    }
+
+    this->updateInfoTimer();
 
-    if(m_isAutoScan) {
+    // 恢复时总是扫描一次，以新结果替换缓存的扫描结果
+    if(m_isAutoScan || recovered) {
         tool->scan();
     }
 
-    Q_EMIT q->wifiStateChanged();
+    if(recovered) {
+        qCInfo(logNat, "[ OK ] wpa_supplicant recovered, network(%d) selected.",
+               m_selectedNetworkId);
+    } else {
+        Q_EMIT q->wifiStateChanged();
+    }
 }
 
 void WiFiNativePrivate::initWiFiNativeInfo()
@@ -205,20 +750,37 @@ void WiFiNativePrivate::initWiFiNativeInfo()
     m_info = info;
     if(!m_info.ipAddress().isEmpty() && m_info.networkId() < 0) {
         tool->dhcpc_release();
+    } else if(m_info.ipAddress().isEmpty() && m_info.networkId() >= 0) {
+        // 已关联但没有 CTRL-EVENT-CONNECTED 事件触发获取 IP
+        tool->dhcpc_request(m_info.bssid().toString(), m_info.ssid());
     }
     Q_EMIT q->connectionInfoChanged();
 
     this->syncWiFiNetworks();
 
-    QStringList bssids = parser.fromScanResult(tool->scan_results());
-    for(const QString &bssid : bssids) {
-        WiFiScanResult result = parser.fromBSS(tool->bss(bssid));
-        if(result.isValid()) {
-            int id = getNetworkByScanResult(result).networkId();
-            result.setNetworkId(id);
-            m_scanResults << result;
-            Q_EMIT q->scanResultFound(result);
+    /* wpa_supplicant 已有的 BSS 表直接使用，不必等待扫描；
+     * 表为空时保留快照中的缓存结果，直到下一次扫描完成。
+     */
+    int first = 0;
+    bool finished = false;
+    bool fresh = false;
+    while(!finished) {
+        QList<int> ids;
+        WiFiScanResultList results = parser.fromBSSRange(tool->bss_range(first),
+                                     &ids, &finished);
+        if(ids.isEmpty()) {
+            break;
         }
+        this->addScanResults(results);
+        first = ids.last() + 1;
+        fresh = true;
+    }
+    if(finished) {
+        this->dropCachedScanResults();
+    } else if(fresh) {
+        // 回复失败或不完整，其余部分异步继续获取，遍历完成后再移除缓存的结果
+        m_bssWalkFrom = first;
+        this->fetchScanResults();
     }
 }
 
@@ -238,17 +800,38 @@ void WiFiNativePrivate::onSupplicantFinished()
     if(timer_Info) {
         timer_Info->stop();
     }
+    if(timer_Sync) {
+        timer_Sync->stop();
+    }
+    if(timer_Bss) {
+        timer_Bss->stop();
+    }
+    if(timer_Save) {
+        timer_Save->stop();
+    }
 
     m_isAutoScan = false;
+    m_recovering = false;
+    m_selectedNetworkId = -1;
+    m_wpaState = -1;
     Q_EMIT q->isAutoScanChanged();
 
     m_info = WiFiInfo();
     Q_EMIT q->connectionInfoChanged();
 
     m_networks.clear();
+    m_networkCache.clear();
+    m_assocByBssid.clear();
+    m_assocBySsid.clear();
+    m_pendingBssIds.clear();
+    m_bssWalkFrom = -1;
+    m_bssRetries = 0;
+    m_dropCachedPending = false;
+    m_statusPending = false;
+    m_statusDirty = false;
     Q_EMIT q->networksChanged();
 
-    for(const WiFiScanResult &sr : m_scanResults) {
+    for(const WiFiScanResult &sr : m_scanResults.toList()) {
         Q_EMIT q->scanResultLost(sr);
     }
     m_scanResults.clear();
@@ -256,6 +839,62 @@ void WiFiNativePrivate::onSupplicantFinished()
     Q_EMIT q->wifiStateChanged();
 }
 
+/* 租约变化后接口地址已经改变，重新获取 STATUS 更新 IP 地址。
+ */
+void WiFiNativePrivate::onDhcpcLeaseChanged()
+{
+    if(m_state == WiFi::StateEnabled) {
+        this->updateConnectionInfo();
+    }
+}
+
+/* wpa_supplicant 意外退出：保持启用状态、自动扫描和网络列表不变，
+ * 扫描结果标记为缓存数据保留到恢复后的新扫描结果到达，避免界面清空。
+ */
+void WiFiNativePrivate::onSupplicantRestarting()
+{
+    Q_Q(WiFiNative);
+
+    if(m_state != WiFi::StateEnabled && !m_recovering) {
+        return;
+    }
+    m_recovering = true;
+
+    WiFiInfo info;
+    info.setMacAddress(m_info.macAddress());
+    this->applyConnectionInfo(info);
+
+    if(timer_Scan) {
+        timer_Scan->stop();
+    }
+    if(timer_Info) {
+        timer_Info->stop();
+    }
+    if(timer_Sync) {
+        timer_Sync->stop();
+    }
+    if(timer_Bss) {
+        timer_Bss->stop();
+    }
+    m_wpaState = -1;
+    m_networkCache.clear();
+    m_pendingBssIds.clear();
+    m_bssWalkFrom = -1;
+    m_bssRetries = 0;
+    m_dropCachedPending = false;
+
+    for(WiFiScanResultStore::Handle handle : m_scanResults.handles()) {
+        WiFiScanResult result = m_scanResults.at(handle);
+        if(!result.isCached()) {
+            result.setCached(true);
+            m_scanResults.update(handle, result);
+            Q_EMIT q->scanResultUpdated(result);
+        }
+    }
+    qCWarning(logNat, "[FAIL] wpa_supplicant lost, keep %d cached scan result(s).",
+              m_scanResults.count());
+}
+
 void WiFiNativePrivate::onMessageReceived(const QString &msg)
 {
     Q_Q(WiFiNative);
@@ -264,20 +903,20 @@ void WiFiNativePrivate::onMessageReceived(const QString &msg)
         if(m_isAutoScan) {
             timer_Scan->start();
         }
+        // 本次扫描新增的 BSS 获取完成后，未被替换的缓存结果已经过时
+        m_dropCachedPending = true;
+        if(!m_bssRangePending && m_pendingBssIds.isEmpty() && m_bssWalkFrom < 0) {
+            this->dropCachedScanResults();
+        }
     } else if(q->isWiFiEnabled() && msg.startsWith(QStringLiteral(WPA_EVENT_BSS_ADDED))) {
         QRegExp rx(QStringLiteral("(\\d+)(?:\\s*)"
                                   "([0-9a-fA-F]{2}(?:[:][0-9a-fA-F]{2}){5})"));
         int pos = rx.indexIn(msg);
         if (pos > -1) {
-            // QString index = rxlen.cap(1);
-            QString bssid = rx.cap(2);
-            WiFiScanResult result = parser.fromBSS(tool->bss(bssid));
-            if(result.isValid()) {
-                int id = getNetworkByScanResult(result).networkId();
-                result.setNetworkId(id);
-
-                m_scanResults << result;
-                Q_EMIT q->scanResultFound(result);
+            // 合并同一批次的 BSS-ADDED ，使用 BSS RANGE 一次获取
+            m_pendingBssIds.insert(rx.cap(1).toInt());
+            if(!timer_Bss->isActive()) {
+                timer_Bss->start(0);
             }
         }
     } else if(q->isWiFiEnabled() && msg.startsWith(QStringLiteral(WPA_EVENT_BSS_REMOVED))) {
@@ -285,11 +924,12 @@ void WiFiNativePrivate::onMessageReceived(const QString &msg)
                                   "([0-9a-fA-F]{2}(?:[:][0-9a-fA-F]{2}){5})"));
         int pos = rx.indexIn(msg);
         if (pos > -1) {
-            // QString index = rxlen.cap(1);
             QString bssid = rx.cap(2);
-            int index = m_scanResults.indexOf(WiFiScanResult(bssid, QString()));
-            if(index >= 0) {
-                Q_EMIT q->scanResultLost(m_scanResults.takeAt(index));
+            m_pendingBssIds.remove(rx.cap(1).toInt());
+            WiFiScanResultStore::Handle handle = m_scanResults.find(WiFiMacAddress(bssid));
+            if(handle >= 0) {
+                Q_EMIT q->scanResultLost(m_scanResults.take(handle));
+                this->scheduleSaveSnapshot();
             }
         }
     } else if(msg.startsWith(QStringLiteral(WPA_EVENT_TEMP_DISABLED))) {
@@ -347,17 +987,63 @@ void WiFiNativePrivate::onMessageReceived(const QString &msg)
         Q_EMIT q->networkAuthenticated(networkId);
 
         if(m_info.ipAddress().isEmpty()) {
-            tool->dhcpc_request();
+            // 按 BSSID/SSID 复用上次的租约
+            const QString bssid = items.size() > 4 ? items.at(4) : QString();
+            tool->dhcpc_request(bssid, ssid);
         }
-        this->_q_updateInfoTimeout();
+        this->updateConnectionInfo();
     } else if(msg.startsWith(QStringLiteral(WPA_EVENT_DISCONNECTED))) {
+        // CTRL-EVENT-DISCONNECTED bssid=0c:4b:54:7a:21:21 reason=3 locally_generated=1
         int networkId = m_info.networkId();
         const QString &ssid = getNetworkById(networkId).ssid();
         qCInfo(logNat, "[ OK ] Network(%d, %s) disconnected.", networkId, qUtf8Printable(ssid));
-        if(!m_info.ipAddress().isEmpty()) {
-            tool->dhcpc_release();
+        // 即使还没有获得地址也要停止，否则 DHCP 客户端会继续 DISCOVER 并可能绑定
+        tool->dhcpc_release();
+        WiFiInfo info;
+        info.setMacAddress(m_info.macAddress());
+        this->applyConnectionInfo(info);
+    } else if(msg.startsWith(QStringLiteral(WPA_EVENT_STATE_CHANGE))) {
+        // CTRL-EVENT-STATE-CHANGE id=0 state=9 BSSID=0c:4b:54:7a:21:21 SSID=hsaeyz
+        bool ok;
+        int state = wifiEventValue(msg, QStringLiteral("state")).toInt(&ok);
+        if(!ok || state == m_wpaState) {
+            return;
+        }
+        m_wpaState = state;
+        if(state == WIFI_WPA_COMPLETED && m_info.networkId() < 0) {
+            // 漫游或重新关联时可能没有 CTRL-EVENT-CONNECTED
+            this->updateConnectionInfo();
+        } else if((state == WIFI_WPA_DISCONNECTED || state == WIFI_WPA_INACTIVE)
+                  && m_info.networkId() >= 0 && m_info.ipAddress().isEmpty()) {
+            WiFiInfo info;
+            info.setMacAddress(m_info.macAddress());
+            this->applyConnectionInfo(info);
         }
-        this->_q_updateInfoTimeout();
+    } else if(msg.startsWith(QStringLiteral(WPA_EVENT_SIGNAL_CHANGE))) {
+        // CTRL-EVENT-SIGNAL-CHANGE above=1 signal=-60 noise=-95 txrate=65000
+        if(m_info.networkId() < 0) {
+            return;
+        }
+        bool ok;
+        WiFiInfo info = m_info;
+        int signal = wifiEventValue(msg, QStringLiteral("signal")).toInt(&ok);
+        if(ok) {
+            info.setRssi(signal);
+        }
+        int txrate = wifiEventValue(msg, QStringLiteral("txrate")).toInt(&ok);
+        if(ok) {
+            info.setTxLinkSpeed(txrate / 1000);
+        }
+        this->applyConnectionInfo(info);
+    } else if(msg.startsWith(QStringLiteral(WPA_EVENT_NETWORK_ADDED)) ||
+              msg.startsWith(QStringLiteral(WPA_EVENT_NETWORK_REMOVED))) {
+        // CTRL-EVENT-NETWORK-ADDED 3
+        bool ok;
+        int id = msg.section(QLatin1Char(' '), 1, 1).toInt(&ok);
+        if(ok) {
+            m_networkCache.remove(id);
+        }
+        this->scheduleSyncNetworks();
     }
 }
 
@@ -383,22 +1069,25 @@ WiFiNetwork WiFiNativePrivate::getNetworkById(int id) const
 
 WiFiScanResult WiFiNativePrivate::getScanResultByNetwork(const WiFiNetwork &network) const
 {
-    for(const WiFiScanResult &scanResult : m_scanResults) {
-        if(compare(scanResult, network)) {
-            return scanResult;
+    WiFiScanResultStore::Handle handle = -1;
+    if(!network.bssid().isNull()) {
+        handle = m_scanResults.find(network.bssid());
+    } else {
+        const QList<WiFiScanResultStore::Handle> handles = m_scanResults.findBySsid(
+                                network.ssid());
+        if(!handles.isEmpty()) {
+            handle = handles.first();
         }
     }
-    return WiFiScanResult();
+    return handle >= 0 ? m_scanResults.at(handle) : WiFiScanResult();
 }
 
 WiFiNetwork WiFiNativePrivate::getNetworkByScanResult(const WiFiScanResult &scanResult) const
 {
-    for(const WiFiNetwork &network : m_networks) {
-        if(compare(scanResult, network)) {
-            return network;
-        }
-    }
-    return WiFiNetwork();
+    int byBssid = m_assocByBssid.value(scanResult.bssid().toUInt64()).position;
+    int bySsid = m_assocBySsid.value(scanResult.ssid()).position;
+    int pos = byBssid < 0 ? bySsid : bySsid < 0 ? byBssid : qMin(byBssid, bySsid);
+    return pos < 0 ? WiFiNetwork() : m_networks.at(pos);
 }
 
 int WiFiNativePrivate::addNetwork(const WiFiNetwork &network)
@@ -499,6 +1188,8 @@ int WiFiNativePrivate::editNetwork(const WiFiNetwork &network)
 
     this->selectNetwork(id);
     tool->save_config();
+    m_networkCache.remove(id);
+    this->scheduleSyncNetworks();
 
     return id;
 }
@@ -507,6 +1198,7 @@ void WiFiNativePrivate::selectNetwork(int networkId)
 {
     Q_Q(WiFiNative);
     Q_EMIT q->networkConnecting(networkId);
+    m_selectedNetworkId = networkId;
     timer_ConnNetId = networkId;
     timer_ConnNet->start();
     tool->select_network(networkId);
@@ -514,7 +1206,12 @@ void WiFiNativePrivate::selectNetwork(int networkId)
 
 void WiFiNativePrivate::removeNetwork(int networkId)
 {
+    if(m_selectedNetworkId == networkId) {
+        m_selectedNetworkId = -1;
+    }
     tool->remove_network(networkId);
+    m_networkCache.remove(networkId);
+    this->scheduleSyncNetworks();
 }
 
 /*!
@@ -529,6 +1226,10 @@ WiFiNative::WiFiNative(QObject * parent)
                             &WiFiNativePrivate::onSupplicantStarted);
     QObjectPrivate::connect(d->tool, &WiFiSupplicantTool::supplicantFinished, d,
                             &WiFiNativePrivate::onSupplicantFinished);
+    QObjectPrivate::connect(d->tool, &WiFiSupplicantTool::supplicantRestarting, d,
+                            &WiFiNativePrivate::onSupplicantRestarting);
+    QObjectPrivate::connect(d->tool, &WiFiSupplicantTool::dhcpcLeaseChanged, d,
+                            &WiFiNativePrivate::onDhcpcLeaseChanged);
     QObjectPrivate::connect(d->tool, &WiFiSupplicantTool::messageReceived, d,
                             &WiFiNativePrivate::onMessageReceived);
 }
@@ -558,6 +1259,7 @@ void WiFiNative::setWiFiEnabled(bool enabled)
         emit wifiStateChanged();
 
         if(!d->tool->isRunning()) {
+            d->loadSnapshot();
             d->tool->start();
         } else {
             d->onSupplicantStarted();
@@ -570,7 +1272,11 @@ void WiFiNative::setWiFiEnabled(bool enabled)
         d->m_state = WiFi::StateDisabling;
         emit wifiStateChanged();
 
-        if(d->tool->isRunning()) {
+        if(d->m_recovering) {
+            // 禁用后不再按退避间隔重新启动，否则 wpa_supplicant 恢复后会自动连接
+            d->tool->cancelRestart();
+        }
+        if(d->tool->isRunning() || d->m_recovering) {
             d->onSupplicantFinished();
         }
     }
@@ -623,7 +1329,7 @@ WiFiScanResultList WiFiNative::scanResults() const
 {
     Q_D(const WiFiNative);
 
-    return d->m_scanResults;
+    return d->m_scanResults.toList();
 }
 
 /*!
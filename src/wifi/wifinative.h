@@ -78,6 +78,9 @@ private:
     Q_PRIVATE_SLOT(d_func(), void _q_updateInfoTimeout())
     Q_PRIVATE_SLOT(d_func(), void _q_autoScanTimeout())
     Q_PRIVATE_SLOT(d_func(), void _q_connNetTimeout())
+    Q_PRIVATE_SLOT(d_func(), void _q_syncNetworksTimeout())
+    Q_PRIVATE_SLOT(d_func(), void _q_fetchScanResultsTimeout())
+    Q_PRIVATE_SLOT(d_func(), void _q_saveSnapshotTimeout())
 };
 
 #endif // WIFINATIVE_H
@@ -22,10 +22,29 @@
 #include "wifinative.h"
 #include "wifisupplicantparser_p.h"
 #include "wifisupplicanttool_p.h"
+#include "wifiscanresultstore_p.h"
 
 #include <private/qobject_p.h>
 #include <QtCore/qtimer.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+
+/* 扫描结果关联的网络：网络在 m_networks 中的位置及其网络 id 。
+ */
+struct WiFiAssociation
+{
+    WiFiAssociation(int position = -1, int networkId = -1)
+        : position(position), networkId(networkId) {}
+
+    int position;
+    int networkId;
+
+    bool operator==(const WiFiAssociation &other) const
+    {
+        return position == other.position && networkId == other.networkId;
+    }
+};
 
 class WiFiNativePrivate : public QObjectPrivate
 {
@@ -36,14 +55,33 @@ public:
 
     void initWiFiNativeInfo();
     void syncWiFiNetworks();
+    void fetchNetworkDetails(const QList<int> &ids);
 
     void onSupplicantStarted();
     void onSupplicantFinished();
+    void onSupplicantRestarting();
+    void onDhcpcLeaseChanged();
     void onMessageReceived(const QString &msg);
 
+    void updateConnectionInfo();
+    void applyConnectionInfo(const WiFiInfo &info);
+    void updateInfoTimer();
+    void scheduleSyncNetworks();
+    void updateAssociationIndex();
+    void addScanResults(const WiFiScanResultList &results);
+    void fetchScanResults();
+    void dropCachedScanResults();
+
+    void loadSnapshot();
+    void saveSnapshot();
+    void scheduleSaveSnapshot();
+
     void _q_updateInfoTimeout();
     void _q_autoScanTimeout();
     void _q_connNetTimeout();
+    void _q_syncNetworksTimeout();
+    void _q_fetchScanResultsTimeout();
+    void _q_saveSnapshotTimeout();
 
     bool compare(const WiFiScanResult &scanResult, const WiFiNetwork &network) const;
     WiFiNetwork getNetworkById(int id) const;
@@ -60,13 +98,29 @@ public:
     QTimer *timer_Info = NULL;
     QTimer *timer_Scan = NULL;
     QTimer *timer_ConnNet = NULL;
+    QTimer *timer_Sync = NULL;
+    QTimer *timer_Bss = NULL;
+    QTimer *timer_Save = NULL;
     int timer_ConnNetId = -1;
 
     WiFi::State m_state = WiFi::StateDisabled;
     bool m_isAutoScan = false;
+    bool m_recovering = false; // wpa_supplicant 重新启动中，保持启用状态和缓存的扫描结果
+    int m_selectedNetworkId = -1; // 恢复后重新选择的网络
+    int m_wpaState = -1;
+    bool m_statusPending = false;
+    bool m_statusDirty = false;
+    QSet<int> m_pendingBssIds; // 等待获取详细信息的 BSS id
+    bool m_bssRangePending = false;
+    int m_bssWalkFrom = -1; // >= 0 时从该 id 继续遍历 BSS 表
+    int m_bssRetries = 0;   // 连续无进展的 BSS RANGE 请求次数
+    bool m_dropCachedPending = false; // 扫描完成，等待 BSS 获取结束后移除缓存的扫描结果
     WiFiInfo m_info;
-    WiFiScanResultList m_scanResults;
+    WiFiScanResultStore m_scanResults;
     WiFiNetworkList m_networks;
+    QHash<int, WiFiNetwork> m_networkCache; // 已获取配置的网络, 由事件或编辑失效
+    QHash<quint64, WiFiAssociation> m_assocByBssid; // BSSID -> 关联的网络
+    QHash<QString, WiFiAssociation> m_assocBySsid;  // SSID -> 关联的网络
 };
 
 #endif // WIFINATIVE_P_H
@@ -18,10 +18,20 @@
 
 #include "wifinativeproxy_p.h"
 
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qtimer.h>
 #include <private/qobject_p.h>
 
+#include <limits>
+
 #include "wifidbus_p.h"
-#include "station_interface.h"
+#include "wifinativetransport_p.h"
+
+#include <WiFi/wifimacaddress.h>
+
+static const int WIFI_PROXY_CHANGES_RETRY = 250; // msecs, 获取变化失败后的首次重试间隔
+static const int WIFI_PROXY_CHANGES_RETRY_MAX = 8000; // msecs
 
 class WiFiNativeProxyPrivate : public QObjectPrivate
 {
@@ -30,20 +40,26 @@ public:
     WiFiNativeProxyPrivate();
     ~WiFiNativeProxyPrivate();
 
-    void onConnectionInfoChanged(const QString &info);
-    void onScanResultFound(const QString &bss);
-    void onScanResultLost(const QString &bss);
-    void onScanResultUpdated(const QString &bss);
+    void onConnectionInfoChanged(const WiFiInfo &info);
+    void onScanResultsDelta(qulonglong from, qulonglong to,
+                            const WiFiScanResultList &added,
+                            const WiFiScanResultList &updated,
+                            const WiFiScanResultList &removed);
+    void onNetworksChanged(qulonglong from, qulonglong to, const WiFiNetworkList &networks);
+    void onChangesFinished(bool ok, const WiFiStationChanges &changes);
+    void requestChanges();
+    void applyChanges(const WiFiStationChanges &changes, bool notify);
+    void applyScanResultsDelta(const WiFiScanResultList &added,
+                               const WiFiScanResultList &updated,
+                               const WiFiScanResultList &removed, bool notify);
     void onWifiStateChanged(bool enabled);
     void onWiFiAutoScanChanged(bool autoScan);
 
-    void onServiceRegistered(const QString &service);
-    void onServiceUnregistered(const QString &service);
     void processEnabled(bool enabled);
     void processServiced(bool serviced);
 
 public:
-    wifi::native::Station *m_station = NULL;
+    WiFiNativeTransport *m_transport = NULL;
     bool m_isServiced = false;
 
     bool m_isEnabled = false;
@@ -51,6 +67,15 @@ public:
     WiFiInfo m_info;
     WiFiScanResultList m_scanResults;
     WiFiNetworkList m_networks;
+
+    /* 已同步到的服务端进程与代数，禁用期间保留以便重新启用时只获取变化 */
+    quint64 m_epoch = 0;
+    quint64 m_generation = 0;
+    bool m_changesPending = false;
+    QTimer *m_changesRetryTimer = NULL;
+    int m_changesRetries = 0;
+
+    int m_lastRequestId = 0;
 };
 
 WiFiNativeProxyPrivate::WiFiNativeProxyPrivate() : QObjectPrivate()
@@ -61,49 +86,190 @@ WiFiNativeProxyPrivate::~WiFiNativeProxyPrivate()
 {
 }
 
-void WiFiNativeProxyPrivate::onConnectionInfoChanged(const QString &info)
+void WiFiNativeProxyPrivate::onConnectionInfoChanged(const WiFiInfo &info)
 {
     Q_Q(WiFiNativeProxy);
 
-    WiFiInfo revInfo = WiFiInfo::fromJson(info.toUtf8());
-    if(m_info != revInfo) {
-        m_info = revInfo;
+    if(m_info != info) {
+        m_info = info;
         Q_EMIT q->connectionInfoChanged();
     }
 }
 
-void WiFiNativeProxyPrivate::onScanResultFound(const QString &bss)
+/*
+ * from 大于已同步的代数说明中间丢失了信号，改为通过 GetChangesSince 补齐；
+ * to 不大于已同步的代数说明变化已包含在之前获取的结果中。
+ */
+void WiFiNativeProxyPrivate::onScanResultsDelta(qulonglong from, qulonglong to,
+        const WiFiScanResultList &added, const WiFiScanResultList &updated,
+        const WiFiScanResultList &removed)
+{
+    if(m_changesPending || to <= m_generation) {
+        return;
+    }
+    if(from > m_generation) {
+        requestChanges();
+        return;
+    }
+    applyScanResultsDelta(added, updated, removed, true);
+    m_generation = to;
+}
+
+void WiFiNativeProxyPrivate::onNetworksChanged(qulonglong from, qulonglong to,
+        const WiFiNetworkList &networks)
 {
     Q_Q(WiFiNativeProxy);
 
-    WiFiScanResult revBSS = WiFiScanResult::fromJson(bss.toUtf8());
-    if(!m_scanResults.contains(revBSS)) {
-        m_scanResults << revBSS;
-        Q_EMIT q->scanResultFound(revBSS);
+    if(m_changesPending || to <= m_generation) {
+        return;
+    }
+    if(from > m_generation) {
+        requestChanges();
+        return;
+    }
+    m_networks = networks;
+    m_generation = to;
+    Q_EMIT q->networksChanged();
+}
+
+void WiFiNativeProxyPrivate::requestChanges()
+{
+    if(m_changesPending || !m_isEnabled) {
+        return;
     }
+    if(m_changesRetryTimer) {
+        m_changesRetryTimer->stop();
+    }
+    m_changesPending = true;
+    m_transport->requestChangesSince(m_epoch, m_generation);
 }
 
-void WiFiNativeProxyPrivate::onScanResultLost(const QString &bss)
+/* 获取变化失败时本地数据仍然过期，按加倍的间隔重试，直到成功或 WIFI 被禁用。
+ */
+void WiFiNativeProxyPrivate::onChangesFinished(bool ok, const WiFiStationChanges &changes)
 {
     Q_Q(WiFiNativeProxy);
 
-    WiFiScanResult revBSS = WiFiScanResult::fromJson(bss.toUtf8());
-    if(m_scanResults.contains(revBSS)) {
-        m_scanResults.removeAll(revBSS);
-        Q_EMIT q->scanResultLost(revBSS);
+    m_changesPending = false;
+    if(!m_isEnabled) {
+        m_changesRetries = 0;
+        return;
+    }
+    if(ok) {
+        m_changesRetries = 0;
+        applyChanges(changes, true);
+        return;
+    }
+
+    if(!m_changesRetryTimer) {
+        m_changesRetryTimer = new QTimer(q);
+        m_changesRetryTimer->setSingleShot(true);
+        QObjectPrivate::connect(m_changesRetryTimer, &QTimer::timeout,
+                                this, &WiFiNativeProxyPrivate::requestChanges);
     }
+    qint64 delay = qint64(WIFI_PROXY_CHANGES_RETRY) << qMin(m_changesRetries, 16);
+    m_changesRetries++;
+    m_changesRetryTimer->start(int(qMin<qint64>(delay, WIFI_PROXY_CHANGES_RETRY_MAX)));
 }
 
-void WiFiNativeProxyPrivate::onScanResultUpdated(const QString &bss)
+void WiFiNativeProxyPrivate::applyChanges(const WiFiStationChanges &changes, bool notify)
 {
     Q_Q(WiFiNativeProxy);
 
-    WiFiScanResult revBSS = WiFiScanResult::fromJson(bss.toUtf8());
-    int index = m_scanResults.indexOf(revBSS);
-    if(index >= 0 && index < m_scanResults.length()) {
-        m_scanResults.replace(index, revBSS);
-        Q_EMIT q->scanResultUpdated(revBSS);
+    if(changes.reset) {
+        m_scanResults = changes.scanResults;
+        if(notify) {
+            Q_EMIT q->scanResultsChanged();
+        }
+    } else {
+        WiFiScanResultList removed;
+        removed.reserve(changes.removedScanResults.size());
+        for(quint64 bssid : changes.removedScanResults) {
+            removed << WiFiScanResult(WiFiMacAddress(bssid), QString());
+        }
+        applyScanResultsDelta(changes.scanResults, WiFiScanResultList(), removed, notify);
+    }
+
+    if(changes.networksChanged) {
+        m_networks = changes.networks;
+        if(notify) {
+            Q_EMIT q->networksChanged();
+        }
     }
+
+    m_epoch = changes.epoch;
+    m_generation = changes.generation;
+}
+
+/*
+ * 先把整个变化集应用到本地表，再逐项发出信号，槽函数中读取 scanResults()
+ * 看到的总是完整的新状态。应用是幂等的：已存在的新增按更新处理，
+ * 不存在的更新按新增处理，不存在的删除被忽略。
+ */
+void WiFiNativeProxyPrivate::applyScanResultsDelta(const WiFiScanResultList &added,
+        const WiFiScanResultList &updated, const WiFiScanResultList &removed, bool notify)
+{
+    Q_Q(WiFiNativeProxy);
+
+    WiFiScanResultList found;
+    WiFiScanResultList changed;
+    WiFiScanResultList lost;
+
+    if(!removed.isEmpty()) {
+        QSet<quint64> lostIds;
+        lostIds.reserve(removed.size());
+        for(const WiFiScanResult &result : removed) {
+            lostIds.insert(result.bssid().toUInt64());
+        }
+        WiFiScanResultList kept;
+        kept.reserve(m_scanResults.size());
+        for(const WiFiScanResult &result : qAsConst(m_scanResults)) {
+            if(lostIds.contains(result.bssid().toUInt64())) {
+                lost << result;
+            } else {
+                kept << result;
+            }
+        }
+        m_scanResults = kept;
+    }
+
+    QHash<quint64, int> index;
+    index.reserve(m_scanResults.size() + added.size());
+    for(int i = 0; i < m_scanResults.size(); ++i) {
+        index.insert(m_scanResults.at(i).bssid().toUInt64(), i);
+    }
+    auto apply = [&](const WiFiScanResult &result) {
+        const quint64 bssid = result.bssid().toUInt64();
+        const int i = index.value(bssid, -1);
+        if(i >= 0) {
+            m_scanResults[i] = result;
+            changed << result;
+        } else {
+            index.insert(bssid, m_scanResults.size());
+            m_scanResults << result;
+            found << result;
+        }
+    };
+    for(const WiFiScanResult &result : added) {
+        apply(result);
+    }
+    for(const WiFiScanResult &result : updated) {
+        apply(result);
+    }
+
+    if(!notify || (found.isEmpty() && changed.isEmpty() && lost.isEmpty())) {
+        return;
+    }
+    for(const WiFiScanResult &result : qAsConst(lost)) {
+        Q_EMIT q->scanResultLost(result);
+    }
+    for(const WiFiScanResult &result : qAsConst(found)) {
+        Q_EMIT q->scanResultFound(result);
+    }
+    for(const WiFiScanResult &result : qAsConst(changed)) {
+        Q_EMIT q->scanResultUpdated(result);
+    }
+    Q_EMIT q->scanResultsDelta(found, changed, lost);
 }
 
 void WiFiNativeProxyPrivate::onWifiStateChanged(bool enabled)
@@ -124,18 +290,6 @@ void WiFiNativeProxyPrivate::onWiFiAutoScanChanged(bool autoScan)
 }
 
 
-void WiFiNativeProxyPrivate::onServiceRegistered(const QString &service)
-{
-    qDebug() << Q_FUNC_INFO << service;
-    processServiced(true);
-}
-
-void WiFiNativeProxyPrivate::onServiceUnregistered(const QString &service)
-{
-    qDebug() << Q_FUNC_INFO << service;
-    processServiced(false);
-}
-
 void WiFiNativeProxyPrivate::processEnabled(bool enabled)
 {
     Q_Q(WiFiNativeProxy);
@@ -149,13 +303,22 @@ void WiFiNativeProxyPrivate::processEnabled(bool enabled)
     if(m_isEnabled) {
         q->initialize();
 
-        m_isAutoScan = m_station->isWiFiAutoScan();
+        m_isAutoScan = m_transport->isWiFiAutoScan();
         Q_EMIT q->isWiFiAutoScanChanged();
-        m_info = WiFiInfo::fromJson(m_station->connectionInfo().toUtf8());
+        m_info = m_transport->connectionInfo();
         Q_EMIT q->connectionInfoChanged();
-        m_scanResults = WiFiScanResultList::fromJson(m_station->scanResults().toUtf8());
+
+        /* 沿用禁用前同步到的代数，只获取其后的变化 */
+        WiFiStationChanges changes;
+        if(m_transport->changesSince(m_epoch, m_generation, &changes)) {
+            applyChanges(changes, false);
+        } else {
+            m_epoch = 0;
+            m_generation = 0;
+            m_scanResults.clear();
+            m_networks.clear();
+        }
         Q_EMIT q->scanResultsChanged();
-        m_networks = WiFiNetworkList::fromJson(m_station->networks().toUtf8());
         Q_EMIT q->networksChanged();
     }else{
         q->uninitialize();
@@ -164,9 +327,8 @@ void WiFiNativeProxyPrivate::processEnabled(bool enabled)
         Q_EMIT q->isWiFiAutoScanChanged();
         m_info = WiFiInfo();
         Q_EMIT q->connectionInfoChanged();
-        m_scanResults = WiFiScanResultList();
+        /* 保留 m_scanResults 与 m_networks ，禁用期间对外返回空列表 */
         Q_EMIT q->scanResultsChanged();
-        m_networks = WiFiNetworkList();
         Q_EMIT q->networksChanged();
     }
 }
@@ -182,7 +344,7 @@ void WiFiNativeProxyPrivate::processServiced(bool serviced)
     emit q->isWiFiServicedChanged();
 
     if(m_isServiced) {
-        processEnabled(m_station->isWiFiEnabled());
+        processEnabled(m_transport->isWiFiEnabled());
     } else {
         processEnabled(false);
     }
@@ -193,52 +355,39 @@ WiFiNativeProxy::WiFiNativeProxy(QObject *parent)
 {
     Q_D(WiFiNativeProxy);
 
-    d->m_station = new wifi::native::Station(WiFiDBus::serviceName,
-            WiFiDBus::stationPath, WiFiDBus::connection());
+    d->m_transport = WiFiNativeTransport::create(this);
 
-    QObjectPrivate::connect(d->m_station,
-                            &WifiNativeStationInterface::WifiStateChanged,
+    QObjectPrivate::connect(d->m_transport, &WiFiNativeTransport::wifiStateChanged,
                             d, &WiFiNativeProxyPrivate::onWifiStateChanged);
-
-    QDBusServiceWatcher *wather = new QDBusServiceWatcher(WiFiDBus::serviceName,
-            WiFiDBus::connection(), QDBusServiceWatcher::WatchForOwnerChange, this);
-    QObjectPrivate::connect(wather, &QDBusServiceWatcher::serviceRegistered, d,
-                            &WiFiNativeProxyPrivate::onServiceRegistered);
-    QObjectPrivate::connect(wather, &QDBusServiceWatcher::serviceUnregistered, d,
-                            &WiFiNativeProxyPrivate::onServiceUnregistered);
-
-    QDBusReply<bool> reply =
-                    WiFiDBus::connection().interface()->isServiceRegistered(
-                                    WiFiDBus::serviceName);
-    d->processServiced(reply.value());
+    QObjectPrivate::connect(d->m_transport, &WiFiNativeTransport::servicedChanged,
+                            d, &WiFiNativeProxyPrivate::processServiced);
+    QObjectPrivate::connect(d->m_transport, &WiFiNativeTransport::changesFinished,
+                            d, &WiFiNativeProxyPrivate::onChangesFinished);
+    connect(d->m_transport, &WiFiNativeTransport::addNetworkFinished,
+            this, &WiFiNativeProxy::addNetworkFinished);
+
+    d->processServiced(d->m_transport->isServiced());
 }
 
 void WiFiNativeProxy::initialize()
 {
     Q_D(WiFiNativeProxy);
 
-    QObjectPrivate::connect(d->m_station,
-                            &WifiNativeStationInterface::ConnectionInfoChanged,
+    QObjectPrivate::connect(d->m_transport, &WiFiNativeTransport::connectionInfoChanged,
                             d, &WiFiNativeProxyPrivate::onConnectionInfoChanged);
-    connect(d->m_station, SIGNAL(NetworkAuthenticated(int)),
-            this, SIGNAL(networkAuthenticated(int)));
-    connect(d->m_station, SIGNAL(NetworkConnecting(int)),
-            this, SIGNAL(networkConnecting(int)));
-    connect(d->m_station, SIGNAL(NetworkConnected(int)),
-            this, SIGNAL(networkConnected(int)));
-    connect(d->m_station, SIGNAL(NetworkErrorOccurred(int)),
-            this, SIGNAL(networkErrorOccurred(int)));
-    QObjectPrivate::connect(d->m_station,
-                            &WifiNativeStationInterface::ScanResultFound,
-                            d, &WiFiNativeProxyPrivate::onScanResultFound);
-    QObjectPrivate::connect(d->m_station,
-                            &WifiNativeStationInterface::ScanResultLost,
-                            d, &WiFiNativeProxyPrivate::onScanResultLost);
-    QObjectPrivate::connect(d->m_station,
-                            &WifiNativeStationInterface::ScanResultUpdated,
-                            d, &WiFiNativeProxyPrivate::onScanResultUpdated);
-    QObjectPrivate::connect(d->m_station,
-                            &WifiNativeStationInterface::WiFiAutoScanChanged,
+    connect(d->m_transport, &WiFiNativeTransport::networkAuthenticated,
+            this, &WiFiNativeProxy::networkAuthenticated);
+    connect(d->m_transport, &WiFiNativeTransport::networkConnecting,
+            this, &WiFiNativeProxy::networkConnecting);
+    connect(d->m_transport, &WiFiNativeTransport::networkConnected,
+            this, &WiFiNativeProxy::networkConnected);
+    connect(d->m_transport, &WiFiNativeTransport::networkErrorOccurred,
+            this, &WiFiNativeProxy::networkErrorOccurred);
+    QObjectPrivate::connect(d->m_transport, &WiFiNativeTransport::scanResultsDelta,
+                            d, &WiFiNativeProxyPrivate::onScanResultsDelta);
+    QObjectPrivate::connect(d->m_transport, &WiFiNativeTransport::networksChanged,
+                            d, &WiFiNativeProxyPrivate::onNetworksChanged);
+    QObjectPrivate::connect(d->m_transport, &WiFiNativeTransport::wifiAutoScanChanged,
                             d, &WiFiNativeProxyPrivate::onWiFiAutoScanChanged);
 }
 
@@ -246,24 +395,21 @@ void WiFiNativeProxy::uninitialize()
 {
     Q_D(WiFiNativeProxy);
 
-    QObjectPrivate::disconnect(d->m_station,
-                               &WifiNativeStationInterface::ConnectionInfoChanged,
+    QObjectPrivate::disconnect(d->m_transport, &WiFiNativeTransport::connectionInfoChanged,
                                d, &WiFiNativeProxyPrivate::onConnectionInfoChanged);
-    disconnect(d->m_station, SIGNAL(NetworkAuthenticated(int)), 0, 0);
-    disconnect(d->m_station, SIGNAL(NetworkConnecting(int)), 0, 0);
-    disconnect(d->m_station, SIGNAL(NetworkConnected(int)), 0, 0);
-    disconnect(d->m_station, SIGNAL(NetworkErrorOccurred(int)), 0, 0);
-    QObjectPrivate::disconnect(d->m_station,
-                               &WifiNativeStationInterface::ScanResultFound,
-                               d, &WiFiNativeProxyPrivate::onScanResultFound);
-    QObjectPrivate::disconnect(d->m_station,
-                               &WifiNativeStationInterface::ScanResultLost,
-                               d, &WiFiNativeProxyPrivate::onScanResultLost);
-    QObjectPrivate::disconnect(d->m_station,
-                               &WifiNativeStationInterface::ScanResultUpdated,
-                               d, &WiFiNativeProxyPrivate::onScanResultUpdated);
-    QObjectPrivate::disconnect(d->m_station,
-                               &WifiNativeStationInterface::WiFiAutoScanChanged,
+    disconnect(d->m_transport, &WiFiNativeTransport::networkAuthenticated,
+               this, &WiFiNativeProxy::networkAuthenticated);
+    disconnect(d->m_transport, &WiFiNativeTransport::networkConnecting,
+               this, &WiFiNativeProxy::networkConnecting);
+    disconnect(d->m_transport, &WiFiNativeTransport::networkConnected,
+               this, &WiFiNativeProxy::networkConnected);
+    disconnect(d->m_transport, &WiFiNativeTransport::networkErrorOccurred,
+               this, &WiFiNativeProxy::networkErrorOccurred);
+    QObjectPrivate::disconnect(d->m_transport, &WiFiNativeTransport::scanResultsDelta,
+                               d, &WiFiNativeProxyPrivate::onScanResultsDelta);
+    QObjectPrivate::disconnect(d->m_transport, &WiFiNativeTransport::networksChanged,
+                               d, &WiFiNativeProxyPrivate::onNetworksChanged);
+    QObjectPrivate::disconnect(d->m_transport, &WiFiNativeTransport::wifiAutoScanChanged,
                                d, &WiFiNativeProxyPrivate::onWiFiAutoScanChanged);
 }
 
@@ -290,7 +436,7 @@ void WiFiNativeProxy::setWiFiEnabled(bool enabled)
     d->processEnabled(enabled);
 
     if(d->m_isServiced) {
-        d->m_station->SetWiFiEnabled(enabled);
+        d->m_transport->setWiFiEnabled(enabled);
     }
 }
 
@@ -309,7 +455,7 @@ void WiFiNativeProxy::setWiFiAutoScan(bool autoScan)
     }
 
     if(d->m_isServiced) {
-        d->m_station->SetWiFiAutoScan(autoScan);
+        d->m_transport->setWiFiAutoScan(autoScan);
         d->m_isAutoScan = autoScan;
     } else if(d->m_isAutoScan) {
         d->m_isAutoScan = false;
@@ -327,13 +473,13 @@ WiFiInfo WiFiNativeProxy::connectionInfo() const
 WiFiScanResultList WiFiNativeProxy::scanResults() const
 {
     Q_D(const WiFiNativeProxy);
-    return d->m_scanResults;
+    return d->m_isEnabled ? d->m_scanResults : WiFiScanResultList();
 }
 
 WiFiNetworkList WiFiNativeProxy::networks() const
 {
     Q_D(const WiFiNativeProxy);
-    return d->m_networks;
+    return d->m_isEnabled ? d->m_networks : WiFiNetworkList();
 }
 
 int WiFiNativeProxy::addNetwork(const WiFiNetwork &network)
@@ -341,20 +487,41 @@ int WiFiNativeProxy::addNetwork(const WiFiNetwork &network)
     Q_D(WiFiNativeProxy);
 
     if(d->m_isServiced) {
-        QDBusPendingReply<int> reply = d->m_station->AddNetwork(QString::fromUtf8(
-                network.toJson()));
-        reply.waitForFinished();
-        return reply.value();
+        return d->m_transport->addNetwork(network);
     }
     return -1;
 }
 
+/*
+ * 异步添加网络，立即返回请求 ID ，服务端应答后发出 addNetworkFinished ，
+ * 失败时网络 ID 为 -1 。服务不可用时同样在下一次事件循环中发出失败信号。
+ */
+int WiFiNativeProxy::addNetworkAsync(const WiFiNetwork &network)
+{
+    Q_D(WiFiNativeProxy);
+
+    if(d->m_lastRequestId == std::numeric_limits<int>::max()) {
+        d->m_lastRequestId = 0;
+    }
+    const int requestId = ++d->m_lastRequestId;
+
+    if(!d->m_isServiced) {
+        QTimer::singleShot(0, this, [this, requestId]() {
+            Q_EMIT addNetworkFinished(requestId, -1);
+        });
+        return requestId;
+    }
+
+    d->m_transport->requestAddNetwork(requestId, network);
+    return requestId;
+}
+
 void WiFiNativeProxy::selectNetwork(int networkId)
 {
     Q_D(WiFiNativeProxy);
 
     if(d->m_isServiced) {
-        d->m_station->SelectNetwork(networkId);
+        d->m_transport->selectNetwork(networkId);
     }
 }
 void WiFiNativeProxy::removeNetwork(int networkId)
@@ -362,6 +529,6 @@ void WiFiNativeProxy::removeNetwork(int networkId)
     Q_D(WiFiNativeProxy);
 
     if(d->m_isServiced) {
-        d->m_station->RemoveNetwork(networkId);
+        d->m_transport->removeNetwork(networkId);
     }
 }
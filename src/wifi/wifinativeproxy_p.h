@@ -47,6 +47,7 @@ public:
 
 public slots:
     int addNetwork(const WiFiNetwork &network);
+    int addNetworkAsync(const WiFiNetwork &network);
     void selectNetwork(int networkId);
     void removeNetwork(int networkId);
 
@@ -58,6 +59,9 @@ signals:
     void scanResultFound(const WiFiScanResult &result);
     void scanResultUpdated(const WiFiScanResult &result);
     void scanResultLost(const WiFiScanResult &result);
+    void scanResultsDelta(const WiFiScanResultList &added,
+                          const WiFiScanResultList &updated,
+                          const WiFiScanResultList &removed);
     void scanResultsChanged();
     void networksChanged();
 
@@ -65,6 +69,7 @@ signals:
     void networkAuthenticated(int networkId);
     void networkConnected(int networkId);
     void networkErrorOccurred(int networkId);
+    void addNetworkFinished(int requestId, int networkId);
 
 protected:
     void initialize();
@@ -18,10 +18,21 @@
 
 #include "wifinativestub_p.h"
 
+#include <QtCore/qdatetime.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qvector.h>
 #include <private/qobject_p.h>
 
 #include "station_adaptor.h"
 
+#include <WiFi/wifimacaddress.h>
+
+#include <algorithm>
+
+static int WIFI_DBUS_DELTA_WINDOW = 100; // msecs
+static const int WIFI_DBUS_TOMBSTONE_LIMIT = 512;
+
 class WiFiNativeStubPrivate : public QObjectPrivate
 {
     Q_DECLARE_PUBLIC(WiFiNativeStub)
@@ -39,13 +50,45 @@ public:
     void onScanResultLost(const WiFiScanResult &result);
     void onWifiStateChanged();
     void onAutoScanChanged();
+    void onNetworksChanged();
+
+    void scheduleScanResultsDelta();
+    void flushScanResultsDelta();
+    void pruneTombstones();
 
 public:
     WiFiNative *m_native = NULL;
+
+    /*
+     * 状态代数：每次扫描结果或网络列表变化都递增 m_generation ，
+     * m_sentGeneration 是已通过信号通知到客户端的代数。
+     */
+    quint64 m_epoch = 0;
+    quint64 m_generation = 0;
+    quint64 m_sentGeneration = 0;
+    QHash<quint64, quint64> m_scanGenerations;  // BSSID -> 最后变化的代数
+    QHash<quint64, quint64> m_scanTombstones;   // BSSID -> 被删除时的代数
+    quint64 m_tombstoneFloor = 0;               // 不晚于此代数的墓碑已被淘汰
+    quint64 m_networksGeneration = 0;
+
+    /* 以 BSSID 为键合并一个窗口内的扫描结果变化 */
+    QHash<quint64, WiFiScanResult> m_deltaAdded;
+    QHash<quint64, WiFiScanResult> m_deltaUpdated;
+    QHash<quint64, WiFiScanResult> m_deltaRemoved;
+    QTimer *m_deltaTimer = NULL;
 };
 
 WiFiNativeStubPrivate::WiFiNativeStubPrivate() : QObjectPrivate()
 {
+    m_epoch = quint64(QDateTime::currentMSecsSinceEpoch());
+
+    if(!qEnvironmentVariableIsEmpty("WIFI_DBUS_DELTA_WINDOW")) {
+        bool ok;
+        int window = qgetenv("WIFI_DBUS_DELTA_WINDOW").toInt(&ok);
+        if(ok && window >= 0) {
+            WIFI_DBUS_DELTA_WINDOW = window;
+        }
+    }
 }
 
 WiFiNativeStubPrivate::~WiFiNativeStubPrivate()
@@ -56,8 +99,7 @@ void WiFiNativeStubPrivate::onConnectionInfoChanged()
 {
     Q_Q(WiFiNativeStub);
 
-    const QByteArray &json = m_native->connectionInfo().toJson();
-    Q_EMIT q->ConnectionInfoChanged(QString::fromUtf8(json));
+    Q_EMIT q->ConnectionInfoChanged(m_native->connectionInfo());
 }
 
 void WiFiNativeStubPrivate::onNetworkAuthenticated(int networkId)
@@ -83,26 +125,125 @@ void WiFiNativeStubPrivate::onNetworkErrorOccurred(int networkId)
 
 void WiFiNativeStubPrivate::onScanResultFound(const WiFiScanResult &result)
 {
-    Q_Q(WiFiNativeStub);
-    const QByteArray &json = result.toJson();
-    Q_EMIT q->ScanResultFound(QString::fromUtf8(json));
+    const quint64 bssid = result.bssid().toUInt64();
+    m_scanGenerations.insert(bssid, ++m_generation);
+    m_scanTombstones.remove(bssid);
+    /* 窗口内先丢失又重新出现，客户端仍持有旧值，按更新处理 */
+    if(m_deltaRemoved.remove(bssid)) {
+        m_deltaUpdated.insert(bssid, result);
+    } else {
+        m_deltaAdded.insert(bssid, result);
+    }
+    scheduleScanResultsDelta();
 }
 void WiFiNativeStubPrivate::onScanResultUpdated(const WiFiScanResult &result)
 {
-    Q_Q(WiFiNativeStub);
-    const QByteArray &json = result.toJson();
-    Q_EMIT q->ScanResultUpdated(QString::fromUtf8(json));
+    const quint64 bssid = result.bssid().toUInt64();
+    m_scanGenerations.insert(bssid, ++m_generation);
+    if(m_deltaAdded.contains(bssid)) {
+        m_deltaAdded.insert(bssid, result);
+    } else {
+        m_deltaUpdated.insert(bssid, result);
+    }
+    scheduleScanResultsDelta();
 }
 void WiFiNativeStubPrivate::onScanResultLost(const WiFiScanResult &result)
+{
+    const quint64 bssid = result.bssid().toUInt64();
+    m_scanGenerations.remove(bssid);
+    m_scanTombstones.insert(bssid, ++m_generation);
+    pruneTombstones();
+    /* 窗口内新增又丢失，客户端从未见过，直接抵消 */
+    if(!m_deltaAdded.remove(bssid)) {
+        m_deltaUpdated.remove(bssid);
+        m_deltaRemoved.insert(bssid, result);
+    }
+    scheduleScanResultsDelta();
+}
+
+void WiFiNativeStubPrivate::scheduleScanResultsDelta()
+{
+    /* 窗口从第一个变化开始计时，后续变化不再延后发送 */
+    if(!m_deltaTimer->isActive()) {
+        m_deltaTimer->start(WIFI_DBUS_DELTA_WINDOW);
+    }
+}
+
+void WiFiNativeStubPrivate::flushScanResultsDelta()
 {
     Q_Q(WiFiNativeStub);
-    const QByteArray &json = result.toJson();
-    Q_EMIT q->ScanResultLost(QString::fromUtf8(json));
+
+    m_deltaTimer->stop();
+    if(m_deltaAdded.isEmpty() && m_deltaUpdated.isEmpty() && m_deltaRemoved.isEmpty()) {
+        return;
+    }
+
+    WiFiScanResultList added;
+    WiFiScanResultList updated;
+    WiFiScanResultList removed;
+    added.reserve(m_deltaAdded.size());
+    updated.reserve(m_deltaUpdated.size());
+    removed.reserve(m_deltaRemoved.size());
+    for(auto it = m_deltaAdded.cbegin(); it != m_deltaAdded.cend(); ++it) {
+        added.append(it.value());
+    }
+    for(auto it = m_deltaUpdated.cbegin(); it != m_deltaUpdated.cend(); ++it) {
+        updated.append(it.value());
+    }
+    for(auto it = m_deltaRemoved.cbegin(); it != m_deltaRemoved.cend(); ++it) {
+        removed.append(it.value());
+    }
+    m_deltaAdded.clear();
+    m_deltaUpdated.clear();
+    m_deltaRemoved.clear();
+
+    Q_EMIT q->ScanResultsDelta(m_sentGeneration, m_generation, added, updated, removed);
+    m_sentGeneration = m_generation;
+}
+
+/*
+ * 墓碑超过上限的两倍时淘汰较旧的一半，并抬高 m_tombstoneFloor ，
+ * 早于它的客户端只能获取完整快照。
+ */
+void WiFiNativeStubPrivate::pruneTombstones()
+{
+    if(m_scanTombstones.size() <= WIFI_DBUS_TOMBSTONE_LIMIT * 2) {
+        return;
+    }
+    QVector<quint64> generations;
+    generations.reserve(m_scanTombstones.size());
+    for(auto it = m_scanTombstones.cbegin(); it != m_scanTombstones.cend(); ++it) {
+        generations.append(it.value());
+    }
+    auto cut = generations.begin() + (generations.size() - WIFI_DBUS_TOMBSTONE_LIMIT);
+    std::nth_element(generations.begin(), cut, generations.end());
+    const quint64 floor = *cut;
+    for(auto it = m_scanTombstones.begin(); it != m_scanTombstones.end();) {
+        if(it.value() <= floor) {
+            it = m_scanTombstones.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_tombstoneFloor = qMax(m_tombstoneFloor, floor);
+}
+
+void WiFiNativeStubPrivate::onNetworksChanged()
+{
+    Q_Q(WiFiNativeStub);
+
+    /* 保证代数按顺序通知 */
+    flushScanResultsDelta();
+    m_networksGeneration = ++m_generation;
+    Q_EMIT q->NetworksChanged(m_sentGeneration, m_generation, m_native->networks());
+    m_sentGeneration = m_generation;
 }
 
 void WiFiNativeStubPrivate::onWifiStateChanged()
 {
     Q_Q(WiFiNativeStub);
+    /* 先发出旧状态下积累的变化，保证客户端按顺序看到 */
+    flushScanResultsDelta();
     bool enabled = m_native->isWiFiEnabled();
     Q_EMIT q->WifiStateChanged(enabled);
 }
@@ -120,6 +261,13 @@ WiFiNativeStub::WiFiNativeStub(WiFiNative *native)
     Q_D(WiFiNativeStub);
     d->m_native = native;
 
+    WiFiDBus::registerMetaTypes();
+
+    d->m_deltaTimer = new QTimer(this);
+    d->m_deltaTimer->setSingleShot(true);
+    QObjectPrivate::connect(d->m_deltaTimer, &QTimer::timeout,
+                            d, &WiFiNativeStubPrivate::flushScanResultsDelta);
+
     QObjectPrivate::connect(d->m_native, &WiFiNative::connectionInfoChanged,
                             d, &WiFiNativeStubPrivate::onConnectionInfoChanged);
     QObjectPrivate::connect(d->m_native, &WiFiNative::networkAuthenticated,
@@ -140,13 +288,14 @@ WiFiNativeStub::WiFiNativeStub(WiFiNative *native)
                             d, &WiFiNativeStubPrivate::onWifiStateChanged);
     QObjectPrivate::connect(d->m_native, &WiFiNative::isAutoScanChanged,
                             d, &WiFiNativeStubPrivate::onAutoScanChanged);
+    QObjectPrivate::connect(d->m_native, &WiFiNative::networksChanged,
+                            d, &WiFiNativeStubPrivate::onNetworksChanged);
 }
 
-QString WiFiNativeStub::connectionInfo() const
+WiFiInfo WiFiNativeStub::connectionInfo() const
 {
     Q_D(const WiFiNativeStub);
-    const QByteArray &json = d->m_native->connectionInfo().toJson();
-    return QString::fromUtf8(json);
+    return d->m_native->connectionInfo();
 }
 
 bool WiFiNativeStub::isWiFiAutoScan() const
@@ -161,25 +310,61 @@ bool WiFiNativeStub::isWiFiEnabled() const
     return d->m_native->isWiFiEnabled();
 }
 
-QString WiFiNativeStub::networks() const
+WiFiNetworkList WiFiNativeStub::networks() const
 {
     Q_D(const WiFiNativeStub);
-    const QByteArray &json = d->m_native->networks().toJson();
-    return QString::fromUtf8(json);
+    return d->m_native->networks();
 }
 
-QString WiFiNativeStub::scanResults() const
+WiFiScanResultList WiFiNativeStub::scanResults() const
 {
     Q_D(const WiFiNativeStub);
-    const QByteArray &json = d->m_native->scanResults().toJson();
-    return QString::fromUtf8(json);
+    return d->m_native->scanResults();
 }
 
-int WiFiNativeStub::AddNetwork(const QString &network)
+int WiFiNativeStub::AddNetwork(const WiFiNetwork &network)
 {
     Q_D(WiFiNativeStub);
-    WiFiNetwork net = WiFiNetwork::fromJson(network.toUtf8());
-    return d->m_native->addNetwork(net);
+    return d->m_native->addNetwork(network);
+}
+
+/*
+ * 返回 \a generation 之后的变化。\a epoch 不是本进程、\a generation 为 0 、
+ * 超前于当前代数或早于已淘汰的墓碑时返回完整快照。
+ */
+WiFiStationChanges WiFiNativeStub::GetChangesSince(qulonglong epoch, qulonglong generation)
+{
+    Q_D(const WiFiNativeStub);
+
+    WiFiStationChanges changes;
+    changes.epoch = d->m_epoch;
+    changes.generation = d->m_generation;
+    changes.reset = epoch != d->m_epoch || generation == 0 ||
+                    generation > d->m_generation || generation < d->m_tombstoneFloor;
+
+    const WiFiScanResultList scanResults = d->m_native->scanResults();
+    if(changes.reset) {
+        changes.scanResults = scanResults;
+        changes.networksChanged = true;
+        changes.networks = d->m_native->networks();
+        return changes;
+    }
+
+    for(const WiFiScanResult &result : scanResults) {
+        if(d->m_scanGenerations.value(result.bssid().toUInt64()) > generation) {
+            changes.scanResults << result;
+        }
+    }
+    for(auto it = d->m_scanTombstones.cbegin(); it != d->m_scanTombstones.cend(); ++it) {
+        if(it.value() > generation) {
+            changes.removedScanResults << it.key();
+        }
+    }
+    if(d->m_networksGeneration > generation) {
+        changes.networksChanged = true;
+        changes.networks = d->m_native->networks();
+    }
+    return changes;
 }
 
 void WiFiNativeStub::SelectNetwork(int networkId)
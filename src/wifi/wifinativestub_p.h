@@ -24,6 +24,8 @@
 
 #include <WiFi/wifinative.h>
 
+#include "wifidbus_p.h"
+
 
 class WiFiNativeStubPrivate;
 class WiFiNativeStub : public QObject
@@ -34,36 +36,40 @@ public:
 
 
 public: // PROPERTIES
-    Q_PROPERTY(QString ConnectionInfo READ connectionInfo)
-    QString connectionInfo() const;
+    /* 同进程传输以 QMetaObject::invokeMethod 在服务线程中读取 */
+    Q_PROPERTY(WiFiInfo ConnectionInfo READ connectionInfo)
+    Q_INVOKABLE WiFiInfo connectionInfo() const;
 
     Q_PROPERTY(bool IsWiFiAutoScan READ isWiFiAutoScan)
-    bool isWiFiAutoScan() const;
+    Q_INVOKABLE bool isWiFiAutoScan() const;
 
     Q_PROPERTY(bool IsWiFiEnabled READ isWiFiEnabled)
-    bool isWiFiEnabled() const;
+    Q_INVOKABLE bool isWiFiEnabled() const;
 
-    Q_PROPERTY(QString Networks READ networks)
-    QString networks() const;
+    Q_PROPERTY(WiFiNetworkList Networks READ networks)
+    WiFiNetworkList networks() const;
 
-    Q_PROPERTY(QString ScanResults READ scanResults)
-    QString scanResults() const;
+    Q_PROPERTY(WiFiScanResultList ScanResults READ scanResults)
+    WiFiScanResultList scanResults() const;
 
 public Q_SLOTS: // METHODS
-    int AddNetwork(const QString &network);
+    int AddNetwork(const WiFiNetwork &network);
+    WiFiStationChanges GetChangesSince(qulonglong epoch, qulonglong generation);
     void RemoveNetwork(int networkId);
     void SelectNetwork(int networkId);
     void SetWiFiAutoScan(bool autoScan);
     void SetWiFiEnabled(bool enabled);
 Q_SIGNALS: // SIGNALS
-    void ConnectionInfoChanged(const QString &info);
+    void ConnectionInfoChanged(const WiFiInfo &info);
     void NetworkAuthenticated(int networkId);
     void NetworkConnected(int networkId);
     void NetworkConnecting(int networkId);
     void NetworkErrorOccurred(int networkId);
-    void ScanResultFound(const QString &bss);
-    void ScanResultLost(const QString &bss);
-    void ScanResultUpdated(const QString &bss);
+    void NetworksChanged(qulonglong from, qulonglong to, const WiFiNetworkList &networks);
+    void ScanResultsDelta(qulonglong from, qulonglong to,
+                          const WiFiScanResultList &added,
+                          const WiFiScanResultList &updated,
+                          const WiFiScanResultList &removed);
     void WiFiAutoScanChanged(bool autoScan);
     void WifiStateChanged(bool enabled);
 
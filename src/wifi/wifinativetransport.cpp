@@ -0,0 +1,551 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "wifinativetransport_p.h"
+#include "wifinativestub_p.h"
+
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtimer.h>
+#include <QtDBus/qdbusconnectioninterface.h>
+#include <QtDBus/qdbusmessage.h>
+#include <QtDBus/qdbuspendingcall.h>
+#include <QtDBus/qdbuspendingreply.h>
+#include <QtDBus/qdbusreply.h>
+#include <QtDBus/qdbusservicewatcher.h>
+
+#include "station_interface.h"
+
+Q_DECLARE_LOGGING_CATEGORY(logTrans)
+
+Q_LOGGING_CATEGORY(logTrans, "wifi.transport", QtInfoMsg)
+
+static int WIFI_DBUS_PEER_RETRY = 1000; // msecs
+static const int WIFI_DBUS_PEER_AUTH_TIMEOUT = 1000; // msecs
+
+Q_GLOBAL_STATIC(WiFiNativeRegistry, wifiRegistry)
+
+/*
+    只连接可信的点对点套接字。D-Bus 认证在连接建立之后才进行，被服务端拒绝时
+    连接随后断开，因此先 Ping 一次确认认证通过；失败时返回未连接的 QDBusConnection 。
+*/
+static QDBusConnection wifiConnectToPeer()
+{
+    const QString address = WiFiDBus::peerAddress();
+    if(!WiFiDBus::isPeerTrusted()) {
+        qCDebug(logTrans, "[ DEBUG ] WiFi peer %s: untrusted or missing socket.",
+                qUtf8Printable(address));
+        return QDBusConnection(WiFiDBus::peerConnectionName);
+    }
+    QDBusConnection connection = QDBusConnection::connectToPeer(address,
+                                                                WiFiDBus::peerConnectionName);
+    if(connection.isConnected()) {
+        QDBusMessage ping = QDBusMessage::createMethodCall(QString(), WiFiDBus::stationPath,
+                                                           QStringLiteral("org.freedesktop.DBus.Peer"),
+                                                           QStringLiteral("Ping"));
+        QDBusMessage reply = connection.call(ping, QDBus::Block, WIFI_DBUS_PEER_AUTH_TIMEOUT);
+        if(reply.type() == QDBusMessage::ReplyMessage) {
+            return connection;
+        }
+        qCWarning(logTrans, "[FAIL] WiFi peer %s: %s", qUtf8Printable(address),
+                  qUtf8Printable(reply.errorMessage()));
+    }
+    QDBusConnection::disconnectFromPeer(WiFiDBus::peerConnectionName);
+    return QDBusConnection(WiFiDBus::peerConnectionName);
+}
+
+WiFiNativeTransport::WiFiNativeTransport(QObject *parent) : QObject(parent)
+{
+    WiFiDBus::registerMetaTypes();
+}
+
+WiFiNativeTransport *WiFiNativeTransport::create(QObject *parent)
+{
+    const QByteArray kind = qgetenv("WIFI_NATIVE_TRANSPORT");
+
+    if(kind == "local" || (kind.isEmpty() && WiFiNativeRegistry::instance()->hasService())) {
+        qCDebug(logTrans, "[ DEBUG ] WiFi transport: local");
+        return new WiFiLocalTransport(parent);
+    }
+
+    if(kind == "peer" || kind.isEmpty()) {
+        QDBusConnection connection = wifiConnectToPeer();
+        if(connection.isConnected() || kind == "peer") {
+            qCDebug(logTrans, "[ DEBUG ] WiFi transport: peer %s",
+                    qUtf8Printable(WiFiDBus::peerAddress()));
+            return new WiFiDBusTransport(connection, QString(), parent);
+        }
+    }
+
+    qCDebug(logTrans, "[ DEBUG ] WiFi transport: bus");
+    return new WiFiDBusTransport(WiFiDBus::connection(), WiFiDBus::serviceName, parent);
+}
+
+bool WiFiNativeTransport::isServiced() const
+{
+    return m_isServiced;
+}
+
+void WiFiNativeTransport::setServiced(bool serviced)
+{
+    if(m_isServiced == serviced) {
+        return;
+    }
+    m_isServiced = serviced;
+    Q_EMIT servicedChanged(serviced);
+}
+
+
+WiFiDBusTransport::WiFiDBusTransport(const QDBusConnection &connection,
+                                     const QString &service, QObject *parent)
+    : WiFiNativeTransport(parent), m_connection(connection), m_service(service)
+{
+    setConnection(connection);
+
+    if(isPeer()) {
+        if(!qEnvironmentVariableIsEmpty("WIFI_DBUS_PEER_RETRY")) {
+            bool ok;
+            int retry = qgetenv("WIFI_DBUS_PEER_RETRY").toInt(&ok);
+            if(ok && retry > 0) {
+                WIFI_DBUS_PEER_RETRY = retry;
+            }
+        }
+        m_retryTimer = new QTimer(this);
+        m_retryTimer->setSingleShot(true);
+        m_retryTimer->setInterval(WIFI_DBUS_PEER_RETRY);
+        connect(m_retryTimer, &QTimer::timeout, this, &WiFiDBusTransport::reconnectToPeer);
+
+        setServiced(m_connection.isConnected());
+        if(!m_connection.isConnected()) {
+            m_retryTimer->start();
+        }
+        return;
+    }
+
+    QDBusServiceWatcher *watcher = new QDBusServiceWatcher(m_service, m_connection,
+            QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(watcher, &QDBusServiceWatcher::serviceRegistered,
+            this, &WiFiDBusTransport::onServiceRegistered);
+    connect(watcher, &QDBusServiceWatcher::serviceUnregistered,
+            this, &WiFiDBusTransport::onServiceUnregistered);
+
+    QDBusReply<bool> reply = m_connection.interface()->isServiceRegistered(m_service);
+    setServiced(reply.value());
+}
+
+WiFiDBusTransport::~WiFiDBusTransport()
+{
+    if(isPeer()) {
+        QDBusConnection::disconnectFromPeer(m_connection.name());
+    }
+}
+
+/*
+ * 更换连接时重建接口对象，信号直接转发，值类型由 wifidbus 中的
+ * 二进制结构反序列化得到。
+ */
+void WiFiDBusTransport::setConnection(const QDBusConnection &connection)
+{
+    delete m_station;
+    m_connection = connection;
+    m_station = new WifiNativeStationInterface(m_service, WiFiDBus::stationPath,
+            m_connection, this);
+
+    connect(m_station, &WifiNativeStationInterface::WifiStateChanged,
+            this, &WiFiNativeTransport::wifiStateChanged);
+    connect(m_station, &WifiNativeStationInterface::WiFiAutoScanChanged,
+            this, &WiFiNativeTransport::wifiAutoScanChanged);
+    connect(m_station, &WifiNativeStationInterface::ConnectionInfoChanged,
+            this, &WiFiNativeTransport::connectionInfoChanged);
+    connect(m_station, &WifiNativeStationInterface::ScanResultsDelta,
+            this, &WiFiNativeTransport::scanResultsDelta);
+    connect(m_station, &WifiNativeStationInterface::NetworksChanged,
+            this, &WiFiNativeTransport::networksChanged);
+    connect(m_station, &WifiNativeStationInterface::NetworkConnecting,
+            this, &WiFiNativeTransport::networkConnecting);
+    connect(m_station, &WifiNativeStationInterface::NetworkAuthenticated,
+            this, &WiFiNativeTransport::networkAuthenticated);
+    connect(m_station, &WifiNativeStationInterface::NetworkConnected,
+            this, &WiFiNativeTransport::networkConnected);
+    connect(m_station, &WifiNativeStationInterface::NetworkErrorOccurred,
+            this, &WiFiNativeTransport::networkErrorOccurred);
+
+    if(isPeer() && m_connection.isConnected()) {
+        /* libdbus 在点对点连接断开时发出本地信号 */
+        m_connection.connect(QString(), QStringLiteral("/org/freedesktop/DBus/Local"),
+                             QStringLiteral("org.freedesktop.DBus.Local"),
+                             QStringLiteral("Disconnected"),
+                             this, SLOT(onPeerDisconnected()));
+    }
+}
+
+void WiFiDBusTransport::onServiceRegistered(const QString &service)
+{
+    qCDebug(logTrans) << Q_FUNC_INFO << service;
+    setServiced(true);
+}
+
+void WiFiDBusTransport::onServiceUnregistered(const QString &service)
+{
+    qCDebug(logTrans) << Q_FUNC_INFO << service;
+    setServiced(false);
+}
+
+void WiFiDBusTransport::onPeerDisconnected()
+{
+    if(!isServiced()) {
+        return;
+    }
+    qCWarning(logTrans, "[FAIL] WiFi peer %s disconnected.",
+              qUtf8Printable(WiFiDBus::peerAddress()));
+    setServiced(false);
+    m_retryTimer->start();
+}
+
+void WiFiDBusTransport::reconnectToPeer()
+{
+    QDBusConnection::disconnectFromPeer(m_connection.name());
+    QDBusConnection connection = wifiConnectToPeer();
+    if(!connection.isConnected()) {
+        m_retryTimer->start();
+        return;
+    }
+    qCDebug(logTrans, "[ DEBUG ] WiFi peer %s connected.",
+            qUtf8Printable(WiFiDBus::peerAddress()));
+    setConnection(connection);
+    setServiced(true);
+}
+
+bool WiFiDBusTransport::isWiFiEnabled()
+{
+    return m_station->isWiFiEnabled();
+}
+
+bool WiFiDBusTransport::isWiFiAutoScan()
+{
+    return m_station->isWiFiAutoScan();
+}
+
+WiFiInfo WiFiDBusTransport::connectionInfo()
+{
+    return m_station->connectionInfo();
+}
+
+bool WiFiDBusTransport::changesSince(quint64 epoch, quint64 generation,
+                                     WiFiStationChanges *changes)
+{
+    QDBusPendingReply<WiFiStationChanges> reply = m_station->GetChangesSince(epoch, generation);
+    reply.waitForFinished();
+    if(reply.isError()) {
+        qCWarning(logTrans) << "[FAIL] GetChangesSince:" << reply.error().message();
+        if(isPeer() && !m_connection.isConnected()) {
+            onPeerDisconnected();
+        }
+        return false;
+    }
+    *changes = reply.value();
+    return true;
+}
+
+int WiFiDBusTransport::addNetwork(const WiFiNetwork &network)
+{
+    QDBusPendingReply<int> reply = m_station->AddNetwork(network);
+    reply.waitForFinished();
+    if(reply.isError()) {
+        qCWarning(logTrans) << "[FAIL] AddNetwork:" << reply.error().message();
+        return -1;
+    }
+    return reply.value();
+}
+
+void WiFiDBusTransport::requestChangesSince(quint64 epoch, quint64 generation)
+{
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                    m_station->GetChangesSince(epoch, generation), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            this, &WiFiDBusTransport::onChangesFinished);
+}
+
+void WiFiDBusTransport::onChangesFinished(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<WiFiStationChanges> reply = *watcher;
+    watcher->deleteLater();
+
+    if(reply.isError()) {
+        qCWarning(logTrans) << "[FAIL] GetChangesSince:" << reply.error().message();
+        Q_EMIT changesFinished(false, WiFiStationChanges());
+        return;
+    }
+    Q_EMIT changesFinished(true, reply.value());
+}
+
+void WiFiDBusTransport::requestAddNetwork(int requestId, const WiFiNetwork &network)
+{
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                    m_station->AddNetwork(network), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+    [this, requestId](QDBusPendingCallWatcher * watcher) {
+        QDBusPendingReply<int> reply = *watcher;
+        watcher->deleteLater();
+        if(reply.isError()) {
+            qCWarning(logTrans) << "[FAIL] AddNetwork:" << reply.error().message();
+            Q_EMIT addNetworkFinished(requestId, -1);
+            return;
+        }
+        Q_EMIT addNetworkFinished(requestId, reply.value());
+    });
+}
+
+void WiFiDBusTransport::setWiFiEnabled(bool enabled)
+{
+    m_station->SetWiFiEnabled(enabled);
+}
+
+void WiFiDBusTransport::setWiFiAutoScan(bool autoScan)
+{
+    m_station->SetWiFiAutoScan(autoScan);
+}
+
+void WiFiDBusTransport::selectNetwork(int networkId)
+{
+    m_station->SelectNetwork(networkId);
+}
+
+void WiFiDBusTransport::removeNetwork(int networkId)
+{
+    m_station->RemoveNetwork(networkId);
+}
+
+
+WiFiLocalTransport::WiFiLocalTransport(QObject *parent)
+    : WiFiNativeTransport(parent)
+{
+    connect(WiFiNativeRegistry::instance(), &WiFiNativeRegistry::stationChanged,
+            this, &WiFiLocalTransport::onStationChanged);
+    onStationChanged();
+}
+
+/*
+ * 服务线程发布或撤销 WiFiNativeStub 。stub 的信号在服务线程发出，
+ * 经自动连接排队到本对象所在的线程。
+ */
+void WiFiLocalTransport::onStationChanged()
+{
+    WiFiNativeStub *stub = WiFiNativeRegistry::instance()->station();
+    if(m_stub == stub) {
+        return;
+    }
+    if(m_stub) {
+        disconnect(m_stub, 0, this, 0);
+    }
+    m_stub = stub;
+
+    if(m_stub) {
+        connect(m_stub, &WiFiNativeStub::WifiStateChanged,
+                this, &WiFiNativeTransport::wifiStateChanged);
+        connect(m_stub, &WiFiNativeStub::WiFiAutoScanChanged,
+                this, &WiFiNativeTransport::wifiAutoScanChanged);
+        connect(m_stub, &WiFiNativeStub::ConnectionInfoChanged,
+                this, &WiFiNativeTransport::connectionInfoChanged);
+        connect(m_stub, &WiFiNativeStub::ScanResultsDelta,
+                this, &WiFiNativeTransport::scanResultsDelta);
+        connect(m_stub, &WiFiNativeStub::NetworksChanged,
+                this, &WiFiNativeTransport::networksChanged);
+        connect(m_stub, &WiFiNativeStub::NetworkConnecting,
+                this, &WiFiNativeTransport::networkConnecting);
+        connect(m_stub, &WiFiNativeStub::NetworkAuthenticated,
+                this, &WiFiNativeTransport::networkAuthenticated);
+        connect(m_stub, &WiFiNativeStub::NetworkConnected,
+                this, &WiFiNativeTransport::networkConnected);
+        connect(m_stub, &WiFiNativeStub::NetworkErrorOccurred,
+                this, &WiFiNativeTransport::networkErrorOccurred);
+    }
+    setServiced(!m_stub.isNull());
+}
+
+Qt::ConnectionType WiFiLocalTransport::callType() const
+{
+    return m_stub->thread() == QThread::currentThread() ?
+           Qt::DirectConnection : Qt::BlockingQueuedConnection;
+}
+
+bool WiFiLocalTransport::isWiFiEnabled()
+{
+    bool enabled = false;
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "isWiFiEnabled", callType(),
+                                  Q_RETURN_ARG(bool, enabled));
+    }
+    return enabled;
+}
+
+bool WiFiLocalTransport::isWiFiAutoScan()
+{
+    bool autoScan = false;
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "isWiFiAutoScan", callType(),
+                                  Q_RETURN_ARG(bool, autoScan));
+    }
+    return autoScan;
+}
+
+WiFiInfo WiFiLocalTransport::connectionInfo()
+{
+    WiFiInfo info;
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "connectionInfo", callType(),
+                                  Q_RETURN_ARG(WiFiInfo, info));
+    }
+    return info;
+}
+
+bool WiFiLocalTransport::changesSince(quint64 epoch, quint64 generation,
+                                      WiFiStationChanges *changes)
+{
+    if(!m_stub) {
+        return false;
+    }
+    return QMetaObject::invokeMethod(m_stub, "GetChangesSince", callType(),
+                                     Q_RETURN_ARG(WiFiStationChanges, *changes),
+                                     Q_ARG(qulonglong, epoch),
+                                     Q_ARG(qulonglong, generation));
+}
+
+int WiFiLocalTransport::addNetwork(const WiFiNetwork &network)
+{
+    int networkId = -1;
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "AddNetwork", callType(),
+                                  Q_RETURN_ARG(int, networkId),
+                                  Q_ARG(WiFiNetwork, network));
+    }
+    return networkId;
+}
+
+/*
+ * 在服务线程中执行，结果经 WiFiLocalReply 以队列连接返回本对象所在的线程。
+ */
+void WiFiLocalTransport::requestChangesSince(quint64 epoch, quint64 generation)
+{
+    if(!m_stub) {
+        QTimer::singleShot(0, this, [this]() {
+            Q_EMIT changesFinished(false, WiFiStationChanges());
+        });
+        return;
+    }
+    QPointer<WiFiNativeStub> stub = m_stub;
+    WiFiLocalReply *reply = new WiFiLocalReply;
+    connect(reply, &WiFiLocalReply::changesFinished, this,
+            &WiFiNativeTransport::changesFinished, Qt::QueuedConnection);
+    reply->moveToThread(stub->thread());
+    QTimer::singleShot(0, reply, [reply, stub, epoch, generation]() {
+        if(stub) {
+            Q_EMIT reply->changesFinished(true, stub->GetChangesSince(epoch, generation));
+        } else {
+            Q_EMIT reply->changesFinished(false, WiFiStationChanges());
+        }
+        delete reply;
+    });
+}
+
+void WiFiLocalTransport::requestAddNetwork(int requestId, const WiFiNetwork &network)
+{
+    if(!m_stub) {
+        QTimer::singleShot(0, this, [this, requestId]() {
+            Q_EMIT addNetworkFinished(requestId, -1);
+        });
+        return;
+    }
+    QPointer<WiFiNativeStub> stub = m_stub;
+    WiFiLocalReply *reply = new WiFiLocalReply;
+    connect(reply, &WiFiLocalReply::addNetworkFinished, this,
+            &WiFiNativeTransport::addNetworkFinished, Qt::QueuedConnection);
+    reply->moveToThread(stub->thread());
+    QTimer::singleShot(0, reply, [reply, stub, requestId, network]() {
+        Q_EMIT reply->addNetworkFinished(requestId, stub ? stub->AddNetwork(network) : -1);
+        delete reply;
+    });
+}
+
+void WiFiLocalTransport::setWiFiEnabled(bool enabled)
+{
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "SetWiFiEnabled", Qt::QueuedConnection,
+                                  Q_ARG(bool, enabled));
+    }
+}
+
+void WiFiLocalTransport::setWiFiAutoScan(bool autoScan)
+{
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "SetWiFiAutoScan", Qt::QueuedConnection,
+                                  Q_ARG(bool, autoScan));
+    }
+}
+
+void WiFiLocalTransport::selectNetwork(int networkId)
+{
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "SelectNetwork", Qt::QueuedConnection,
+                                  Q_ARG(int, networkId));
+    }
+}
+
+void WiFiLocalTransport::removeNetwork(int networkId)
+{
+    if(m_stub) {
+        QMetaObject::invokeMethod(m_stub, "RemoveNetwork", Qt::QueuedConnection,
+                                  Q_ARG(int, networkId));
+    }
+}
+
+
+WiFiNativeRegistry *WiFiNativeRegistry::instance()
+{
+    return wifiRegistry;
+}
+
+bool WiFiNativeRegistry::hasService() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hasService;
+}
+
+void WiFiNativeRegistry::setHasService()
+{
+    QMutexLocker locker(&m_mutex);
+    m_hasService = true;
+}
+
+WiFiNativeStub *WiFiNativeRegistry::station() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_station;
+}
+
+void WiFiNativeRegistry::setStation(WiFiNativeStub *station)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if(m_station == station) {
+            return;
+        }
+        m_station = station;
+    }
+    Q_EMIT stationChanged();
+}
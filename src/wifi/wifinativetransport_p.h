@@ -0,0 +1,212 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef WIFINATIVETRANSPORT_P_H
+#define WIFINATIVETRANSPORT_P_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpointer.h>
+#include <QtDBus/qdbusconnection.h>
+
+#include "wifidbus_p.h"
+
+class QTimer;
+class QDBusPendingCallWatcher;
+class WiFiNativeStub;
+class WifiNativeStationInterface;
+
+/*
+ * WiFiNativeProxy 与服务端 WiFiNativeStub 之间的传输层。
+ * 信号与 wifi.native.Station 接口一一对应，同步查询只在启用 WIFI 时使用，
+ * 其余调用均不等待服务端应答。
+ *
+ * 传输方式由环境变量 WIFI_NATIVE_TRANSPORT 选择：
+ *      local   同进程的 WiFiService ，以队列连接直接传递值类型
+ *      peer    服务端的点对点 D-Bus 套接字(WIFI_DBUS_PEER_ADDRESS)，不经过 dbus-daemon
+ *      bus     系统总线
+ * 未设置时，本进程创建过 WiFiService 则使用 local ，点对点套接字可信且认证通过则使用
+ * peer ，否则使用 bus 。
+ */
+class WiFiNativeTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WiFiNativeTransport(QObject *parent = nullptr);
+
+    static WiFiNativeTransport *create(QObject *parent = nullptr);
+
+    bool isServiced() const;
+
+    virtual bool isWiFiEnabled() = 0;
+    virtual bool isWiFiAutoScan() = 0;
+    virtual WiFiInfo connectionInfo() = 0;
+    virtual bool changesSince(quint64 epoch, quint64 generation,
+                              WiFiStationChanges *changes) = 0;
+    virtual int addNetwork(const WiFiNetwork &network) = 0;
+
+    virtual void requestChangesSince(quint64 epoch, quint64 generation) = 0;
+    virtual void requestAddNetwork(int requestId, const WiFiNetwork &network) = 0;
+    virtual void setWiFiEnabled(bool enabled) = 0;
+    virtual void setWiFiAutoScan(bool autoScan) = 0;
+    virtual void selectNetwork(int networkId) = 0;
+    virtual void removeNetwork(int networkId) = 0;
+
+signals:
+    void servicedChanged(bool serviced);
+
+    void wifiStateChanged(bool enabled);
+    void wifiAutoScanChanged(bool autoScan);
+    void connectionInfoChanged(const WiFiInfo &info);
+    void scanResultsDelta(qulonglong from, qulonglong to,
+                          const WiFiScanResultList &added,
+                          const WiFiScanResultList &updated,
+                          const WiFiScanResultList &removed);
+    void networksChanged(qulonglong from, qulonglong to, const WiFiNetworkList &networks);
+    void networkConnecting(int networkId);
+    void networkAuthenticated(int networkId);
+    void networkConnected(int networkId);
+    void networkErrorOccurred(int networkId);
+
+    void changesFinished(bool ok, const WiFiStationChanges &changes);
+    void addNetworkFinished(int requestId, int networkId);
+
+protected:
+    void setServiced(bool serviced);
+
+private:
+    bool m_isServiced = false;
+};
+
+/*
+ * 通过 D-Bus 连接访问 wifi.native.Station 。service 为空时是点对点连接，
+ * 连接断开即视为服务不可用，并按 WIFI_DBUS_PEER_RETRY 毫秒间隔重连。
+ */
+class WiFiDBusTransport : public WiFiNativeTransport
+{
+    Q_OBJECT
+public:
+    WiFiDBusTransport(const QDBusConnection &connection, const QString &service,
+                      QObject *parent = nullptr);
+    ~WiFiDBusTransport();
+
+    bool isWiFiEnabled() Q_DECL_OVERRIDE;
+    bool isWiFiAutoScan() Q_DECL_OVERRIDE;
+    WiFiInfo connectionInfo() Q_DECL_OVERRIDE;
+    bool changesSince(quint64 epoch, quint64 generation,
+                      WiFiStationChanges *changes) Q_DECL_OVERRIDE;
+    int addNetwork(const WiFiNetwork &network) Q_DECL_OVERRIDE;
+
+    void requestChangesSince(quint64 epoch, quint64 generation) Q_DECL_OVERRIDE;
+    void requestAddNetwork(int requestId, const WiFiNetwork &network) Q_DECL_OVERRIDE;
+    void setWiFiEnabled(bool enabled) Q_DECL_OVERRIDE;
+    void setWiFiAutoScan(bool autoScan) Q_DECL_OVERRIDE;
+    void selectNetwork(int networkId) Q_DECL_OVERRIDE;
+    void removeNetwork(int networkId) Q_DECL_OVERRIDE;
+
+private slots:
+    void onServiceRegistered(const QString &service);
+    void onServiceUnregistered(const QString &service);
+    void onPeerDisconnected();
+    void reconnectToPeer();
+    void onChangesFinished(QDBusPendingCallWatcher *watcher);
+
+private:
+    void setConnection(const QDBusConnection &connection);
+    bool isPeer() const { return m_service.isEmpty(); }
+
+    QDBusConnection m_connection;
+    QString m_service;
+    WifiNativeStationInterface *m_station = NULL;
+    QTimer *m_retryTimer = NULL;
+};
+
+/*
+ * WiFiLocalTransport 一次异步请求的应答，在服务线程中发出信号后删除自身。
+ * 信号以队列连接到达请求方，请求方已销毁时 Qt 断开连接并丢弃应答。
+ */
+class WiFiLocalReply : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WiFiLocalReply(QObject *parent = nullptr) : QObject(parent) {}
+
+signals:
+    void changesFinished(bool ok, const WiFiStationChanges &changes);
+    void addNetworkFinished(int requestId, int networkId);
+};
+
+/*
+ * 访问同进程 WiFiService 线程中的 WiFiNativeStub 。
+ * 信号经队列连接到达本对象所在线程，不做任何序列化；
+ * 同步查询以 BlockingQueuedConnection 在服务线程中执行。
+ */
+class WiFiLocalTransport : public WiFiNativeTransport
+{
+    Q_OBJECT
+public:
+    explicit WiFiLocalTransport(QObject *parent = nullptr);
+
+    bool isWiFiEnabled() Q_DECL_OVERRIDE;
+    bool isWiFiAutoScan() Q_DECL_OVERRIDE;
+    WiFiInfo connectionInfo() Q_DECL_OVERRIDE;
+    bool changesSince(quint64 epoch, quint64 generation,
+                      WiFiStationChanges *changes) Q_DECL_OVERRIDE;
+    int addNetwork(const WiFiNetwork &network) Q_DECL_OVERRIDE;
+
+    void requestChangesSince(quint64 epoch, quint64 generation) Q_DECL_OVERRIDE;
+    void requestAddNetwork(int requestId, const WiFiNetwork &network) Q_DECL_OVERRIDE;
+    void setWiFiEnabled(bool enabled) Q_DECL_OVERRIDE;
+    void setWiFiAutoScan(bool autoScan) Q_DECL_OVERRIDE;
+    void selectNetwork(int networkId) Q_DECL_OVERRIDE;
+    void removeNetwork(int networkId) Q_DECL_OVERRIDE;
+
+private slots:
+    void onStationChanged();
+
+private:
+    Qt::ConnectionType callType() const;
+
+    QPointer<WiFiNativeStub> m_stub;
+};
+
+/*
+ * 记录本进程中 WiFiService 发布的 WiFiNativeStub ，供 WiFiLocalTransport 使用。
+ */
+class WiFiNativeRegistry : public QObject
+{
+    Q_OBJECT
+public:
+    static WiFiNativeRegistry *instance();
+
+    bool hasService() const;
+    void setHasService();
+
+    WiFiNativeStub *station() const;
+    void setStation(WiFiNativeStub *station);
+
+signals:
+    void stationChanged();
+
+private:
+    mutable QMutex m_mutex;
+    bool m_hasService = false;
+    WiFiNativeStub *m_station = NULL;
+};
+
+#endif // WIFINATIVETRANSPORT_P_H
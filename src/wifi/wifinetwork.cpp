@@ -24,7 +24,7 @@
 
 QT_BEGIN_NAMESPACE
 
-class WiFiNetworkPrivate
+class WiFiNetworkPrivate : public QSharedData
 {
 public:
     WiFiNetworkPrivate();
@@ -50,10 +50,13 @@ WiFiNetworkPrivate::WiFiNetworkPrivate() :
 /*!
     \class WiFiNetwork
     \inmodule WiFi
+    \ingroup shared
     \brief 类 WiFiNetwork 保存了获取的网络连接的相关信息。
     \since 5.8
 
     描述有关获取到的网络连接的信息。
+
+    WiFiNetwork 是隐式共享的值类型：复制只增加引用计数，修改时才分离数据。
 */
 
 
@@ -61,7 +64,7 @@ WiFiNetworkPrivate::WiFiNetworkPrivate() :
     构造一个无效的 WiFiNetwork 对象。
 */
 WiFiNetwork::WiFiNetwork() :
-    d_ptr(new WiFiNetworkPrivate)
+    d(new WiFiNetworkPrivate)
 {
 
 }
@@ -70,10 +73,8 @@ WiFiNetwork::WiFiNetwork() :
     构造一个 WiFiNetwork 对象，该对象具有 SSID 。
 */
 WiFiNetwork::WiFiNetwork(const QString &ssid) :
-    d_ptr(new WiFiNetworkPrivate)
+    d(new WiFiNetworkPrivate)
 {
-    Q_D(WiFiNetwork);
-
     d->ssid = ssid;
     d->cached = false;
 }
@@ -82,10 +83,8 @@ WiFiNetwork::WiFiNetwork(const QString &ssid) :
     构造一个 WiFiNetwork 对象，该对象具有 Network Id 和 SSID 。
 */
 WiFiNetwork::WiFiNetwork(int id, const QString &ssid) :
-    d_ptr(new WiFiNetworkPrivate)
+    d(new WiFiNetworkPrivate)
 {
-    Q_D(WiFiNetwork);
-
     d->networkId = id;
     d->ssid = ssid;
     d->cached = false;
@@ -95,9 +94,8 @@ WiFiNetwork::WiFiNetwork(int id, const QString &ssid) :
     构造一个 WiFiNetwork 对象，它是 \a other 的副本。
 */
 WiFiNetwork::WiFiNetwork(const WiFiNetwork &other) :
-    d_ptr(new WiFiNetworkPrivate)
+    d(other.d)
 {
-    *this = other;
 }
 
 /*!
@@ -105,7 +103,6 @@ WiFiNetwork::WiFiNetwork(const WiFiNetwork &other) :
 */
 WiFiNetwork::~WiFiNetwork()
 {
-    delete d_ptr;
 }
 
 /*!
@@ -113,7 +110,6 @@ WiFiNetwork::~WiFiNetwork()
 */
 bool WiFiNetwork::isValid() const
 {
-    Q_D(const WiFiNetwork);
     return d->networkId >= 0;
 }
 
@@ -122,7 +118,6 @@ bool WiFiNetwork::isValid() const
  */
 bool WiFiNetwork::isCached() const
 {
-    Q_D(const WiFiNetwork);
     return d->cached;
 }
 
@@ -132,7 +127,6 @@ bool WiFiNetwork::isCached() const
   */
 void WiFiNetwork::setCached(bool cached)
 {
-    Q_D(WiFiNetwork);
     d->cached = cached;
 }
 
@@ -141,16 +135,7 @@ void WiFiNetwork::setCached(bool cached)
 */
 WiFiNetwork &WiFiNetwork::operator=(const WiFiNetwork &other)
 {
-    Q_D(WiFiNetwork);
-
-    d->networkId = other.d_func()->networkId;
-    d->ssid = other.d_func()->ssid;
-    d->bssid = other.d_func()->bssid;
-    d->cached = other.d_func()->cached;
-    d->authFlags = other.d_func()->authFlags;
-    d->encrFlags = other.d_func()->encrFlags;
-    d->preSharedKey = other.d_func()->preSharedKey;
-
+    d = other.d;
     return *this;
 }
 
@@ -161,12 +146,10 @@ WiFiNetwork &WiFiNetwork::operator=(const WiFiNetwork &other)
   */
 bool WiFiNetwork::operator==(const WiFiNetwork &other) const
 {
-    Q_D(const WiFiNetwork);
-
-    if(d->networkId >=0 && other.d_func()->networkId >= 0) {
-        return d->networkId == other.d_func()->networkId;
+    if(d->networkId >=0 && other.d->networkId >= 0) {
+        return d->networkId == other.d->networkId;
     }else{
-        return d->ssid == other.d_func()->ssid;
+        return d->ssid == other.d->ssid;
 
     }
 }
@@ -186,7 +169,6 @@ bool WiFiNetwork::operator!=(const WiFiNetwork &other) const
   */
 int WiFiNetwork::networkId() const
 {
-    Q_D(const WiFiNetwork);
     return d->networkId;
 }
 
@@ -195,7 +177,6 @@ int WiFiNetwork::networkId() const
 */
 QString WiFiNetwork::ssid() const
 {
-    Q_D(const WiFiNetwork);
     return d->ssid;
 }
 
@@ -204,7 +185,6 @@ QString WiFiNetwork::ssid() const
 */
 WiFiMacAddress WiFiNetwork::bssid() const
 {
-    Q_D(const WiFiNetwork);
     return d->bssid;
 }
 
@@ -213,7 +193,6 @@ WiFiMacAddress WiFiNetwork::bssid() const
   */
 void WiFiNetwork::setBSSID(const WiFiMacAddress &bssid)
 {
-    Q_D(WiFiNetwork);
     d->bssid = bssid;
 }
 
@@ -222,7 +201,6 @@ void WiFiNetwork::setBSSID(const WiFiMacAddress &bssid)
 */
 WiFi::AuthFlags WiFiNetwork::authFlags() const
 {
-    Q_D(const WiFiNetwork);
     return d->authFlags;
 }
 
@@ -231,7 +209,6 @@ WiFi::AuthFlags WiFiNetwork::authFlags() const
   */
 void WiFiNetwork::setAuthFlags(WiFi::AuthFlags auths)
 {
-    Q_D(WiFiNetwork);
     d->authFlags = auths;
 }
 
@@ -240,7 +217,6 @@ void WiFiNetwork::setAuthFlags(WiFi::AuthFlags auths)
 */
 WiFi::EncrytionFlags WiFiNetwork::encrFlags() const
 {
-    Q_D(const WiFiNetwork);
     return d->encrFlags;
 }
 
@@ -249,7 +225,6 @@ WiFi::EncrytionFlags WiFiNetwork::encrFlags() const
   */
 void WiFiNetwork::setEncrFlags(WiFi::EncrytionFlags encrs)
 {
-    Q_D(WiFiNetwork);
     d->encrFlags = encrs;
 }
 
@@ -258,7 +233,6 @@ void WiFiNetwork::setEncrFlags(WiFi::EncrytionFlags encrs)
 */
 QString WiFiNetwork::preSharedKey() const
 {
-    Q_D(const WiFiNetwork);
     return d->preSharedKey;
 }
 
@@ -267,15 +241,12 @@ QString WiFiNetwork::preSharedKey() const
   */
 void WiFiNetwork::setPreSharedKey(const QString &psk)
 {
-    Q_D(WiFiNetwork);
     d->preSharedKey = psk;
 }
 
 
 QString WiFiNetwork::toString() const
 {
-    Q_D(const WiFiNetwork);
-
     QString s(QStringLiteral("NetId = %1\n"
                              "SSID  = %2\n"
                              "BSSID = %3\n"
@@ -294,7 +265,6 @@ QString WiFiNetwork::toString() const
 
 QVariantMap WiFiNetwork::toMap() const
 {
-    Q_D(const WiFiNetwork);
     QVariantMap map;
 
     map[QLatin1String("networkId")] = d->networkId;
@@ -21,6 +21,7 @@
 
 
 #include <WiFi/wifiglobal.h>
+#include <QtCore/qshareddata.h>
 #include <WiFi/wifi.h>
 
 QT_BEGIN_NAMESPACE
@@ -34,6 +35,9 @@ public:
     WiFiNetwork(const QString &ssid);
     WiFiNetwork(int id, const QString &ssid);
     WiFiNetwork(const WiFiNetwork &other);
+#ifdef Q_COMPILER_RVALUE_REFS
+    WiFiNetwork(WiFiNetwork &&other) Q_DECL_NOTHROW : d(std::move(other.d)) {}
+#endif
     ~WiFiNetwork();
 
     bool isValid() const;
@@ -42,6 +46,12 @@ public:
     void setCached(bool cached);
 
     WiFiNetwork &operator=(const WiFiNetwork &other);
+#ifdef Q_COMPILER_RVALUE_REFS
+    WiFiNetwork &operator=(WiFiNetwork &&other) Q_DECL_NOTHROW
+    { swap(other); return *this; }
+#endif
+    void swap(WiFiNetwork &other) Q_DECL_NOTHROW { qSwap(d, other.d); }
+
     bool operator==(const WiFiNetwork &other) const;
     bool operator!=(const WiFiNetwork &other) const;
 
@@ -67,13 +77,12 @@ public:
     static WiFiNetwork fromMap(const QVariantMap &map);
     static WiFiNetwork fromJson(const QByteArray &json);
 
-protected:
-    WiFiNetworkPrivate *d_ptr;
-
 private:
-    Q_DECLARE_PRIVATE(WiFiNetwork)
+    QSharedDataPointer<WiFiNetworkPrivate> d;
 };
 
+Q_DECLARE_SHARED(WiFiNetwork)
+
 class WiFiNetworkList : public QList<WiFiNetwork>
 {
 public:
@@ -86,4 +95,7 @@ public:
 
 QT_END_NAMESPACE
 
+Q_DECLARE_METATYPE(WiFiNetwork)
+Q_DECLARE_METATYPE(WiFiNetworkList)
+
 #endif // WIFINETWORK_H
@@ -24,7 +24,7 @@
 
 QT_BEGIN_NAMESPACE
 
-class WiFiScanResultPrivate
+class WiFiScanResultPrivate : public QSharedData
 {
 public:
     WiFiScanResultPrivate();
@@ -58,10 +58,13 @@ WiFiScanResultPrivate::WiFiScanResultPrivate() :
 /*!
     \class WiFiScanResult
     \inmodule WiFi
+    \ingroup shared
     \brief 类 WiFiScanResult 保存了测到的接入点的相关信息。
     \since 5.8
 
     描述有关检测到的接入点的信息。
+
+    WiFiScanResult 是隐式共享的值类型：复制只增加引用计数，修改时才分离数据。
 */
 
 
@@ -69,7 +72,7 @@ WiFiScanResultPrivate::WiFiScanResultPrivate() :
     构造一个无效的 WiFiScanResult 对象。
 */
 WiFiScanResult::WiFiScanResult() :
-    d_ptr(new WiFiScanResultPrivate)
+    d(new WiFiScanResultPrivate)
 {
 
 }
@@ -87,10 +90,8 @@ WiFiScanResult::WiFiScanResult(const QString &bssid, const QString &ssid)
 */
 WiFiScanResult::WiFiScanResult(const WiFiMacAddress &bssid,
                                const QString &ssid) :
-    d_ptr(new WiFiScanResultPrivate)
+    d(new WiFiScanResultPrivate)
 {
-    Q_D(WiFiScanResult);
-
     d->bssid = bssid;
     d->ssid = ssid;
     d->valid = true;
@@ -102,9 +103,8 @@ WiFiScanResult::WiFiScanResult(const WiFiMacAddress &bssid,
     构造一个 WiFiScanResult 对象，它是 \a other 的副本。
 */
 WiFiScanResult::WiFiScanResult(const WiFiScanResult &other) :
-    d_ptr(new WiFiScanResultPrivate)
+    d(other.d)
 {
-    *this = other;
 }
 
 /*!
@@ -112,7 +112,6 @@ WiFiScanResult::WiFiScanResult(const WiFiScanResult &other) :
 */
 WiFiScanResult::~WiFiScanResult()
 {
-    delete d_ptr;
 }
 
 /*!
@@ -120,7 +119,6 @@ WiFiScanResult::~WiFiScanResult()
 */
 bool WiFiScanResult::isValid() const
 {
-    Q_D(const WiFiScanResult);
     return d->valid;
 }
 
@@ -129,7 +127,6 @@ bool WiFiScanResult::isValid() const
  */
 bool WiFiScanResult::isCached() const
 {
-    Q_D(const WiFiScanResult);
     return d->cached;
 }
 
@@ -139,7 +136,6 @@ bool WiFiScanResult::isCached() const
   */
 void WiFiScanResult::setCached(bool cached)
 {
-    Q_D(WiFiScanResult);
     d->cached = cached;
 }
 
@@ -148,20 +144,7 @@ void WiFiScanResult::setCached(bool cached)
 */
 WiFiScanResult &WiFiScanResult::operator=(const WiFiScanResult &other)
 {
-    Q_D(WiFiScanResult);
-
-    d->bssid = other.d_func()->bssid;
-    d->ssid = other.d_func()->ssid;
-    d->valid = other.d_func()->valid;
-    d->cached = other.d_func()->cached;
-    d->rssi = other.d_func()->rssi;
-    d->frequency = other.d_func()->frequency;
-    d->authFlags = other.d_func()->authFlags;
-    d->encrFlags = other.d_func()->encrFlags;
-    d->flags = other.d_func()->flags;
-    d->timestamp = other.d_func()->timestamp;
-    d->networkId = other.d_func()->networkId;
-
+    d = other.d;
     return *this;
 }
 
@@ -172,9 +155,7 @@ WiFiScanResult &WiFiScanResult::operator=(const WiFiScanResult &other)
   */
 bool WiFiScanResult::operator==(const WiFiScanResult &other) const
 {
-    Q_D(const WiFiScanResult);
-
-    return d->bssid == other.d_func()->bssid;
+    return d->bssid == other.d->bssid;
 }
 
 /*!
@@ -192,7 +173,6 @@ bool WiFiScanResult::operator!=(const WiFiScanResult &other) const
 */
 WiFiMacAddress WiFiScanResult::bssid() const
 {
-    Q_D(const WiFiScanResult);
     return d->bssid;
 }
 
@@ -201,7 +181,6 @@ WiFiMacAddress WiFiScanResult::bssid() const
 */
 QString WiFiScanResult::ssid() const
 {
-    Q_D(const WiFiScanResult);
     return d->ssid;
 }
 
@@ -210,7 +189,6 @@ QString WiFiScanResult::ssid() const
 */
 qint16 WiFiScanResult::rssi() const
 {
-    Q_D(const WiFiScanResult);
     return d->rssi;
 }
 
@@ -219,7 +197,6 @@ qint16 WiFiScanResult::rssi() const
   */
 void WiFiScanResult::setRssi(qint16 rssi)
 {
-    Q_D(WiFiScanResult);
     d->rssi = rssi;
 }
 
@@ -228,7 +205,6 @@ void WiFiScanResult::setRssi(qint16 rssi)
 */
 int WiFiScanResult::frequency() const
 {
-    Q_D(const WiFiScanResult);
     return d->frequency;
 }
 
@@ -237,7 +213,6 @@ int WiFiScanResult::frequency() const
   */
 void WiFiScanResult::setFrequency(int frequency)
 {
-    Q_D(WiFiScanResult);
     d->frequency = frequency;
 }
 
@@ -282,7 +257,6 @@ void WiFiScanResult::setFrequency(int frequency)
 */
 QString WiFiScanResult::flags() const
 {
-    Q_D(const WiFiScanResult);
     return d->flags;
 }
 
@@ -291,7 +265,6 @@ QString WiFiScanResult::flags() const
   */
 void WiFiScanResult::setFlags(const QString &flags)
 {
-    Q_D(WiFiScanResult);
     d->flags = flags;
 }
 
@@ -300,7 +273,6 @@ void WiFiScanResult::setFlags(const QString &flags)
 */
 qint64 WiFiScanResult::timestamp() const
 {
-    Q_D(const WiFiScanResult);
     return d->timestamp;
 }
 
@@ -309,7 +281,6 @@ qint64 WiFiScanResult::timestamp() const
   */
 void WiFiScanResult::setTimestamp(qint64 microseconds)
 {
-    Q_D(WiFiScanResult);
     d->timestamp = microseconds;
 }
 
@@ -318,7 +289,6 @@ void WiFiScanResult::setTimestamp(qint64 microseconds)
   */
 int WiFiScanResult::networkId() const
 {
-    Q_D(const WiFiScanResult);
     return d->networkId;
 }
 
@@ -327,7 +297,6 @@ int WiFiScanResult::networkId() const
   */
 void WiFiScanResult::setNetworkId(int id)
 {
-    Q_D(WiFiScanResult);
     d->networkId = id;
 }
 
@@ -337,8 +306,6 @@ void WiFiScanResult::setNetworkId(int id)
 */
 bool WiFiScanResult::is24GHz() const
 {
-    Q_D(const WiFiScanResult);
-
     return d->frequency > 2400 && d->frequency < 2500;
 }
 
@@ -347,15 +314,11 @@ bool WiFiScanResult::is24GHz() const
 */
 bool WiFiScanResult::is5GHz() const
 {
-    Q_D(const WiFiScanResult);
-
     return d->frequency > 4900 && d->frequency < 5900;
 }
 
 QString WiFiScanResult::toString() const
 {
-    Q_D(const WiFiScanResult);
-
     QString s(QStringLiteral("BSSID = %1\n"
                              "SSID  = %2\n"
                              "RSSI  = %3\n"
@@ -380,7 +343,6 @@ QString WiFiScanResult::toString() const
 
 QVariantMap WiFiScanResult::toMap() const
 {
-    Q_D(const WiFiScanResult);
     QVariantMap map;
 
     map[QLatin1String("bssid")] = d->bssid.toString();
@@ -20,6 +20,7 @@
 #define WIFISCANRESULT_H
 
 #include <WiFi/wifiglobal.h>
+#include <QtCore/qshareddata.h>
 #include <WiFi/wifi.h>
 
 QT_BEGIN_NAMESPACE
@@ -33,6 +34,9 @@ public:
     WiFiScanResult(const QString &bssid, const QString &ssid);
     WiFiScanResult(const WiFiMacAddress &bssid, const QString &ssid);
     WiFiScanResult(const WiFiScanResult &other);
+#ifdef Q_COMPILER_RVALUE_REFS
+    WiFiScanResult(WiFiScanResult &&other) Q_DECL_NOTHROW : d(std::move(other.d)) {}
+#endif
     ~WiFiScanResult();
 
     bool isValid() const;
@@ -41,6 +45,12 @@ public:
     void setCached(bool cached);
 
     WiFiScanResult &operator=(const WiFiScanResult &other);
+#ifdef Q_COMPILER_RVALUE_REFS
+    WiFiScanResult &operator=(WiFiScanResult &&other) Q_DECL_NOTHROW
+    { swap(other); return *this; }
+#endif
+    void swap(WiFiScanResult &other) Q_DECL_NOTHROW { qSwap(d, other.d); }
+
     bool operator==(const WiFiScanResult &other) const;
     bool operator!=(const WiFiScanResult &other) const;
 
@@ -78,13 +88,12 @@ public:
     static WiFiScanResult fromMap(const QVariantMap &map);
     static WiFiScanResult fromJson(const QByteArray &json);
 
-protected:
-    WiFiScanResultPrivate *d_ptr;
-
 private:
-    Q_DECLARE_PRIVATE(WiFiScanResult)
+    QSharedDataPointer<WiFiScanResultPrivate> d;
 };
 
+Q_DECLARE_SHARED(WiFiScanResult)
+
 class WiFiScanResultList : public QList<WiFiScanResult>
 {
 public:
@@ -97,4 +106,7 @@ public:
 
 QT_END_NAMESPACE
 
+Q_DECLARE_METATYPE(WiFiScanResult)
+Q_DECLARE_METATYPE(WiFiScanResultList)
+
 #endif // WIFISCANRESULT_H
@@ -0,0 +1,126 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include "wifiscanresultstore_p.h"
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+QList<WiFiScanResultStore::Handle> WiFiScanResultStore::findBySsid(
+                const QString &ssid) const
+{
+    QList<Handle> handles;
+    for(auto it = m_bySsid.constFind(ssid);
+        it != m_bySsid.constEnd() && it.key() == ssid; ++it) {
+        handles << m_byBssid.value(it.value());
+    }
+    // QMultiHash 的顺序不确定，按槽位排序与 toList() 的顺序一致
+    std::sort(handles.begin(), handles.end());
+    return handles;
+}
+
+bool WiFiScanResultStore::isValid(Handle handle) const
+{
+    return handle >= 0 && handle < m_slots.size() && m_slots.at(handle).isValid();
+}
+
+/* 加入扫描结果，BSSID 已存在时更新该行，返回所在的行句柄。
+ */
+WiFiScanResultStore::Handle WiFiScanResultStore::insert(
+                const WiFiScanResult &result)
+{
+    const quint64 bssid = result.bssid().toUInt64();
+    Handle handle = find(bssid);
+    if(handle >= 0) {
+        update(handle, result);
+        return handle;
+    }
+
+    if(m_free.isEmpty()) {
+        handle = m_slots.size();
+        m_slots.append(result);
+    } else {
+        handle = m_free.takeLast();
+        m_slots[handle] = result;
+    }
+    m_byBssid.insert(bssid, handle);
+    m_bySsid.insert(result.ssid(), bssid);
+    return handle;
+}
+
+void WiFiScanResultStore::update(Handle handle, const WiFiScanResult &result)
+{
+    WiFiScanResult &slot = m_slots[handle];
+    if(slot.ssid() != result.ssid()) {
+        const quint64 bssid = slot.bssid().toUInt64();
+        m_bySsid.remove(slot.ssid(), bssid);
+        m_bySsid.insert(result.ssid(), bssid);
+    }
+    slot = result;
+}
+
+void WiFiScanResultStore::setNetworkId(Handle handle, int networkId)
+{
+    m_slots[handle].setNetworkId(networkId);
+}
+
+WiFiScanResult WiFiScanResultStore::take(Handle handle)
+{
+    WiFiScanResult result = m_slots.at(handle);
+    const quint64 bssid = result.bssid().toUInt64();
+    m_byBssid.remove(bssid);
+    m_bySsid.remove(result.ssid(), bssid);
+    m_slots[handle] = WiFiScanResult();
+    m_free.append(handle);
+    return result;
+}
+
+void WiFiScanResultStore::clear()
+{
+    m_slots.clear();
+    m_free.clear();
+    m_byBssid.clear();
+    m_bySsid.clear();
+}
+
+QList<WiFiScanResultStore::Handle> WiFiScanResultStore::handles() const
+{
+    QList<Handle> handles;
+    handles.reserve(count());
+    for(Handle handle = 0; handle < m_slots.size(); ++handle) {
+        if(m_slots.at(handle).isValid()) {
+            handles << handle;
+        }
+    }
+    return handles;
+}
+
+WiFiScanResultList WiFiScanResultStore::toList() const
+{
+    WiFiScanResultList list;
+    list.reserve(count());
+    for(const WiFiScanResult &result : m_slots) {
+        if(result.isValid()) {
+            list << result;
+        }
+    }
+    return list;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,69 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef WIFISCANRESULTSTORE_P_H
+#define WIFISCANRESULTSTORE_P_H
+
+#include <WiFi/wifiscanresult.h>
+#include <WiFi/wifimacaddress.h>
+
+#include <QtCore/qhash.h>
+#include <QtCore/qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+/* 以 48 位 BSSID(quint64) 为索引的扫描结果表，并维护 SSID -> BSSID 的二级索引。
+ * 每个扫描结果占用一个槽位，槽位号即行句柄，在结果被移除前保持不变；
+ * 移除后的槽位进入空闲链表，供之后加入的结果复用。
+ * 查找、加入、移除均为 O(1) 。
+ */
+class WiFiScanResultStore
+{
+public:
+    typedef int Handle;
+
+    int count() const { return m_byBssid.size(); }
+    bool isEmpty() const { return m_byBssid.isEmpty(); }
+
+    Handle find(quint64 bssid) const { return m_byBssid.value(bssid, -1); }
+    Handle find(const WiFiMacAddress &bssid) const { return find(bssid.toUInt64()); }
+    /* 按槽位顺序返回，与 toList() 中的先后一致 */
+    QList<Handle> findBySsid(const QString &ssid) const;
+
+    bool isValid(Handle handle) const;
+    const WiFiScanResult &at(Handle handle) const { return m_slots.at(handle); }
+
+    Handle insert(const WiFiScanResult &result);
+    void update(Handle handle, const WiFiScanResult &result);
+    void setNetworkId(Handle handle, int networkId);
+    WiFiScanResult take(Handle handle);
+    void clear();
+
+    QList<Handle> handles() const;
+    WiFiScanResultList toList() const;
+
+private:
+    QVector<WiFiScanResult> m_slots;
+    QVector<Handle> m_free;
+    QHash<quint64, Handle> m_byBssid;
+    QMultiHash<QString, quint64> m_bySsid;
+};
+
+QT_END_NAMESPACE
+
+#endif // WIFISCANRESULTSTORE_P_H
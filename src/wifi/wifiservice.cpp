@@ -19,6 +19,9 @@
 #include "wifiservice.h"
 #include "wifinative.h"
 #include "wifinativestub_p.h"
+#include "wifinativetransport_p.h"
+
+#include <QtDBus/qdbusserver.h>
 
 #include "wifidbus_p.h"
 #include "station_adaptor.h"
@@ -27,7 +30,8 @@
 
 WiFiService::WiFiService(QObject *parent) : QThread(parent)
 {
-
+    /* 同进程的 WiFiManager 改用队列连接访问服务线程 */
+    WiFiNativeRegistry::instance()->setHasService();
 }
 
 void WiFiService::run()
@@ -42,5 +46,28 @@ void WiFiService::run()
     //    connection.registerObject(WiFiDBus::peersPath, peers);
     WiFiDBus::connection().registerService(WiFiDBus::serviceName);
 
+    /* 本机其它进程的客户端可通过点对点套接字访问，不经过 dbus-daemon 转发 */
+    QDBusServer *server = NULL;
+    if(!WiFiDBus::preparePeerSocket()) {
+        qWarning("[FAIL] WiFi peer %s: cannot prepare the socket directory.",
+                 qUtf8Printable(WiFiDBus::peerAddress()));
+    } else {
+        server = new QDBusServer(WiFiDBus::peerAddress());
+        if(server->isConnected()) {
+            connect(server, &QDBusServer::newConnection, station,
+            [station](const QDBusConnection & connection) {
+                QDBusConnection(connection).registerObject(WiFiDBus::stationPath, station);
+            });
+        } else {
+            qWarning("[FAIL] WiFi peer %s: %s", qUtf8Printable(WiFiDBus::peerAddress()),
+                     qUtf8Printable(server->lastError().message()));
+        }
+    }
+
+    WiFiNativeRegistry::instance()->setStation(station);
+
     QThread::exec();
+
+    WiFiNativeRegistry::instance()->setStation(NULL);
+    delete server;
 }
@@ -42,125 +42,244 @@ WiFiSupplicantParser::WiFiSupplicantParser()
  */
 WiFiInfo WiFiSupplicantParser::fromStatus(const QString &status) const
 {
-    WiFiMacAddress address, bssid;
-    QString ssid, ip_address;
-    int frequency = 0, networkId = -1;
-    QStringList items = status.split(QRegExp(QStringLiteral("\\n")));
-    for (int i = 0; i < items.size(); i++) {
-        QString str = items.at(i);
-        if (str.startsWith(QStringLiteral("address="))) {
-            address = WiFiMacAddress(str.section(QLatin1Char('='), 1));
-        } else if(str.startsWith(QStringLiteral("bssid="))) {
-            bssid = WiFiMacAddress(str.section(QLatin1Char('='), 1));
-        } else if(str.startsWith(QStringLiteral("ssid="))) {
-            ssid = str.section(QLatin1Char('='), 1);
-        } else if(str.startsWith(QStringLiteral("freq="))) {
-            bool ok;
-            int freq = str.section(QLatin1Char('='), 1).trimmed().toInt(&ok);
-            if(ok) {
-                frequency = freq;
-            }
-        } else if(str.startsWith(QStringLiteral("ip_address="))) {
-            ip_address = str.section(QLatin1Char('='), 1);
-        } else if(str.startsWith(QStringLiteral("id="))) {
-            bool ok;
-            int id = str.section(QLatin1Char('='), 1).trimmed().toInt(&ok);
-            if(ok) {
-                networkId = id;
-            }
-        }
-    }
+    return fromStatus(status.toLocal8Bit());
+}
 
+WiFiInfo WiFiSupplicantParser::fromStatus(const QByteArray &status) const
+{
     WiFiInfo info;
-    info.setMacAddress(address);
-    info.setBSSID(bssid);
-    info.setSSID(ssid);
-    info.setFrequency(frequency);
-    info.setIpAddress(ip_address);
-    info.setNetworkId(networkId);
+    bool ok;
+    WiFiSupplicantTokenizer tokenizer(status);
+    while (tokenizer.readPair()) {
+        const QLatin1String value = tokenizer.value();
+        switch (tokenizer.keyHash()) {
+            case wifiKeyHash("address"):
+                if (tokenizer.key() == QLatin1String("address")) {
+                    info.setMacAddress(WiFiMacAddress(
+                                           WiFiSupplicantTokenizer::toMacAddress(value)));
+                }
+                break;
+            case wifiKeyHash("bssid"):
+                if (tokenizer.key() == QLatin1String("bssid")) {
+                    info.setBSSID(WiFiMacAddress(
+                                      WiFiSupplicantTokenizer::toMacAddress(value)));
+                }
+                break;
+            case wifiKeyHash("ssid"):
+                if (tokenizer.key() == QLatin1String("ssid")) {
+                    info.setSSID(QString::fromLocal8Bit(value.data(), value.size()));
+                }
+                break;
+            case wifiKeyHash("freq"):
+                if (tokenizer.key() == QLatin1String("freq")) {
+                    int freq = WiFiSupplicantTokenizer::toInt(value, &ok);
+                    if (ok) {
+                        info.setFrequency(freq);
+                    }
+                }
+                break;
+            case wifiKeyHash("ip_address"):
+                if (tokenizer.key() == QLatin1String("ip_address")) {
+                    info.setIpAddress(QString(value));
+                }
+                break;
+            case wifiKeyHash("id"):
+                if (tokenizer.key() == QLatin1String("id")) {
+                    int id = WiFiSupplicantTokenizer::toInt(value, &ok);
+                    if (ok) {
+                        info.setNetworkId(id);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
     return info;
 }
 
-/*
-    id=138
-    bssid=44:6e:e5:85:25:44
-    freq=2437
-    beacon_int=100
-    capabilities=0x0431
-    qual=0
-    noise=-89
-    level=-42
-    tsf=0000650706200712
-    age=7
-    ie=000748494b2d595a32010882848b960c1218240301060706434e20010d212a010032043048606c2d1aee111bffffff00000000000000000001000000000000000000003d16060d06000000000000000000000000000000000000007f080000000000000040dd180050f202010180000153000027a4000042435e0062322f00dd0900037f01010000ff7fdd8b0050f204104a0001101044000102103b00010310470010123456789abcdef01234446ee58525441021000f48756177656920436f2e2c206c74641023000b576972656c657373204150102400033132331042000531323334351054000800060050f20400011011001248756177656920576972656c6573732041501008000206801049000600372a00012030140100000fac040100000fac040100000fac020c00dd0f00e0fc800000000100446ee5852544
-    flags=[WPA2-PSK-CCMP][WPS][ESS]
-    ssid=HIK-YZ2
-    wps_state=configured
-    wps_primary_device_type=6-0050F204-1
-    wps_device_name=Huawei Wireless AP
-    wps_config_methods=0x0680
-    snr=47
-    est_throughput=135000
- */
 WiFiScanResult WiFiSupplicantParser::fromBSS(const QString &bss) const
 {
-    QString bssid, ssid, flags;
+    return fromBSS(bss.toLocal8Bit());
+}
+
+struct WiFiBSSFields
+{
+    int id = -1;
+    quint64 bssid = 0;
+    QString ssid;
+    QString flags;
     qint16 rssi = WiFi::MIN_RSSI;
     int frequency = 0;
-    QStringList items = bss.split(QRegExp(QStringLiteral("\\n")));
-    for (int i = 0; i < items.size(); i++) {
-        QString str = items.at(i);
-        if (str.startsWith(QStringLiteral("bssid="))) {
-            bssid = str.section(QLatin1Char('='), 1);
-        } else if (str.startsWith(QStringLiteral("ssid="))) {
-            ssid = str.section(QLatin1Char('='), 1);
-        } else if (str.startsWith(QStringLiteral("level="))) {
-            bool ok;
-            short level = str.section(QLatin1Char('='), 1).trimmed().toShort(&ok);
-            if(ok) {
-                rssi = level;
+
+    WiFiScanResult toScanResult() const
+    {
+        WiFiScanResult result(WiFiMacAddress(bssid), ssid);
+        result.setRssi(rssi);
+        result.setFrequency(frequency);
+        result.setFlags(flags);
+        return result;
+    }
+};
+
+static void readBSSPair(const WiFiSupplicantTokenizer &tokenizer,
+                        WiFiBSSFields *fields)
+{
+    const QLatin1String value = tokenizer.value();
+    bool ok;
+    switch (tokenizer.keyHash()) {
+        case wifiKeyHash("id"):
+            if (tokenizer.key() == QLatin1String("id")) {
+                int id = WiFiSupplicantTokenizer::toInt(value, &ok);
+                if (ok) {
+                    fields->id = id;
+                }
             }
-        } else if (str.startsWith(QStringLiteral("freq="))) {
-            bool ok;
-            int freq = str.section(QLatin1Char('='), 1).trimmed().toInt(&ok);
-            if(ok) {
-                frequency = freq;
+            break;
+        case wifiKeyHash("bssid"):
+            if (tokenizer.key() == QLatin1String("bssid")) {
+                fields->bssid = WiFiSupplicantTokenizer::toMacAddress(value);
+            }
+            break;
+        case wifiKeyHash("ssid"):
+            if (tokenizer.key() == QLatin1String("ssid")) {
+                fields->ssid = QString::fromLocal8Bit(value.data(), value.size());
+            }
+            break;
+        case wifiKeyHash("level"):
+            if (tokenizer.key() == QLatin1String("level")) {
+                int level = WiFiSupplicantTokenizer::toInt(value, &ok);
+                if (ok) {
+                    fields->rssi = qint16(level);
+                }
+            }
+            break;
+        case wifiKeyHash("freq"):
+            if (tokenizer.key() == QLatin1String("freq")) {
+                int freq = WiFiSupplicantTokenizer::toInt(value, &ok);
+                if (ok) {
+                    fields->frequency = freq;
+                }
+            }
+            break;
+        case wifiKeyHash("flags"):
+            if (tokenizer.key() == QLatin1String("flags")) {
+                fields->flags = QString(value);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+WiFiScanResult WiFiSupplicantParser::fromBSS(const QByteArray &bss) const
+{
+    WiFiBSSFields fields;
+    WiFiSupplicantTokenizer tokenizer(bss);
+    while (tokenizer.readPair()) {
+        readBSSPair(tokenizer, &fields);
+    }
+    return fields.toScanResult();
+}
+
+WiFiScanResultList WiFiSupplicantParser::fromBSSRange(const QString &range,
+        QList<int> *ids, bool *finished) const
+{
+    return fromBSSRange(range.toLocal8Bit(), ids, finished);
+}
+
+/*
+    id=3
+    bssid=0c:4b:54:7a:21:21
+    freq=2437
+    level=-47
+    flags=[WPA2-PSK-CCMP][ESS]
+    ssid=hsaeyz
+    ====
+    id=5
+    ...
+    ####
+*/
+WiFiScanResultList WiFiSupplicantParser::fromBSSRange(const QByteArray &range,
+        QList<int> *ids, bool *finished) const
+{
+    WiFiScanResultList list;
+    WiFiBSSFields fields;
+    WiFiSupplicantTokenizer tokenizer(range);
+    while (tokenizer.readPair()) {
+        if (tokenizer.key().size() == 0) {
+            // "====" 分隔行
+            if (fields.id >= 0) {
+                list << fields.toScanResult();
+                ids->append(fields.id);
             }
-        } else if (str.startsWith(QStringLiteral("flags="))) {
-            flags = str.section(QLatin1Char('='), 1);
+            fields = WiFiBSSFields();
+            continue;
         }
+        readBSSPair(tokenizer, &fields);
+    }
+    if (fields.id >= 0) {
+        // BSS 表中的最后一个 BSS 之后没有 "====" 分隔行
+        list << fields.toScanResult();
+        ids->append(fields.id);
     }
-    WiFiScanResult result(bssid, ssid);
-    result.setRssi(rssi);
-    result.setFrequency(frequency);
-    result.setFlags(flags);
-    return result;
+    *finished = range.trimmed().endsWith("####");
+    return list;
 }
 
 WiFiNetworkList WiFiSupplicantParser::fromListNetworks(const QString &networks)
 const
+{
+    return fromListNetworks(networks.toLocal8Bit());
+}
+
+/* network id / ssid / bssid / flags
+ * 0       example network any     [CURRENT]
+ */
+WiFiNetworkList WiFiSupplicantParser::fromListNetworks(const QByteArray &networks)
+const
 {
     WiFiNetworkList list;
-    QStringList items = networks.split(QRegExp(QStringLiteral("\\n"))).mid(1);
-    for (int i = 0; i < items.size(); i++) {
-        QStringList net = items.at(i).split(QRegExp(QStringLiteral("\\t")));
-        if(net.length() > 3) {
-            int id = net.at(0).toInt();
-            QString ssid = net.at(1);
-            list << WiFiNetwork(id, ssid);
+    WiFiSupplicantTokenizer tokenizer(networks);
+    tokenizer.readLine(); // 表头
+    while (tokenizer.readLine()) {
+        QLatin1String columns[4];
+        int count = 0;
+        while (count < 4 && tokenizer.readColumn()) {
+            columns[count++] = tokenizer.value();
+        }
+        if (count > 3) {
+            bool ok;
+            int id = WiFiSupplicantTokenizer::toInt(columns[0], &ok);
+            QString ssid = QString::fromLocal8Bit(columns[1].data(), columns[1].size());
+            WiFiNetwork network(ok ? id : 0, ssid);
+            // "any" 为空地址
+            network.setBSSID(WiFiMacAddress(
+                                 WiFiSupplicantTokenizer::toMacAddress(columns[2])));
+            list << network;
         }
     }
     return list;
 }
 
 QStringList WiFiSupplicantParser::fromScanResult(const QString &scan_results) const
+{
+    return fromScanResult(scan_results.toLocal8Bit());
+}
+
+/* bssid / frequency / signal level / flags / ssid
+ * 00:09:5b:95:e0:4e       2412    -40     [WPA-PSK-CCMP]  jkm private
+ */
+QStringList WiFiSupplicantParser::fromScanResult(const QByteArray &scan_results)
+const
 {
     QStringList list;
-    QStringList items = scan_results.split(QRegExp(QStringLiteral("\\n"))).mid(1);
-    for (int i = 0; i < items.size(); i++) {
-        QStringList net = items.at(i).split(QRegExp(QStringLiteral("\\t")));
-        if(net.length() > 1) {
-            list << net.at(0);
+    WiFiSupplicantTokenizer tokenizer(scan_results);
+    tokenizer.readLine(); // 表头
+    while (tokenizer.readLine()) {
+        if (tokenizer.readColumn() && tokenizer.line().size() >
+            tokenizer.value().size()) {
+            list << QString(tokenizer.value());
         }
     }
     return list;
@@ -24,6 +24,7 @@
 #include <WiFi/wifiinfo.h>
 #include <WiFi/wifiscanresult.h>
 #include <WiFi/wifinetwork.h>
+#include <WiFi/private/wifiglobal_p.h>
 
 #include <QtCore/qloggingcategory.h>
 
@@ -32,18 +33,149 @@ Q_DECLARE_LOGGING_CATEGORY(logWPA)
 
 QT_BEGIN_NAMESPACE
 
-class WiFiSupplicantParser
+/* 编译期计算 key 的 FNV-1a 哈希，用于 switch 分发。
+ */
+Q_DECL_CONSTEXPR inline quint32 wifiKeyHash(const char *key,
+        quint32 hash = 2166136261u)
+{
+    return *key ? wifiKeyHash(key + 1, (hash ^ quint32(quint8(*key))) * 16777619u)
+           : hash;
+}
+
+/* 单次遍历控制接口回复的词法分析器，不分配内存。
+ * key=value 形式的回复使用 readPair() 逐行读取，key() 与 value() 为指向原始
+ * 回复的切片，keyHash() 在扫描 key 时同步计算；表格形式的回复使用 readLine()
+ * 逐行读取，再用 readColumn() 读取以 '\t' 分隔的各列。
+ * 切片只在原始回复有效期间有效。
+ */
+class WiFiSupplicantTokenizer
+{
+public:
+    explicit WiFiSupplicantTokenizer(const QByteArray &reply)
+        : m_pos(reply.constData()), m_end(reply.constData() + reply.size()) {}
+    // 切片指向 reply 的数据，临时对象会使其失效
+    WiFiSupplicantTokenizer(QByteArray &&) = delete;
+
+    bool readPair()
+    {
+        while (m_pos < m_end) {
+            const char *start = m_pos;
+            quint32 hash = 2166136261u;
+            while (m_pos < m_end && *m_pos != '=' && *m_pos != '\n') {
+                hash = (hash ^ quint32(quint8(*m_pos))) * 16777619u;
+                ++m_pos;
+            }
+            if (m_pos == m_end || *m_pos == '\n') {
+                ++m_pos; // 跳过不含 '=' 的行
+                continue;
+            }
+            m_key = QLatin1String(start, int(m_pos - start));
+            m_keyHash = hash;
+            start = ++m_pos;
+            while (m_pos < m_end && *m_pos != '\n') {
+                ++m_pos;
+            }
+            m_value = QLatin1String(start, int(m_pos - start));
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool readLine()
+    {
+        if (m_pos >= m_end) {
+            return false;
+        }
+        const char *start = m_pos;
+        while (m_pos < m_end && *m_pos != '\n') {
+            ++m_pos;
+        }
+        m_line = QLatin1String(start, int(m_pos - start));
+        m_column = start;
+        ++m_pos;
+        return true;
+    }
+
+    bool readColumn()
+    {
+        const char *end = m_line.data() + m_line.size();
+        if (!m_column || m_column > end) {
+            return false;
+        }
+        const char *start = m_column;
+        while (m_column < end && *m_column != '\t') {
+            ++m_column;
+        }
+        m_value = QLatin1String(start, int(m_column - start));
+        ++m_column;
+        return true;
+    }
+
+    QLatin1String key() const { return m_key; }
+    quint32 keyHash() const { return m_keyHash; }
+    QLatin1String value() const { return m_value; }
+    QLatin1String line() const { return m_line; }
+
+    static int toInt(QLatin1String value, bool *ok)
+    {
+        const char *p = value.data(), *end = p + value.size();
+        while (p < end && *p == ' ') {
+            ++p;
+        }
+        bool negative = p < end && *p == '-';
+        if (negative || (p < end && *p == '+')) {
+            ++p;
+        }
+        int result = 0;
+        *ok = p < end;
+        for (; p < end && *ok; ++p) {
+            *ok = *p >= '0' && *p <= '9';
+            result = result * 10 + (*p - '0');
+        }
+        return negative ? -result : result;
+    }
+
+    /* "xx:xx:xx:xx:xx:xx" 或 "xxxxxxxxxxxx" ，失败时返回 0 */
+    static quint64 toMacAddress(QLatin1String value)
+    {
+        return WiFiMacAddress::parse(value.data(), value.size());
+    }
+
+private:
+    const char *m_pos;
+    const char *m_end;
+    const char *m_column = NULL;
+    QLatin1String m_key;
+    QLatin1String m_value;
+    QLatin1String m_line;
+    quint32 m_keyHash = 0;
+};
+
+class Q_WIFI_PRIVATE_EXPORT WiFiSupplicantParser
 {
 public:
     WiFiSupplicantParser();
 
     WiFiInfo fromStatus(const QString &status) const;
+    WiFiInfo fromStatus(const QByteArray &status) const;
 
     WiFiScanResult fromBSS(const QString &bss) const;
+    WiFiScanResult fromBSS(const QByteArray &bss) const;
+
+    /* 解析 "BSS RANGE=<first>-<last> MASK=<mask>" 的回复，ids 按顺序保存各 BSS 的 id ，
+     * finished 表示回复以 "####" 结束，即已包含 BSS 表中的最后一个 BSS 。
+     */
+    WiFiScanResultList fromBSSRange(const QString &range, QList<int> *ids,
+                                    bool *finished) const;
+    WiFiScanResultList fromBSSRange(const QByteArray &range, QList<int> *ids,
+                                    bool *finished) const;
 
     WiFiNetworkList fromListNetworks(const QString &networks) const;
+    WiFiNetworkList fromListNetworks(const QByteArray &networks) const;
 
     QStringList fromScanResult(const QString &scan_results) const;
+    QStringList fromScanResult(const QByteArray &scan_results) const;
 
     WiFi::AuthFlags fromProtoKeyMgmt(const QString &proto,
                                      const QString &key_mgmt) const;
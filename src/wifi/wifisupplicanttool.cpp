@@ -17,6 +17,9 @@
  **/
 
 #include "wifisupplicanttool_p.h"
+#include "wifiactionrunner_p.h"
+
+#include <QtCore/qfileinfo.h>
 
 extern "C"
 {
@@ -25,6 +28,17 @@ extern "C"
 #include "utils/common.h"
 }
 
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+#if defined(CONFIG_CTRL_IFACE_UNIX)
+#include <sys/stat.h>
+#include "wifidhcpclient_p.h"
+#endif
+
 // in one source file
 Q_LOGGING_CATEGORY(logWPA, "wifi.wpa.tool", QtInfoMsg)
 Q_LOGGING_CATEGORY(logWPASupp, "wifi.wpa.supp", QtInfoMsg)
@@ -37,6 +51,34 @@ static QByteArray WIFI_WPA_COMMAND =
                 "wpa_supplicant -c /etc/wpa_supplicant.conf";
 static QByteArray WIFI_WPA_ACTION_DHCPC = "/sbin/dhcpc_action.sh";
 static QByteArray WIFI_WPA_ACTION_DHCPD = "/sbin/dhcpd_action.sh";
+static int WIFI_WPA_ACTION_TIMEOUT = 10000; // msecs, 动作脚本的执行时限, 0 表示不限时
+/* 获取 IP 地址的方式：
+ *      native  进程内的 WiFiDhcpClient (默认，仅 Unix)
+ *      script  执行 WIFI_WPA_ACTION_DHCPC 脚本
+ */
+static QByteArray WIFI_DHCPC = "native";
+/* WiFiDhcpClient 获取租约超时后重新 DISCOVER 的退避间隔，每次失败加倍 */
+static const int WIFI_DHCPC_RESTART_MIN = 1000; // msecs
+static const int WIFI_DHCPC_RESTART_MAX = 60000; // msecs
+static const uint WIFI_WPA_BSS_MASK = WPA_BSS_MASK_ID | WPA_BSS_MASK_BSSID |
+                                     WPA_BSS_MASK_FREQ | WPA_BSS_MASK_LEVEL |
+                                     WPA_BSS_MASK_FLAGS | WPA_BSS_MASK_SSID |
+                                     WPA_BSS_MASK_DELIM;
+static const int WIFI_WPA_PIPELINE_DEPTH = 16; // 控制接口一次写入的最大请求数
+static const int WIFI_WPA_REQUEST_TIMEOUT = 10000; // msecs, 与 wpa_ctrl_request 一致
+static int WIFI_WPA_OPEN_RETRY = 500; // msecs, 目录监视之外的兜底重试间隔
+static int WIFI_WPA_OPEN_TIMEOUT = 5000; // msecs
+static const int WIFI_WPA_OPEN_POLL = 50; // msecs, 无法监视目录时的轮询间隔
+/* 启动时是否连接已在运行的 wpa_supplicant(例如由 systemd 管理)：
+ *      auto    能连接控制接口则直接使用，否则启动 WIFI_WPA_COMMAND (默认)
+ *      only    只连接，不启动进程，等待控制接口出现
+ *      off     总是启动 WIFI_WPA_COMMAND
+ */
+static QByteArray WIFI_WPA_ATTACH = "auto";
+/* 意外退出后重新启动的退避间隔，每次失败加倍，稳定运行一段时间后复位 */
+static int WIFI_WPA_RESTART_MIN = 100; // msecs
+static int WIFI_WPA_RESTART_MAX = 30000; // msecs
+static const int WIFI_WPA_RESTART_STABLE = 10000; // msecs
 
 
 WiFiSupplicantToolPrivate::WiFiSupplicantToolPrivate()
@@ -57,6 +99,48 @@ WiFiSupplicantToolPrivate::WiFiSupplicantToolPrivate()
     if(!qEnvironmentVariableIsEmpty("WIFI_WPA_ACTION_DHCPD")) {
         WIFI_WPA_ACTION_DHCPD = qgetenv("WIFI_WPA_ACTION_DHCPD");
     }
+    if(!qEnvironmentVariableIsEmpty("WIFI_WPA_ACTION_TIMEOUT")) {
+        bool ok;
+        int timeout = qgetenv("WIFI_WPA_ACTION_TIMEOUT").toInt(&ok);
+        if(ok && timeout >= 0) {
+            WIFI_WPA_ACTION_TIMEOUT = timeout;
+        }
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_DHCPC")) {
+        WIFI_DHCPC = qgetenv("WIFI_DHCPC");
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_WPA_ATTACH")) {
+        WIFI_WPA_ATTACH = qgetenv("WIFI_WPA_ATTACH");
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_WPA_RESTART_MIN")) {
+        bool ok;
+        int restart = qgetenv("WIFI_WPA_RESTART_MIN").toInt(&ok);
+        if(ok && restart > 0) {
+            WIFI_WPA_RESTART_MIN = restart;
+        }
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_WPA_RESTART_MAX")) {
+        bool ok;
+        int restart = qgetenv("WIFI_WPA_RESTART_MAX").toInt(&ok);
+        if(ok && restart > 0) {
+            WIFI_WPA_RESTART_MAX = restart;
+        }
+    }
+    WIFI_WPA_RESTART_MAX = qMax(WIFI_WPA_RESTART_MAX, WIFI_WPA_RESTART_MIN);
+    if(!qEnvironmentVariableIsEmpty("WIFI_WPA_OPEN_RETRY")) {
+        bool ok;
+        int retry = qgetenv("WIFI_WPA_OPEN_RETRY").toInt(&ok);
+        if(ok && retry > 0) {
+            WIFI_WPA_OPEN_RETRY = retry;
+        }
+    }
+    if(!qEnvironmentVariableIsEmpty("WIFI_WPA_OPEN_TIMEOUT")) {
+        bool ok;
+        int timeout = qgetenv("WIFI_WPA_OPEN_TIMEOUT").toInt(&ok);
+        if(ok && timeout > 0) {
+            WIFI_WPA_OPEN_TIMEOUT = timeout;
+        }
+    }
 
     m_interface = QString::fromLocal8Bit(WIFI_WPA_INTERFACE);
     m_interfacePath = QString(QStringLiteral("%1/%2")).arg(QString::fromLocal8Bit(
@@ -72,6 +156,16 @@ void WiFiSupplicantToolPrivate::startSupplicant()
 {
     Q_Q(WiFiSupplicantTool);
 
+    m_stopping = false;
+    if(m_restartTimer) {
+        m_restartTimer->stop();
+    }
+
+    m_startTime.start();
+    if(this->attachSupplicant()) {
+        return;
+    }
+
     if(!m_wpaProcess) {
         QStringList command = QString::fromLocal8Bit(WIFI_WPA_COMMAND).split(
                                               QLatin1Char(' '));
@@ -97,8 +191,52 @@ void WiFiSupplicantToolPrivate::startSupplicant()
     m_wpaProcess->start();
 }
 
+/*
+ * 连接已在运行的 wpa_supplicant ，沿用其 BSS 表和当前关联，不重新启动进程。
+ * WIFI_WPA_ATTACH=only 时即使暂时无法连接也不启动进程，由目录监视等待控制接口出现。
+ */
+bool WiFiSupplicantToolPrivate::attachSupplicant()
+{
+    Q_Q(WiFiSupplicantTool);
+
+    if(WIFI_WPA_ATTACH == "off") {
+        return false;
+    }
+    if(m_wpaProcess && m_wpaProcess->state() != QProcess::NotRunning) {
+        return false;
+    }
+
+    m_attached = true;
+    if(wpaOpenConnection()) {
+        qCInfo(logWPA, "[ OK ] Attach to running wpa_supplicant.%s",
+               wifiPrintTimes(m_startTime.elapsed()));
+        Q_EMIT q->supplicantStarted();
+        return true;
+    }
+    if(WIFI_WPA_ATTACH == "only") {
+        qCInfo(logWPA, "[ OK ] Wait for wpa_supplicant on %s.",
+               qUtf8Printable(m_interfacePath));
+        this->_q_startSupplicantDone();
+        return true;
+    }
+    m_attached = false;
+    return false;
+}
+
 void WiFiSupplicantToolPrivate::stopSupplicant()
 {
+    m_stopping = true;
+    if (m_restartTimer) {
+        m_restartTimer->stop();
+    }
+    if (m_attached) {
+        // 不由本进程管理的 wpa_supplicant 只断开连接
+        this->stopTryOpen();
+        this->wpaCloseConnection();
+        m_attached = false;
+        Q_EMIT q_func()->supplicantFinished();
+        return;
+    }
     if (m_wpaProcess) {
         if (m_wpaProcess->state() != QProcess::NotRunning) {
             m_wpaProcess->kill();
@@ -125,17 +263,33 @@ void WiFiSupplicantToolPrivate::_q_printSupplicantError()
     }
 }
 
+/*
+ * wpa_supplicant 创建控制接口套接字时 WIFI_WPA_INTERFACE_DIR 目录会发生变化，
+ * 由此触发打开连接，不再每 50ms 轮询一次。
+ */
 void WiFiSupplicantToolPrivate::_q_startSupplicantDone()
+{
+    this->startTryOpen();
+    this->tryOpenSupplicant();
+}
+
+void WiFiSupplicantToolPrivate::startTryOpen()
 {
     Q_Q(WiFiSupplicantTool);
 
+    if(!m_interfaceWatcher) {
+        m_interfaceWatcher = new QFileSystemWatcher(q);
+        q->connect(m_interfaceWatcher, SIGNAL(directoryChanged(QString)), q,
+                   SLOT(_q_interfaceDirChanged(QString)));
+    }
     if(!m_tryOpenTimer) {
         m_tryOpenTimer = new QTimer(q);
-        m_tryOpenTimer->setInterval(50);
         m_tryOpenTimer->connect(m_tryOpenTimer, SIGNAL(timeout()), q,
                                 SLOT(_q_tryOpenTimeout()));
     }
+    m_tryOpenTimer->setInterval(WIFI_WPA_OPEN_RETRY);
 
+    this->watchInterfaceDir();
     m_tryOpenTimer->start();
 }
 
@@ -148,8 +302,14 @@ void WiFiSupplicantToolPrivate::_q_stopSupplicantDone(int exitCode,
         qCCritical(logWPA, "[FAIL] wpa_supplicant is crashed(%d).", exitCode);
     }
 
+    this->stopTryOpen();
     this->wpaCloseConnection();
-    Q_EMIT q->supplicantFinished();
+    if (m_stopping) {
+        m_stopping = false;
+        Q_EMIT q->supplicantFinished();
+    } else {
+        this->scheduleRestart();
+    }
 }
 
 void WiFiSupplicantToolPrivate::_q_supplicantCrashed(QProcess::ProcessError
@@ -159,6 +319,10 @@ void WiFiSupplicantToolPrivate::_q_supplicantCrashed(QProcess::ProcessError
                qUtf8Printable(this->m_wpaProcess->errorString()));
     switch (error) {
         case QProcess::FailedToStart:
+            // 启动失败时不会有 finished 信号
+            if (!m_stopping) {
+                this->scheduleRestart();
+            }
             break;
         case QProcess::Crashed:
             break;
@@ -168,30 +332,213 @@ void WiFiSupplicantToolPrivate::_q_supplicantCrashed(QProcess::ProcessError
 }
 
 void WiFiSupplicantToolPrivate::_q_tryOpenTimeout()
+{
+    this->tryOpenSupplicant();
+}
+
+void WiFiSupplicantToolPrivate::_q_interfaceDirChanged(const QString &path)
+{
+    Q_UNUSED(path);
+
+    /* 目录本身由 wpa_supplicant 创建时，改为监视该目录 */
+    this->watchInterfaceDir();
+    if(m_terminatedSocket || QFileInfo::exists(m_interfacePath)) {
+        this->tryOpenSupplicant();
+    }
+}
+
+/* 控制接口套接字的 inode ，不存在时为 0 */
+quint64 WiFiSupplicantToolPrivate::interfaceSocketId() const
+{
+#if defined(CONFIG_CTRL_IFACE_UNIX)
+    struct stat st;
+    if(::stat(QFile::encodeName(m_interfacePath).constData(), &st) == 0) {
+        return quint64(st.st_ino);
+    }
+#endif
+    return 0;
+}
+
+void WiFiSupplicantToolPrivate::tryOpenSupplicant()
 {
     Q_Q(WiFiSupplicantTool);
 
-    if(m_wpaProcess->state() == QProcess::Running) {
-        if(wpaOpenConnection()) {
-            qCInfo(logWPA, "[ OK ] Start wpa_supplicant successed.%s",
-                   wifiPrintTimes((m_tryOpenTimes + 1) * m_tryOpenTimer->interval()));
-            m_tryOpenTimer->stop();
-            m_tryOpenTimes = 0;
-            Q_EMIT q->supplicantStarted();
-        } else if(m_tryOpenTimes < 100) {
-            m_tryOpenTimes ++;
-        } else {
-            qCWarning(logWPA, "[FAIL] Start wpa_supplicant failed.%s",
-                      wifiPrintTimes((m_tryOpenTimes + 1) * m_tryOpenTimer->interval()));
-            m_tryOpenTimer->stop();
-            m_tryOpenTimes = 0;
+    if(!m_attached && (!m_wpaProcess || m_wpaProcess->state() != QProcess::Running)) {
+        return;
+    }
+    if(m_terminatedSocket) {
+        /* 退出中的进程仍持有原来的套接字，等它被删除或被新进程的套接字替换 */
+        const quint64 id = interfaceSocketId();
+        if(id == m_terminatedSocket) {
+            return;
+        }
+        m_terminatedSocket = 0;
+    }
+
+    if(wpaOpenConnection()) {
+        qCInfo(logWPA, "[ OK ] Start wpa_supplicant successed.%s",
+               wifiPrintTimes(m_startTime.elapsed()));
+        this->stopTryOpen();
+        Q_EMIT q->supplicantStarted();
+    } else if(!m_attached && m_startTime.elapsed() >= WIFI_WPA_OPEN_TIMEOUT) {
+        qCWarning(logWPA, "[FAIL] Start wpa_supplicant failed.%s",
+                  wifiPrintTimes(m_startTime.elapsed()));
+        this->stopTryOpen();
+        // 结束无响应的进程，由 _q_stopSupplicantDone 重新启动
+        m_wpaProcess->kill();
+    }
+}
+
+/*
+ * 按 WIFI_WPA_RESTART_MIN * 2^n 的间隔重新启动，不超过 WIFI_WPA_RESTART_MAX ；
+ * 上一次运行超过 WIFI_WPA_RESTART_STABLE 时从最小间隔重新开始。
+ */
+void WiFiSupplicantToolPrivate::scheduleRestart()
+{
+    Q_Q(WiFiSupplicantTool);
+
+    if(m_startTime.isValid() && m_startTime.elapsed() >= WIFI_WPA_RESTART_STABLE) {
+        m_restartAttempts = 0;
+    }
+    // 先以 64 位计算再截断，较大的最小间隔左移时不会溢出
+    int delay = int(qMin(qint64(WIFI_WPA_RESTART_MIN) << qMin(m_restartAttempts, 16),
+                         qint64(WIFI_WPA_RESTART_MAX)));
+    m_restartAttempts++;
+
+    if(!m_restartTimer) {
+        m_restartTimer = new QTimer(q);
+        m_restartTimer->setSingleShot(true);
+        m_restartTimer->connect(m_restartTimer, SIGNAL(timeout()), q,
+                                SLOT(_q_restartTimeout()));
+    }
+    qCWarning(logWPA, "[FAIL] Restart wpa_supplicant in %d ms (attempt %d).",
+              delay, m_restartAttempts);
+    m_restartTimer->start(delay);
+    Q_EMIT q->supplicantRestarting();
+}
+
+void WiFiSupplicantToolPrivate::_q_restartTimeout()
+{
+    if(ctrl_conn || (m_wpaProcess && m_wpaProcess->state() != QProcess::NotRunning)) {
+        return;
+    }
+    this->startSupplicant();
+}
+
+void WiFiSupplicantToolPrivate::watchInterfaceDir()
+{
+    const QString dir = QString::fromLocal8Bit(WIFI_WPA_INTERFACE_DIR);
+    if(m_interfaceWatcher->directories().contains(dir)) {
+        return;
+    }
+
+    bool watched = true;
+    if(QFileInfo::exists(dir)) {
+        m_interfaceWatcher->removePaths(m_interfaceWatcher->directories());
+        watched = m_interfaceWatcher->addPath(dir);
+    } else {
+        const QString parent = QFileInfo(dir).absolutePath();
+        if(!m_interfaceWatcher->directories().contains(parent)) {
+            watched = m_interfaceWatcher->addPath(parent);
         }
     }
+    if(!watched) {
+        qCWarning(logWPA, "[FAIL] Watch %s failed, fall back to polling.",
+                  qUtf8Printable(dir));
+        m_tryOpenTimer->setInterval(WIFI_WPA_OPEN_POLL);
+    }
+}
+
+void WiFiSupplicantToolPrivate::stopTryOpen()
+{
+    m_terminatedSocket = 0;
+    if(m_tryOpenTimer) {
+        m_tryOpenTimer->stop();
+    }
+    if(m_interfaceWatcher && !m_interfaceWatcher->directories().isEmpty()) {
+        m_interfaceWatcher->removePaths(m_interfaceWatcher->directories());
+    }
+}
+
+/* 以组接口为队列异步执行 WIFI_WPA_ACTION_DHCPD ，同一组的启动和移除按事件顺序执行，
+ * 事件分发不等待脚本结束。脚本参数保持为 <interface> <event message> 。
+ */
+void WiFiSupplicantToolPrivate::runAction(const QString &group, const QString &message)
+{
+    Q_Q(WiFiSupplicantTool);
+
+    if(!m_actionRunner) {
+        m_actionRunner = new WiFiActionRunner(q);
+        m_actionRunner->setTimeout(WIFI_WPA_ACTION_TIMEOUT);
+        QObject::connect(m_actionRunner, &WiFiActionRunner::actionFinished, q,
+                         [q](int, const QString & key, const QStringList & arguments,
+                             WiFiActionRunner::Result result, int) {
+            Q_EMIT q->actionFinished(key, arguments.value(1),
+                                     result == WiFiActionRunner::Success);
+        });
+    }
+
+    const QString key = group.isEmpty() ? m_interface : group;
+    m_actionRunner->enqueue(key, QString::fromLocal8Bit(WIFI_WPA_ACTION_DHCPD),
+                            QStringList() << m_interface << message);
+}
+
+/* 以接口为队列异步执行 WIFI_WPA_ACTION_DHCPC ，快速断开重连时 DISCONNECTED 与
+ * CONNECTED 按事件顺序执行，不会被后一个脚本超过。失败由 WiFiActionRunner 记录。
+ */
+/*
+ * WiFiDhcpClient 在 WIFI_DHCPC_TIMEOUT 内没有获得租约，链路仍然连接着，
+ * 按退避间隔重新开始获取，直到获得租约或 dhcpc_release() 。
+ */
+void WiFiSupplicantToolPrivate::_q_dhcpcFailed()
+{
+    Q_Q(WiFiSupplicantTool);
+
+    int delay = int(qMin(qint64(WIFI_DHCPC_RESTART_MIN) << qMin(m_dhcpcAttempts, 16),
+                         qint64(WIFI_DHCPC_RESTART_MAX)));
+    m_dhcpcAttempts++;
+
+    if(!m_dhcpcRestartTimer) {
+        m_dhcpcRestartTimer = new QTimer(q);
+        m_dhcpcRestartTimer->setSingleShot(true);
+        m_dhcpcRestartTimer->connect(m_dhcpcRestartTimer, SIGNAL(timeout()), q,
+                                     SLOT(_q_dhcpcRestartTimeout()));
+    }
+    qCWarning(logWPA, "[FAIL] Restart DHCP on %s in %d ms (attempt %d).",
+              qUtf8Printable(m_interface), delay, m_dhcpcAttempts);
+    m_dhcpcRestartTimer->start(delay);
+}
+
+void WiFiSupplicantToolPrivate::_q_dhcpcRestartTimeout()
+{
+#if defined(CONFIG_CTRL_IFACE_UNIX)
+    if(m_dhcpClient && m_dhcpClient->state() == WiFiDhcpClient::Stopped) {
+        m_dhcpClient->start(m_dhcpcBssid, m_dhcpcSsid);
+    }
+#endif
+}
+
+void WiFiSupplicantToolPrivate::runDhcpcAction(const QString &event)
+{
+    Q_Q(WiFiSupplicantTool);
+
+    // 连续的 DISCONNECTED 只执行一次，客户端已经停止
+    if(event == m_dhcpcEvent && event == QLatin1String("DISCONNECTED")) {
+        return;
+    }
+    m_dhcpcEvent = event;
+
+    if(!m_dhcpcRunner) {
+        m_dhcpcRunner = new WiFiActionRunner(q);
+        m_dhcpcRunner->setTimeout(WIFI_WPA_ACTION_TIMEOUT);
+    }
+    m_dhcpcRunner->enqueue(m_interface, QString::fromLocal8Bit(WIFI_WPA_ACTION_DHCPC),
+                           QStringList() << m_interface << event);
 }
 
-void WiFiSupplicantToolPrivate::wpaProcessMsg(char *msg)
+void WiFiSupplicantToolPrivate::wpaProcessMsg(const char *msg)
 {
-    char *pos = msg;
+    const char *pos = msg;
     int priority = 2;
 
     if (*pos == '<') {
@@ -209,19 +556,38 @@ void WiFiSupplicantToolPrivate::wpaProcessMsg(char *msg)
     qCDebug(logWPA, "[ DEBUG ] WPA EVENT MSG<%d> : %s", priority,
             qUtf8Printable(message));
 
-    if(message.startsWith(QStringLiteral(P2P_EVENT_GROUP_STARTED))) {
-        QProcess::execute(QString::fromLocal8Bit(WIFI_WPA_ACTION_DHCPD),
-                          QStringList() << m_interface << message);
-    } else if(message.startsWith(QStringLiteral(P2P_EVENT_GROUP_REMOVED))) {
-        QProcess::execute(QString::fromLocal8Bit(WIFI_WPA_ACTION_DHCPD),
-                          QStringList() << m_interface << message);
+    if(message.startsWith(QStringLiteral(P2P_EVENT_GROUP_STARTED)) ||
+       message.startsWith(QStringLiteral(P2P_EVENT_GROUP_REMOVED))) {
+        // P2P-GROUP-STARTED p2p-wlan0-0 GO ssid="DIRECT-xy" freq=2437 ...
+        this->runAction(message.section(QLatin1Char(' '), 1, 1), message);
     }
 
     Q_EMIT q_func()->messageReceived(message);
+
+    if(m_attached && message.startsWith(QStringLiteral(WPA_EVENT_TERMINATING))) {
+        /* 外部管理的 wpa_supplicant 退出时没有 QProcess::finished 通知，
+         * 由其管理者(例如 systemd)负责重新启动，这里只等待控制接口再次出现。
+         */
+        qCWarning(logWPA, "[FAIL] Attached wpa_supplicant terminated, wait for it.");
+        this->wpaCloseConnection();
+        Q_EMIT q_func()->supplicantRestarting();
+        m_startTime.start();
+        // 退出中的进程可能仍在应答，原来的套接字消失之前不再连接
+        this->startTryOpen();
+        m_terminatedSocket = interfaceSocketId();
+    }
 }
 
 void WiFiSupplicantToolPrivate::wpaMonitorMsg()
 {
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+    QByteArray msg;
+    while (monitor_conn &&
+           wpaCtrlRecv(wpa_ctrl_get_fd(monitor_conn), MSG_DONTWAIT,
+                       m_eventBuffer, &msg, false)) {
+        wpaProcessMsg(msg.constData());
+    }
+#else
     char buf[256];
     size_t len;
 
@@ -232,6 +598,7 @@ void WiFiSupplicantToolPrivate::wpaMonitorMsg()
             wpaProcessMsg(buf);
         }
     }
+#endif
 }
 
 bool WiFiSupplicantToolPrivate::wpaOpenConnection()
@@ -267,11 +634,21 @@ bool WiFiSupplicantToolPrivate::wpaOpenConnection()
                             &WiFiSupplicantToolPrivate::wpaMonitorMsg);
 #endif
 
+    this->wpaAsyncOpen();
+
     return true;
 }
 
 bool WiFiSupplicantToolPrivate::wpaCloseConnection()
 {
+    this->wpaAsyncClose();
+
+    QQueue<WiFiSupplicantRequest> requests = m_asyncQueued;
+    m_asyncQueued.clear();
+    for (WiFiSupplicantRequest &request : requests) {
+        wpaAsyncFinish(request, QByteArray());
+    }
+
     if (ctrl_conn) {
         wpa_ctrl_close(ctrl_conn);
         ctrl_conn = NULL;
@@ -289,35 +666,366 @@ bool WiFiSupplicantToolPrivate::wpaCloseConnection()
     return true;
 }
 
-QString WiFiSupplicantToolPrivate::wpaCtrlRequest(const QString &command) const
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+/* 读取一个数据报到可复用的 buffer 中，返回指向该缓冲区的切片 reply ，
+ * 在下一次使用同一缓冲区前有效。buffer 只增不减，较大的回复不会被截断；
+ * decode 为 true 时原地执行 printf_decode 。
+ */
+bool WiFiSupplicantToolPrivate::wpaCtrlRecv(int fd, int flags,
+        QByteArray &buffer, QByteArray *reply, bool decode) const
+{
+    ssize_t size = recv(fd, NULL, 0, flags | MSG_PEEK | MSG_TRUNC);
+    if (size < 0) {
+        return false;
+    }
+    if (buffer.size() < size + 1) {
+        buffer.resize(size + 1);
+    }
+
+    char *buf = buffer.data();
+    ssize_t len = recv(fd, buf, buffer.size() - 1, flags);
+    if (len < 0) {
+        return false;
+    }
+    buf[len] = '\0';
+    if (decode && len > 0 && buf[0] != '<') {
+        /* 解码后的长度不会超过原始长度，可以原地解码 */
+        len = printf_decode((u8 *)buf, len + 1, buf);
+    }
+
+    *reply = QByteArray::fromRawData(buf, int(len));
+    return true;
+}
+
+/* 等待 fd 上的下一个回复，跳过非请求的事件消息。
+ */
+bool WiFiSupplicantToolPrivate::wpaCtrlWait(int fd, const QByteArray &command,
+        QByteArray *reply) const
+{
+    forever {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        int ret = poll(&pfd, 1, WIFI_WPA_REQUEST_TIMEOUT);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            qCCritical(logWPA, "[FAIL] Timeout to wpa_ctrl_request.\n%s",
+                       command.constData());
+            return false;
+        }
+        if (!wpaCtrlRecv(fd, 0, m_replyBuffer, reply)) {
+            qCCritical(logWPA, "[FAIL] Failed to wpa_ctrl_request.\n%s",
+                       command.constData());
+            return false;
+        }
+        if (!reply->startsWith('<')) {
+            return true;
+        }
+    }
+}
+
+/* 请求超时或失败时，仍在途中的回复会被下一个同步请求当作自己的回复读取，
+ * 之后的回复全部错位。重新打开 ctrl_conn 丢弃这些回复；无法重新打开时
+ * 至少清空已经到达的回复。
+ */
+void WiFiSupplicantToolPrivate::wpaCtrlResync() const
+{
+    struct wpa_ctrl *conn = wpa_ctrl_open(qPrintable(m_interfacePath));
+    if (conn) {
+        wpa_ctrl_close(ctrl_conn);
+        ctrl_conn = conn;
+        qCWarning(logWPA, "[FAIL] Reopened wpa_ctrl to drop pending replies.");
+        return;
+    }
+
+    int fd = wpa_ctrl_get_fd(ctrl_conn);
+    char c;
+    while (recv(fd, &c, 1, MSG_DONTWAIT) >= 0) {
+        // 数据报套接字，每次 recv 丢弃一个完整的回复
+    }
+}
+#endif
+
+QByteArray WiFiSupplicantToolPrivate::wpaCtrlRequestRaw(const QByteArray &command)
+const
 {
-    int ret;
-    const char *cmd = command.toLocal8Bit().constData();
-    char buf[2048], decode[2048];
-    size_t len;
     if (ctrl_conn == NULL) {
         qCCritical(logWPA, "[FAIL] Forbbiden to wpa_ctrl_request.\n%s",
-                   qUtf8Printable(command));
-        return QString();
+                   command.constData());
+        return QByteArray();
     }
 
-    len = sizeof(buf) - 1;
-    ret = wpa_ctrl_request(ctrl_conn, cmd, strlen(cmd), buf, &len, NULL);
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+    int fd = wpa_ctrl_get_fd(ctrl_conn);
+    QByteArray reply;
+    if (send(fd, command.constData(), command.size(), 0) < 0) {
+        qCCritical(logWPA, "[FAIL] Failed to wpa_ctrl_request.\n%s",
+                   command.constData());
+        return QByteArray();
+    }
+    if (!wpaCtrlWait(fd, command, &reply)) {
+        this->wpaCtrlResync();
+        return QByteArray();
+    }
+    return reply;
+#else
+    int ret;
+    char buf[4096];
+    size_t len = sizeof(buf) - 1;
+    ret = wpa_ctrl_request(ctrl_conn, command.constData(), command.size(),
+                           buf, &len, NULL);
 
     if (ret == -2) {
         qCCritical(logWPA, "[FAIL] Timeout to wpa_ctrl_request.\n%s",
-                   qUtf8Printable(command));
-        return QString();
+                   command.constData());
+        return QByteArray();
     } else if (ret < 0) {
         qCCritical(logWPA, "[FAIL] Failed to wpa_ctrl_request.\n%s",
-                   qUtf8Printable(command));
-        return QString();
-    } else {
-        buf[len] = '\0';
-        printf_decode((u8 *)decode, sizeof(decode), buf);
+                   command.constData());
+        return QByteArray();
+    }
+
+    buf[len] = '\0';
+    len = printf_decode((u8 *)buf, len + 1, buf);
+    m_replyBuffer = QByteArray(buf, int(len));
+    return m_replyBuffer;
+#endif
+}
+
+QString WiFiSupplicantToolPrivate::wpaCtrlRequest(const QString &command) const
+{
+    return QString::fromLocal8Bit(wpaCtrlRequestRaw(command.toLocal8Bit()));
+}
+
+QStringList WiFiSupplicantToolPrivate::wpaCtrlRequests(const QStringList &commands)
+const
+{
+    QStringList results;
+    if (ctrl_conn == NULL) {
+        qCCritical(logWPA, "[FAIL] Forbbiden to wpa_ctrl_request.\n%s",
+                   qUtf8Printable(commands.join(QLatin1Char('\n'))));
+        for (int i = 0; i < commands.length(); ++i) {
+            results << QString();
+        }
+        return results;
+    }
+
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+    /* 控制接口的回复严格按照请求顺序返回，分批写入请求后依次读取回复；
+     * 每批的数量受限于 socket 缓冲区，超过时分多批进行。
+     */
+    int fd = wpa_ctrl_get_fd(ctrl_conn);
+    QList<QByteArray> cmds;
+    for (const QString &command : commands) {
+        cmds << command.toLocal8Bit();
+    }
+    bool failed = false;
+    for (int first = 0; first < cmds.length(); first += WIFI_WPA_PIPELINE_DEPTH) {
+        int last = qMin(first + WIFI_WPA_PIPELINE_DEPTH, cmds.length());
+        int sent = first;
+        while (sent < last) {
+            const QByteArray &cmd = cmds.at(sent);
+            if (send(fd, cmd.constData(), cmd.size(), 0) < 0) {
+                qCCritical(logWPA, "[FAIL] Failed to wpa_ctrl_request.\n%s",
+                           cmd.constData());
+                failed = true;
+                break;
+            }
+            sent++;
+        }
+
+        for (int received = first; received < sent; ++received) {
+            QByteArray reply;
+            if (!wpaCtrlWait(fd, cmds.at(received), &reply)) {
+                failed = true;
+                break;
+            }
+            results << QString::fromLocal8Bit(reply);
+        }
+
+        if (failed) {
+            this->wpaCtrlResync();
+            break;
+        }
+    }
+
+    while (results.length() < commands.length()) {
+        results << QString();
+    }
+#else
+    for (const QString &command : commands) {
+        results << this->wpaCtrlRequest(command);
+    }
+#endif
+
+    return results;
+}
+
+/* 打开异步请求使用的控制连接，该连接不接收事件消息，
+ * 只用于流水线发送命令并在 QSocketNotifier 中读取回复。
+ */
+bool WiFiSupplicantToolPrivate::wpaAsyncOpen()
+{
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+    Q_Q(WiFiSupplicantTool);
+
+    if (async_conn) {
+        return true;
+    }
+
+    async_conn = wpa_ctrl_open(qPrintable(m_interfacePath));
+    if (async_conn == NULL) {
+        qCWarning(logWPA, "[FAIL] Failed to open asynchronous control connection.");
+        return false;
+    }
+
+    m_wpaAsync = new QSocketNotifier(wpa_ctrl_get_fd(async_conn),
+                                     QSocketNotifier::Read);
+    QObjectPrivate::connect(m_wpaAsync, &QSocketNotifier::activated, this,
+                            &WiFiSupplicantToolPrivate::wpaAsyncReply);
+
+    if (!m_asyncTimer) {
+        m_asyncTimer = new QTimer(q);
+        m_asyncTimer->setSingleShot(true);
+        m_asyncTimer->setInterval(WIFI_WPA_REQUEST_TIMEOUT);
+        m_asyncTimer->connect(m_asyncTimer, SIGNAL(timeout()), q,
+                              SLOT(_q_asyncTimeout()));
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* 关闭异步控制连接，所有已发送但未收到回复的请求以失败结束。
+ */
+void WiFiSupplicantToolPrivate::wpaAsyncClose()
+{
+    if (m_asyncTimer) {
+        m_asyncTimer->stop();
+    }
+
+    if (async_conn) {
+        m_wpaAsync->setEnabled(false);
+        m_wpaAsync->deleteLater();
+        m_wpaAsync = NULL;
+        wpa_ctrl_close(async_conn);
+        async_conn = NULL;
+    }
+
+    QQueue<WiFiSupplicantRequest> requests = m_asyncSent;
+    m_asyncSent.clear();
+    for (WiFiSupplicantRequest &request : requests) {
+        wpaAsyncFinish(request, QByteArray());
+    }
+}
+
+void WiFiSupplicantToolPrivate::wpaAsyncRequest(const QByteArray &command,
+        QObject *context, const WiFiSupplicantTool::RawCallback &callback)
+{
+    WiFiSupplicantRequest request;
+    request.command = command;
+    request.hasContext = context != NULL;
+    request.context = context;
+    request.callback = callback;
+
+    if (ctrl_conn == NULL || !wpaAsyncOpen()) {
+        qCCritical(logWPA, "[FAIL] Forbbiden to wpa_ctrl_request.\n%s",
+                   command.constData());
+        QTimer::singleShot(0, q_func(), [request]() mutable {
+            if (request.callback && (!request.hasContext || request.context)) {
+                request.callback(QByteArray());
+            }
+        });
+        return;
+    }
+
+    m_asyncQueued.enqueue(request);
+    this->wpaAsyncSend();
+}
+
+void WiFiSupplicantToolPrivate::wpaAsyncSend()
+{
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+    if (async_conn == NULL) {
+        return;
+    }
+
+    int fd = wpa_ctrl_get_fd(async_conn);
+    while (!m_asyncQueued.isEmpty() &&
+           m_asyncSent.length() < WIFI_WPA_PIPELINE_DEPTH) {
+        WiFiSupplicantRequest request = m_asyncQueued.dequeue();
+        if (request.hasContext && !request.context) {
+            continue;
+        }
+        if (send(fd, request.command.constData(), request.command.size(),
+                 MSG_DONTWAIT) < 0) {
+            qCCritical(logWPA, "[FAIL] Failed to wpa_ctrl_request.\n%s",
+                       request.command.constData());
+            wpaAsyncFinish(request, QByteArray());
+            continue;
+        }
+        m_asyncSent.enqueue(request);
+    }
+
+    if (!m_asyncSent.isEmpty() && !m_asyncTimer->isActive()) {
+        m_asyncTimer->start();
+    }
+#endif
+}
+
+void WiFiSupplicantToolPrivate::wpaAsyncReply()
+{
+#if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
+    QByteArray reply;
+    while (async_conn && wpaCtrlRecv(wpa_ctrl_get_fd(async_conn), MSG_DONTWAIT,
+                                     m_asyncBuffer, &reply)) {
+        if (reply.startsWith('<')) {
+            /* 非请求的事件消息，忽略 */
+            continue;
+        }
+        if (m_asyncSent.isEmpty()) {
+            /* 超时请求的迟到回复，忽略 */
+            continue;
+        }
+
+        WiFiSupplicantRequest request = m_asyncSent.dequeue();
+        m_asyncTimer->start();
+        wpaAsyncFinish(request, reply);
+    }
+
+    if (m_asyncSent.isEmpty() && m_asyncTimer) {
+        m_asyncTimer->stop();
+    }
+    this->wpaAsyncSend();
+#endif
+}
+
+void WiFiSupplicantToolPrivate::wpaAsyncFinish(WiFiSupplicantRequest &request,
+        const QByteArray &reply)
+{
+    if (request.callback && (!request.hasContext || request.context)) {
+        request.callback(reply);
+    }
+}
+
+void WiFiSupplicantToolPrivate::_q_asyncTimeout()
+{
+    if (m_asyncSent.isEmpty()) {
+        return;
     }
 
-    return QString::fromLocal8Bit(decode);
+    qCCritical(logWPA, "[FAIL] Timeout to wpa_ctrl_request.\n%s",
+               m_asyncSent.head().command.constData());
+
+    /* 重新打开连接以丢弃迟到的回复，未发送的请求在新连接上继续 */
+    this->wpaAsyncClose();
+    if (ctrl_conn && this->wpaAsyncOpen()) {
+        this->wpaAsyncSend();
+    }
 }
 
 WiFiSupplicantTool::WiFiSupplicantTool(QObject *parent)
@@ -331,6 +1039,23 @@ WiFiSupplicantTool *WiFiSupplicantTool::instance()
     return self;
 }
 
+void WiFiSupplicantTool::request(const QString &command, QObject *context,
+                                 const Callback &callback) const
+{
+    this->requestRaw(command.toLocal8Bit(), context,
+    [callback](const QByteArray & reply) {
+        callback(QString::fromLocal8Bit(reply));
+    });
+}
+
+void WiFiSupplicantTool::requestRaw(const QByteArray &command, QObject *context,
+                                    const RawCallback &callback) const
+{
+    Q_D(const WiFiSupplicantTool);
+    const_cast<WiFiSupplicantToolPrivate *>(d)->wpaAsyncRequest(command,
+            context, callback);
+}
+
 QString WiFiSupplicantTool::ping() const
 {
     Q_D(const WiFiSupplicantTool);
@@ -346,6 +1071,12 @@ QString WiFiSupplicantTool::status(bool verbose) const
     return d->wpaCtrlRequest(command);
 }
 
+void WiFiSupplicantTool::status(QObject *context,
+                                const RawCallback &callback) const
+{
+    this->requestRaw(QByteArrayLiteral("STATUS"), context, callback);
+}
+
 QString WiFiSupplicantTool::reassociate() const
 {
     Q_D(const WiFiSupplicantTool);
@@ -420,6 +1151,35 @@ QString WiFiSupplicantTool::bss(const QString &bssid) const
     return d->wpaCtrlRequest(command);
 }
 
+void WiFiSupplicantTool::bss(const QString &bssid, QObject *context,
+                             const RawCallback &callback) const
+{
+    this->requestRaw("BSS " + bssid.toLatin1(), context, callback);
+}
+
+static QByteArray bssRangeCommand(int first, int last)
+{
+    QByteArray command = "BSS RANGE=" + QByteArray::number(first) + '-';
+    if (last >= 0) {
+        command += QByteArray::number(last);
+    }
+    command += " MASK=0x" + QByteArray::number(WIFI_WPA_BSS_MASK, 16);
+    return command;
+}
+
+QString WiFiSupplicantTool::bss_range(int first, int last) const
+{
+    Q_D(const WiFiSupplicantTool);
+    return QString::fromLocal8Bit(d->wpaCtrlRequestRaw(bssRangeCommand(first,
+                                  last)));
+}
+
+void WiFiSupplicantTool::bss_range(int first, int last, QObject *context,
+                                   const RawCallback &callback) const
+{
+    this->requestRaw(bssRangeCommand(first, last), context, callback);
+}
+
 QString WiFiSupplicantTool::add_network() const
 {
     Q_D(const WiFiSupplicantTool);
@@ -478,6 +1238,31 @@ QString WiFiSupplicantTool::get_network(int id, const QString &variable) const
     return d->wpaCtrlRequest(command);
 }
 
+QList<QStringList> WiFiSupplicantTool::get_networks(const QList<int> &ids,
+        const QStringList &variables) const
+{
+    Q_D(const WiFiSupplicantTool);
+    QStringList commands;
+    for (int id : ids) {
+        for (const QString &variable : variables) {
+            commands << QStringLiteral("GET_NETWORK %1 %2").arg(id).arg(variable);
+        }
+    }
+
+    QStringList results = d->wpaCtrlRequests(commands);
+    QList<QStringList> networks;
+    for (int i = 0; i < ids.length(); ++i) {
+        QStringList values = results.mid(i * variables.length(), variables.length());
+        for (int j = 0; j < values.length(); ++j) {
+            if (values.at(j).startsWith(QStringLiteral("FAIL"))) {
+                values[j].clear();
+            }
+        }
+        networks << values;
+    }
+    return networks;
+}
+
 QString WiFiSupplicantTool::select_network(int id) const
 {
     Q_D(const WiFiSupplicantTool);
@@ -716,20 +1501,56 @@ QString WiFiSupplicantTool::p2p_reject() const
     return result;
 }
 
-void WiFiSupplicantTool::dhcpc_request()
+void WiFiSupplicantTool::dhcpc_request(const QString &bssid, const QString &ssid)
 {
     Q_D(WiFiSupplicantTool);
 
-    QProcess::execute(QString::fromLocal8Bit(WIFI_WPA_ACTION_DHCPC),
-                      QStringList() << d->m_interface << QStringLiteral("CONNECTED"));
+#if defined(CONFIG_CTRL_IFACE_UNIX)
+    if(WIFI_DHCPC == "native") {
+        if(!d->m_dhcpClient) {
+            d->m_dhcpClient = new WiFiDhcpClient(d->m_interface, this);
+            connect(d->m_dhcpClient, SIGNAL(leaseObtained(WiFiDhcpLease)),
+                    this, SIGNAL(dhcpcLeaseChanged()));
+            connect(d->m_dhcpClient, SIGNAL(leaseLost()),
+                    this, SIGNAL(dhcpcLeaseChanged()));
+            connect(d->m_dhcpClient, SIGNAL(failed()),
+                    this, SLOT(_q_dhcpcFailed()));
+        }
+        if(d->m_dhcpcRestartTimer) {
+            d->m_dhcpcRestartTimer->stop();
+        }
+        d->m_dhcpcAttempts = 0;
+        d->m_dhcpcBssid = bssid;
+        d->m_dhcpcSsid = ssid;
+        d->m_dhcpClient->start(bssid, ssid);
+        return;
+    }
+#else
+    Q_UNUSED(bssid)
+    Q_UNUSED(ssid)
+#endif
+
+    d->runDhcpcAction(QStringLiteral("CONNECTED"));
 }
 
 void WiFiSupplicantTool::dhcpc_release()
 {
     Q_D(WiFiSupplicantTool);
 
-    QProcess::execute(QString::fromLocal8Bit(WIFI_WPA_ACTION_DHCPC),
-                      QStringList() << d->m_interface << QStringLiteral("DISCONNECTED"));
+#if defined(CONFIG_CTRL_IFACE_UNIX)
+    if(WIFI_DHCPC == "native") {
+        if(d->m_dhcpcRestartTimer) {
+            d->m_dhcpcRestartTimer->stop();
+        }
+        // 已经停止的客户端 stop() 不做任何事
+        if(d->m_dhcpClient) {
+            d->m_dhcpClient->stop();
+        }
+        return;
+    }
+#endif
+
+    d->runDhcpcAction(QStringLiteral("DISCONNECTED"));
 }
 
 bool WiFiSupplicantTool::isRunning() const
@@ -738,6 +1559,15 @@ bool WiFiSupplicantTool::isRunning() const
     return d->ctrl_conn != NULL;
 }
 
+void WiFiSupplicantTool::cancelRestart()
+{
+    Q_D(WiFiSupplicantTool);
+    if(d->m_restartTimer && d->m_restartTimer->isActive()) {
+        qCInfo(logWPA, "[ OK ] Cancel pending wpa_supplicant restart.");
+        d->m_restartTimer->stop();
+    }
+}
+
 void WiFiSupplicantTool::start()
 {
     Q_D(WiFiSupplicantTool);
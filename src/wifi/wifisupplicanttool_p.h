@@ -23,8 +23,14 @@
 
 #include <private/qobject_p.h>
 #include <QtCore/qtimer.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfilesystemwatcher.h>
 #include <QtCore/qprocess.h>
 #include <QtCore/qsocketnotifier.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qqueue.h>
+
+#include <functional>
 
 // in a header
 Q_DECLARE_LOGGING_CATEGORY(logWPA)
@@ -33,12 +39,30 @@ Q_DECLARE_LOGGING_CATEGORY(logWPASupp)
 QT_BEGIN_NAMESPACE
 
 class WiFiSupplicantToolPrivate;
+class WiFiDhcpClient;
+class WiFiActionRunner;
 class WiFiSupplicantTool : public QObject
 {
     Q_OBJECT
 public:
+    /* 异步请求完成后的回调，请求失败或超时时 reply 为空。
+     */
+    typedef std::function<void(const QString &reply)> Callback;
+    /* 同 Callback ，reply 为指向内部接收缓冲区的切片，仅在回调期间有效。
+     */
+    typedef std::function<void(const QByteArray &reply)> RawCallback;
+
     static WiFiSupplicantTool *instance();
 
+    /* 异步发送控制接口命令，不阻塞调用线程。
+     * 请求按顺序写入独立的控制连接，可同时有多个请求等待回复，回复到达后
+     * 按发送顺序调用 callback 。context 被销毁后不再调用其 callback 。
+     */
+    void request(const QString &command, QObject *context,
+                 const Callback &callback) const;
+    void requestRaw(const QByteArray &command, QObject *context,
+                    const RawCallback &callback) const;
+
     /* PING: 此命令可用于测试 wpa_supplicant 是否响应控制接口命令。
      * 如果连接打开且 wpa_supplicant 正在处理命令，则预期的响应是: PONG 。
      */
@@ -80,6 +104,7 @@ public:
      *    ClientTimeout=60
      */
     QString status(bool verbose = false) const;
+    void status(QObject *context, const RawCallback &callback) const;
 
     /* REASSOCIATE: 强制重新关联。
      */
@@ -139,6 +164,18 @@ public:
     /* BSS: 命令 "BSS <BSSID>" 获得详细的每个 BSS 扫描结果。
      */
     QString bss(const QString &bssid) const;
+    void bss(const QString &bssid, QObject *context,
+             const RawCallback &callback) const;
+
+    /* BSS RANGE: 命令 "BSS RANGE=<first>-<last> MASK=<mask>" 批量获取 id 在
+     * [first, last] 内的 BSS ，last 小于 0 时获取 first 之后的全部 BSS 。
+     * MASK 只包含 id 、bssid 、freq 、level 、flags 、ssid 及分隔符，
+     * 每个 BSS 之间以 "====" 分隔，BSS 表中的最后一个 BSS 之后为 "####" 。
+     * 回复长度受控制接口缓冲区限制，可能只包含部分 BSS ，需要从最后一个 id 之后继续获取。
+     */
+    QString bss_range(int first, int last = -1) const;
+    void bss_range(int first, int last, QObject *context,
+                   const RawCallback &callback) const;
 
     /* ADD_NETWORK: 添加一个新的网络。此命令创建一个新网络，其配置为空。
      * 新网络被禁用，一旦配置好，就可以使用 ENABLE_NETWORK 命令启用它。
@@ -166,6 +203,14 @@ public:
      */
     QString get_network(int id, const QString &variable) const;
 
+    /* GET_NETWORK(批量): 一次性获取多个网络的多个变量。
+     * 所有 GET_NETWORK 命令以流水线方式写入控制接口后再依次读取回复，
+     * 避免逐条请求的往返等待。返回值按 ids 的顺序排列，每一项按 variables
+     * 的顺序保存对应的值，获取失败或变量未设置(FAIL)时为空字符串。
+     */
+    QList<QStringList> get_networks(const QList<int> &ids,
+                                    const QStringList &variables) const;
+
     /* SELECT_NETWORK: 选择一个网络(禁用其他网络)。可以从 LIST_NETWORKS 命令输出中接收网络id。
      */
     QString select_network(int id) const;
@@ -258,11 +303,19 @@ public:
      */
     QString p2p_reject() const;
 
-    void dhcpc_request();
+    /* 为 bssid/ssid 标识的网络获取 IP 地址，WIFI_DHCPC=native(默认)时使用进程内的
+     * WiFiDhcpClient ，同一网络重新连接时先请求缓存的租约；WIFI_DHCPC=script 时
+     * 按事件顺序排队执行 WIFI_WPA_ACTION_DHCPC 脚本。二者均不阻塞事件循环。
+     * WiFiDhcpClient 超时失败后按退避间隔重新获取，直到 dhcpc_release() 。
+     */
+    void dhcpc_request(const QString &bssid = QString(), const QString &ssid = QString());
+    /* 链路断开，移除接口地址，缓存的租约保留到下次连接。 */
     void dhcpc_release();
 
 public:
     bool isRunning() const;
+    /* 取消 supplicantRestarting 之后等待中的重新启动，之后需要调用 start() 重新启动 */
+    void cancelRestart();
 
 public slots:
     void start();
@@ -271,6 +324,16 @@ public slots:
 signals:
     void supplicantStarted();
     void supplicantFinished();
+    /* wpa_supplicant 意外退出，连接已关闭，将按退避间隔重新启动，
+     * 恢复后再次发出 supplicantStarted 。只有调用 stop() 才会发出 supplicantFinished 。
+     */
+    void supplicantRestarting();
+    /* WiFiDhcpClient 获得或失去租约，接口地址已经改变 */
+    void dhcpcLeaseChanged();
+    /* P2P 组事件的 WIFI_WPA_ACTION_DHCPD 脚本执行结束，group 为组接口，
+     * message 为触发脚本的事件，ok 为 false 表示脚本失败、超时或无法启动。
+     */
+    void actionFinished(const QString &group, const QString &message, bool ok);
     void messageReceived(const QString &msg);
 
 private:
@@ -285,6 +348,19 @@ private:
     Q_PRIVATE_SLOT(d_func(), void _q_stopSupplicantDone(int, QProcess::ExitStatus))
     Q_PRIVATE_SLOT(d_func(), void _q_supplicantCrashed(QProcess::ProcessError))
     Q_PRIVATE_SLOT(d_func(), void _q_tryOpenTimeout())
+    Q_PRIVATE_SLOT(d_func(), void _q_interfaceDirChanged(const QString &))
+    Q_PRIVATE_SLOT(d_func(), void _q_restartTimeout())
+    Q_PRIVATE_SLOT(d_func(), void _q_asyncTimeout())
+    Q_PRIVATE_SLOT(d_func(), void _q_dhcpcFailed())
+    Q_PRIVATE_SLOT(d_func(), void _q_dhcpcRestartTimeout())
+};
+
+struct WiFiSupplicantRequest
+{
+    QByteArray command;
+    bool hasContext = false;
+    QPointer<QObject> context;
+    WiFiSupplicantTool::RawCallback callback;
 };
 
 class WiFiSupplicantToolPrivate : public QObjectPrivate
@@ -302,24 +378,80 @@ public:
     void _q_stopSupplicantDone(int exitCode, QProcess::ExitStatus exitStatus);
     void _q_supplicantCrashed(QProcess::ProcessError error);
     void _q_tryOpenTimeout();
-
-    void wpaProcessMsg(char *msg);
+    void _q_interfaceDirChanged(const QString &path);
+    void _q_restartTimeout();
+    void _q_asyncTimeout();
+    void _q_dhcpcFailed();
+    void _q_dhcpcRestartTimeout();
+
+    bool attachSupplicant();
+    void startTryOpen();
+    void tryOpenSupplicant();
+    void watchInterfaceDir();
+    void stopTryOpen();
+    quint64 interfaceSocketId() const;
+    void scheduleRestart();
+    void runAction(const QString &group, const QString &message);
+    void runDhcpcAction(const QString &event);
+
+    void wpaProcessMsg(const char *msg);
     void wpaMonitorMsg();
 
     bool wpaOpenConnection();
     bool wpaCloseConnection();
+    bool wpaCtrlRecv(int fd, int flags, QByteArray &buffer, QByteArray *reply,
+                     bool decode = true) const;
+    bool wpaCtrlWait(int fd, const QByteArray &command, QByteArray *reply) const;
+    void wpaCtrlResync() const;
+    QByteArray wpaCtrlRequestRaw(const QByteArray &command) const;
     QString wpaCtrlRequest(const QString &command) const;
-
+    QStringList wpaCtrlRequests(const QStringList &commands) const;
+
+    bool wpaAsyncOpen();
+    void wpaAsyncClose();
+    void wpaAsyncRequest(const QByteArray &command, QObject *context,
+                         const WiFiSupplicantTool::RawCallback &callback);
+    void wpaAsyncSend();
+    void wpaAsyncReply();
+    void wpaAsyncFinish(WiFiSupplicantRequest &request, const QByteArray &reply);
+
+    /* 控制接口就绪检测：监视 WIFI_WPA_INTERFACE_DIR ，套接字出现即打开；
+     * m_tryOpenTimer 只作为兜底的低频重试和超时判断。
+     */
+    QFileSystemWatcher *m_interfaceWatcher = NULL;
     QTimer *m_tryOpenTimer = NULL;
-    int m_tryOpenTimes = 0;
+    quint64 m_terminatedSocket = 0; // TERMINATING 时的套接字 inode ，非 0 时等待其被替换
+    QElapsedTimer m_startTime;
+    bool m_attached = false; // 连接的是已在运行、不由本进程启动的 wpa_supplicant
+    bool m_stopping = false; // 由 stop() 结束，不再重新启动
+    QTimer *m_restartTimer = NULL;
+    int m_restartAttempts = 0;
     QProcess *m_wpaProcess = NULL;
     QSocketNotifier *m_wpaMonitor = NULL;
+    QSocketNotifier *m_wpaAsync = NULL;
+    QTimer *m_asyncTimer = NULL;
+    WiFiDhcpClient *m_dhcpClient = NULL;
+    QTimer *m_dhcpcRestartTimer = NULL;
+    int m_dhcpcAttempts = 0;
+    QString m_dhcpcBssid;
+    QString m_dhcpcSsid;
+    WiFiActionRunner *m_actionRunner = NULL;
+    WiFiActionRunner *m_dhcpcRunner = NULL;
+    QString m_dhcpcEvent; // 最后排队的 WIFI_WPA_ACTION_DHCPC 事件
+    QQueue<WiFiSupplicantRequest> m_asyncSent;   // 已发送，等待回复
+    QQueue<WiFiSupplicantRequest> m_asyncQueued; // 等待发送
 
     QString m_interface;
     QString m_interfacePath;
 
-    struct wpa_ctrl *ctrl_conn = NULL;
+    /* 可复用的接收缓冲区，按需增长，分别用于同步请求、异步请求和事件消息 */
+    mutable QByteArray m_replyBuffer;
+    QByteArray m_asyncBuffer;
+    QByteArray m_eventBuffer;
+
+    mutable struct wpa_ctrl *ctrl_conn = NULL; // 请求失败后在 wpaCtrlResync() 中重新打开
     struct wpa_ctrl *monitor_conn = NULL;
+    struct wpa_ctrl *async_conn = NULL;
 };
 
 QT_END_NAMESPACE
@@ -1,5 +1,9 @@
 TEMPLATE = subdirs
 
 SUBDIRS += \
-    wifimacaddress
-
+    wifimacaddress \
+    wifidbus \
+    wifisupplicantparser \
+    wifidhcpclient \
+    wifiactionrunner \
+    wifisortfiltermodel
@@ -0,0 +1,150 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include <QtTest/QtTest>
+
+// add necessary includes here
+#include <WiFi/private/wifiactionrunner_p.h>
+
+static QStringList shell(const QString &script)
+{
+    return QStringList() << QString("-c") << script;
+}
+
+class WiFiActionRunnerUnit : public QObject
+{
+    Q_OBJECT
+
+public:
+    WiFiActionRunnerUnit();
+    ~WiFiActionRunnerUnit();
+
+private slots:
+    void initTestCase();
+
+    void test_order();
+    void test_parallel();
+    void test_result();
+    void test_timeout();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+WiFiActionRunnerUnit::WiFiActionRunnerUnit()
+{
+
+}
+
+WiFiActionRunnerUnit::~WiFiActionRunnerUnit()
+{
+
+}
+
+void WiFiActionRunnerUnit::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    qRegisterMetaType<WiFiActionRunner::Result>();
+}
+
+/* 同一接口的动作按提交顺序执行，前一个较慢也不会被后一个超过 */
+void WiFiActionRunnerUnit::test_order()
+{
+    const QString log = m_dir.filePath(QString("order.log"));
+    WiFiActionRunner runner;
+    QSignalSpy finished(&runner, SIGNAL(actionFinished(int, QString, QStringList,
+                                                       WiFiActionRunner::Result, int)));
+
+    QElapsedTimer timer;
+    timer.start();
+    int first = runner.enqueue(QString("p2p-wlan0-0"), QString("sh"),
+                               shell(QString("sleep 0.3; echo started >> %1").arg(log)));
+    int second = runner.enqueue(QString("p2p-wlan0-0"), QString("sh"),
+                                shell(QString("echo removed >> %1").arg(log)));
+    // 提交不等待脚本执行
+    QVERIFY(timer.elapsed() < 200);
+    QCOMPARE(runner.pendingCount(QString("p2p-wlan0-0")), 2);
+
+    QTRY_COMPARE(finished.count(), 2);
+    QCOMPARE(finished.at(0).at(0).toInt(), first);
+    QCOMPARE(finished.at(1).at(0).toInt(), second);
+    QCOMPARE(runner.pendingCount(), 0);
+
+    QFile file(log);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArray("started\nremoved\n"));
+}
+
+/* 不同接口的动作互不等待 */
+void WiFiActionRunnerUnit::test_parallel()
+{
+    WiFiActionRunner runner;
+    QSignalSpy finished(&runner, SIGNAL(actionFinished(int, QString, QStringList,
+                                                       WiFiActionRunner::Result, int)));
+
+    runner.enqueue(QString("p2p-wlan0-0"), QString("sh"), shell(QString("sleep 2")));
+    int fast = runner.enqueue(QString("p2p-wlan0-1"), QString("sh"), shell(QString("true")));
+    QCOMPARE(runner.pendingCount(), 2);
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 1500);
+    QCOMPARE(finished.at(0).at(0).toInt(), fast);
+    QCOMPARE(finished.at(0).at(1).toString(), QString("p2p-wlan0-1"));
+    QCOMPARE(runner.pendingCount(QString("p2p-wlan0-0")), 1);
+}
+
+void WiFiActionRunnerUnit::test_result()
+{
+    WiFiActionRunner runner;
+    QSignalSpy finished(&runner, SIGNAL(actionFinished(int, QString, QStringList,
+                                                       WiFiActionRunner::Result, int)));
+
+    const QStringList arguments = shell(QString("exit 0"));
+    runner.enqueue(QString("wlan0"), QString("sh"), arguments);
+    runner.enqueue(QString("wlan0"), QString("sh"), shell(QString("exit 3")));
+    runner.enqueue(QString("wlan0"), m_dir.filePath(QString("missing.sh")), QStringList());
+    // 启动失败不影响后续动作
+    runner.enqueue(QString("wlan0"), QString("sh"), shell(QString("exit 0")));
+
+    QTRY_COMPARE(finished.count(), 4);
+    QCOMPARE(finished.at(0).at(2).toStringList(), arguments);
+    QCOMPARE(finished.at(0).at(3).value<WiFiActionRunner::Result>(), WiFiActionRunner::Success);
+    QCOMPARE(finished.at(1).at(3).value<WiFiActionRunner::Result>(), WiFiActionRunner::Failed);
+    QCOMPARE(finished.at(1).at(4).toInt(), 3);
+    QCOMPARE(finished.at(2).at(3).value<WiFiActionRunner::Result>(),
+             WiFiActionRunner::FailedToStart);
+    QCOMPARE(finished.at(3).at(3).value<WiFiActionRunner::Result>(), WiFiActionRunner::Success);
+}
+
+void WiFiActionRunnerUnit::test_timeout()
+{
+    WiFiActionRunner runner;
+    runner.setTimeout(200);
+    QSignalSpy finished(&runner, SIGNAL(actionFinished(int, QString, QStringList,
+                                                       WiFiActionRunner::Result, int)));
+
+    runner.enqueue(QString("wlan0"), QString("sh"), shell(QString("sleep 10")));
+    runner.enqueue(QString("wlan0"), QString("sh"), shell(QString("true")));
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 2, 3000);
+    QCOMPARE(finished.at(0).at(3).value<WiFiActionRunner::Result>(), WiFiActionRunner::TimedOut);
+    QCOMPARE(finished.at(1).at(3).value<WiFiActionRunner::Result>(), WiFiActionRunner::Success);
+}
+
+QTEST_GUILESS_MAIN(WiFiActionRunnerUnit)
+
+#include "tst_wifiactionrunnerunit.moc"
@@ -0,0 +1,281 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include <QtTest/QtTest>
+#include <QtDBus/QtDBus>
+
+// add necessary includes here
+#include <WiFi/wifimacaddress.h>
+#include <WiFi/private/wifidbus_p.h>
+
+static const int SCAN_RESULT_COUNT = 200;
+
+static WiFiScanResultList createScanResults()
+{
+    WiFiScanResultList results;
+    for (int i = 0; i < SCAN_RESULT_COUNT; ++i) {
+        WiFiScanResult result(WiFiMacAddress(Q_UINT64_C(0x0c4b547a0000) + i),
+                              QString("AccessPoint-%1").arg(i));
+        result.setRssi(-40 - i % 50);
+        result.setFrequency(i % 2 ? 5180 : 2412);
+        result.setFlags(QString("[WPA2-PSK-CCMP][ESS]"));
+        result.setTimestamp(Q_INT64_C(1571299200000000) + i);
+        result.setNetworkId(i % 10 ? -1 : i / 10);
+        results.append(result);
+    }
+    return results;
+}
+
+static WiFiInfo createInfo()
+{
+    WiFiInfo info;
+    info.setMacAddress(WiFiMacAddress(QString("38:d2:69:c3:f8:3b")));
+    info.setBSSID(WiFiMacAddress(QString("a4:50:46:78:0c:f6")));
+    info.setSSID(QString("ZZS"));
+    info.setRssi(-52);
+    info.setFrequency(2472);
+    info.setIpAddress(QString("192.168.1.21"));
+    info.setNetworkId(0);
+    info.setRxLinkSpeed(72);
+    info.setTxLinkSpeed(65);
+    return info;
+}
+
+static WiFiNetwork createNetwork()
+{
+    WiFiNetwork network(3, QString("ZZS"));
+    network.setBSSID(WiFiMacAddress(QString("a4:50:46:78:0c:f6")));
+    network.setAuthFlags(WiFi::WPA2_PSK);
+    network.setEncrFlags(WiFi::CCMP);
+    network.setPreSharedKey(QString("12345678"));
+    return network;
+}
+
+/* 逐字段比较，operator== 只比较 BSSID */
+static bool sameScanResults(const WiFiScanResultList &a, const WiFiScanResultList &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].bssid() != b[i].bssid() || a[i].ssid() != b[i].ssid() ||
+            a[i].rssi() != b[i].rssi() || a[i].frequency() != b[i].frequency() ||
+            a[i].flags() != b[i].flags() || a[i].timestamp() != b[i].timestamp() ||
+            a[i].networkId() != b[i].networkId()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class WiFiDBusUnit : public QObject
+{
+    Q_OBJECT
+
+public:
+    WiFiDBusUnit();
+    ~WiFiDBusUnit();
+
+public slots:
+    void onNewConnection(const QDBusConnection &connection);
+    void onMessage(const QDBusMessage &message);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void test_signature();
+    void test_roundtrip();
+
+    void benchmark_encode_data();
+    void benchmark_encode();
+
+    void benchmark_roundtrip_data();
+    void benchmark_roundtrip();
+
+private:
+    QVariant roundtrip(const QVariant &value);
+
+    QDBusServer *m_server = NULL;
+    QList<QDBusConnection> m_peers;
+    QDBusConnection m_client;
+    QDBusMessage m_received;
+    QTimer m_timeout;
+};
+
+WiFiDBusUnit::WiFiDBusUnit() : m_client(QString("wifidbus"))
+{
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(5000);
+}
+
+WiFiDBusUnit::~WiFiDBusUnit()
+{
+
+}
+
+void WiFiDBusUnit::onNewConnection(const QDBusConnection &connection)
+{
+    QDBusConnection peer(connection);
+    peer.connect(QString(), QString("/"), QString("wifi.test"), QString("Message"),
+                 this, SLOT(onMessage(QDBusMessage)));
+    m_peers.append(peer);
+}
+
+void WiFiDBusUnit::onMessage(const QDBusMessage &message)
+{
+    m_received = message;
+}
+
+void WiFiDBusUnit::initTestCase()
+{
+    WiFiDBus::registerMetaTypes();
+
+    m_server = new QDBusServer(this);
+    if (!m_server->isConnected()) {
+        QSKIP("Unable to listen on a peer-to-peer D-Bus address.");
+    }
+    connect(m_server, &QDBusServer::newConnection,
+            this, &WiFiDBusUnit::onNewConnection);
+
+    m_client = QDBusConnection::connectToPeer(m_server->address(), m_client.name());
+    QVERIFY2(m_client.isConnected(), qPrintable(m_client.lastError().message()));
+    QTRY_COMPARE(m_peers.size(), 1);
+}
+
+void WiFiDBusUnit::cleanupTestCase()
+{
+    QDBusConnection::disconnectFromPeer(m_client.name());
+}
+
+/* 经过真实的 D-Bus 编组与解组后返回收到的第一个参数 */
+QVariant WiFiDBusUnit::roundtrip(const QVariant &value)
+{
+    QDBusMessage message = QDBusMessage::createSignal(QString("/"),
+                                                      QString("wifi.test"),
+                                                      QString("Message"));
+    message << value;
+    m_received = QDBusMessage();
+    if (!m_client.send(message)) {
+        return QVariant();
+    }
+
+    m_timeout.start();
+    while (m_received.type() == QDBusMessage::InvalidMessage && m_timeout.isActive()) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    m_timeout.stop();
+
+    const QList<QVariant> arguments = m_received.arguments();
+    return arguments.isEmpty() ? QVariant() : arguments.first();
+}
+
+void WiFiDBusUnit::test_signature()
+{
+    QCOMPARE(QByteArray(QDBusMetaType::typeToSignature(qMetaTypeId<WiFiScanResult>())),
+             QByteArray("(tsnisxi)"));
+    QCOMPARE(QByteArray(QDBusMetaType::typeToSignature(qMetaTypeId<WiFiScanResultList>())),
+             QByteArray("a(tsnisxi)"));
+    QCOMPARE(QByteArray(QDBusMetaType::typeToSignature(qMetaTypeId<WiFiInfo>())),
+             QByteArray("(ttsnisiii)"));
+    QCOMPARE(QByteArray(QDBusMetaType::typeToSignature(qMetaTypeId<WiFiNetwork>())),
+             QByteArray("(istiis)"));
+    QCOMPARE(QByteArray(QDBusMetaType::typeToSignature(qMetaTypeId<WiFiNetworkList>())),
+             QByteArray("a(istiis)"));
+}
+
+void WiFiDBusUnit::test_roundtrip()
+{
+    const WiFiScanResultList results = createScanResults();
+    const QVariant resultsArg = roundtrip(QVariant::fromValue(results));
+    QVERIFY(resultsArg.isValid());
+    QVERIFY(sameScanResults(qdbus_cast<WiFiScanResultList>(resultsArg), results));
+
+    const WiFiScanResult empty;
+    const WiFiScanResult emptyBack = qdbus_cast<WiFiScanResult>(roundtrip(
+                                         QVariant::fromValue(empty)));
+    QVERIFY(!emptyBack.isValid());
+
+    const WiFiInfo info = createInfo();
+    QCOMPARE(qdbus_cast<WiFiInfo>(roundtrip(QVariant::fromValue(info))), info);
+
+    const WiFiNetwork network = createNetwork();
+    const WiFiNetwork networkBack = qdbus_cast<WiFiNetwork>(roundtrip(
+                                        QVariant::fromValue(network)));
+    QCOMPARE(networkBack.networkId(), network.networkId());
+    QCOMPARE(networkBack.ssid(), network.ssid());
+    QCOMPARE(networkBack.bssid(), network.bssid());
+    QCOMPARE(networkBack.authFlags(), network.authFlags());
+    QCOMPARE(networkBack.encrFlags(), network.encrFlags());
+    QCOMPARE(networkBack.preSharedKey(), network.preSharedKey());
+}
+
+void WiFiDBusUnit::benchmark_encode_data()
+{
+    QTest::addColumn<bool>("json");
+
+    QTest::newRow("json") << true;
+    QTest::newRow("dbus") << false;
+}
+
+void WiFiDBusUnit::benchmark_encode()
+{
+    QFETCH(bool, json);
+    const WiFiScanResultList results = createScanResults();
+
+    if (json) {
+        QBENCHMARK {
+            const QString encoded = QString::fromUtf8(results.toJson());
+            Q_UNUSED(encoded);
+        }
+    } else {
+        QBENCHMARK {
+            QDBusArgument argument;
+            argument << results;
+        }
+    }
+}
+
+void WiFiDBusUnit::benchmark_roundtrip_data()
+{
+    benchmark_encode_data();
+}
+
+void WiFiDBusUnit::benchmark_roundtrip()
+{
+    QFETCH(bool, json);
+    const WiFiScanResultList results = createScanResults();
+    WiFiScanResultList received;
+
+    if (json) {
+        QBENCHMARK {
+            const QVariant arg = roundtrip(QString::fromUtf8(results.toJson()));
+            received = WiFiScanResultList::fromJson(arg.toString().toUtf8());
+        }
+    } else {
+        QBENCHMARK {
+            const QVariant arg = roundtrip(QVariant::fromValue(results));
+            received = qdbus_cast<WiFiScanResultList>(arg);
+        }
+    }
+    QVERIFY(sameScanResults(received, results));
+}
+
+QTEST_GUILESS_MAIN(WiFiDBusUnit)
+
+#include "tst_wifidbusunit.moc"
@@ -0,0 +1,351 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include <QtTest/QtTest>
+#include <QtCore/QJsonDocument>
+
+// add necessary includes here
+#include <WiFi/private/wifidhcpclient_p.h>
+
+extern "C"
+{
+#include "utils/common.h"
+#include "common/dhcp.h"
+}
+
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+static const char CLIENT_IFNAME[] = "wdc0";
+static const char SERVER_IFNAME[] = "wds0";
+static const quint32 SERVER_ADDRESS = 0x0a4d0001; // 10.77.0.1
+static const quint32 CLIENT_ADDRESS = 0x0a4d0032; // 10.77.0.50
+static const quint32 CLIENT_NETMASK = 0xffffff00;
+static const quint32 LEASE_TIME = 3600;
+static const QString BSSID = QString("0c:4b:54:7a:21:21");
+static const QString SSID = QString("hsaeyz");
+
+static bool run(const QString &command)
+{
+    return QProcess::execute(QString("sh"), QStringList() << QString("-c") << command) == 0;
+}
+
+static quint32 interfaceAddress(const char *ifname)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    quint32 address = 0;
+    if (::ioctl(fd, SIOCGIFADDR, &ifr) == 0) {
+        address = ntohl(reinterpret_cast<struct sockaddr_in *>(&ifr.ifr_addr)->sin_addr.s_addr);
+    }
+    ::close(fd);
+    return address;
+}
+
+/*
+ * 网络命名空间中 veth 对端的最小 DHCP 服务器，只分配 CLIENT_ADDRESS ，
+ * 记录收到的报文类型，nakNext 置位时拒绝下一个 REQUEST 。
+ */
+class DhcpServer : public QObject
+{
+    Q_OBJECT
+public:
+    bool open();
+
+    QList<int> received;
+    bool nakNext = false;
+
+private slots:
+    void onReadyRead();
+
+private:
+    void reply(const QByteArray &request, quint8 type);
+
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = NULL;
+};
+
+bool DhcpServer::open()
+{
+    m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int on = 1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(DHCP_SERVER_PORT);
+    if (m_fd < 0 ||
+        ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+        ::setsockopt(m_fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on)) < 0 ||
+        ::setsockopt(m_fd, SOL_SOCKET, SO_BINDTODEVICE, SERVER_IFNAME,
+                     sizeof(SERVER_IFNAME)) < 0 ||
+        ::bind(m_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+        return false;
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DhcpServer::onReadyRead);
+    return true;
+}
+
+void DhcpServer::onReadyRead()
+{
+    QByteArray buffer(1500, Qt::Uninitialized);
+    ssize_t length;
+    while ((length = ::recv(m_fd, buffer.data(), buffer.size(), 0)) > 0) {
+        const QByteArray packet = buffer.left(int(length));
+        const int offset = int(sizeof(struct dhcp_data)) + 4;
+        const struct dhcp_data *data =
+            reinterpret_cast<const struct dhcp_data *>(packet.constData());
+        if (packet.size() <= offset || data->op != 1) {
+            continue;
+        }
+
+        int type = 0;
+        quint32 requested = ntohl(data->client_ip);
+        const uchar *bytes = reinterpret_cast<const uchar *>(packet.constData());
+        for (int pos = offset; pos + 1 < packet.size() && bytes[pos] != DHCP_OPT_END;) {
+            const int code = bytes[pos];
+            if (code == DHCP_OPT_PAD) {
+                pos++;
+                continue;
+            }
+            const int size = bytes[pos + 1];
+            if (code == DHCP_OPT_MSG_TYPE) {
+                type = bytes[pos + 2];
+            } else if (code == DHCP_OPT_REQUESTED_IP_ADDRESS && size == 4) {
+                requested = qFromBigEndian<quint32>(bytes + pos + 2);
+            }
+            pos += size + 2;
+        }
+        received << type;
+
+        if (type == DHCPDISCOVER) {
+            reply(packet, DHCPOFFER);
+        } else if (type == DHCPREQUEST) {
+            bool ack = requested == CLIENT_ADDRESS && !nakNext;
+            nakNext = false;
+            reply(packet, ack ? DHCPACK : DHCPNAK);
+        }
+    }
+}
+
+void DhcpServer::reply(const QByteArray &request, quint8 type)
+{
+    QByteArray packet = request.left(int(sizeof(struct dhcp_data)));
+    struct dhcp_data *data = reinterpret_cast<struct dhcp_data *>(packet.data());
+    data->op = 2;
+    data->your_ip = type == DHCPNAK ? 0 : htonl(CLIENT_ADDRESS);
+
+    uchar magic[4];
+    qToBigEndian<quint32>(DHCP_MAGIC, magic);
+    packet.append(reinterpret_cast<const char *>(magic), 4);
+
+    auto option = [&packet](quint8 code, quint32 value, int size) {
+        uchar bytes[4];
+        qToBigEndian<quint32>(value, bytes);
+        packet.append(char(code));
+        packet.append(char(size));
+        packet.append(reinterpret_cast<const char *>(bytes) + 4 - size, size);
+    };
+    option(DHCP_OPT_MSG_TYPE, type, 1);
+    option(DHCP_OPT_SERVER_ID, SERVER_ADDRESS, 4);
+    if (type != DHCPNAK) {
+        option(DHCP_OPT_IP_ADDRESS_LEASE_TIME, LEASE_TIME, 4);
+        option(DHCP_OPT_SUBNET_MASK, CLIENT_NETMASK, 4);
+        option(DHCP_OPT_ROUTER, SERVER_ADDRESS, 4);
+        option(DHCP_OPT_DOMAIN_NAME_SERVER, SERVER_ADDRESS, 4);
+    }
+    packet.append(char(DHCP_OPT_END));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(DHCP_CLIENT_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+    ::sendto(m_fd, packet.constData(), packet.size(), 0,
+             reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+}
+
+class WiFiDhcpClientUnit : public QObject
+{
+    Q_OBJECT
+
+public:
+    WiFiDhcpClientUnit();
+    ~WiFiDhcpClientUnit();
+
+private slots:
+    void initTestCase();
+    void init();
+
+    void test_discover();
+    void test_reboot();
+    void test_nak();
+
+private:
+    void seedLease();
+
+    QTemporaryDir m_dir;
+    DhcpServer m_server;
+};
+
+WiFiDhcpClientUnit::WiFiDhcpClientUnit()
+{
+
+}
+
+WiFiDhcpClientUnit::~WiFiDhcpClientUnit()
+{
+
+}
+
+/* 在独立的网络命名空间中创建 veth 对，客户端使用 wdc0 ，服务器使用 wds0 。
+ * 需要 root 权限，否则跳过。
+ */
+void WiFiDhcpClientUnit::initTestCase()
+{
+    if (::geteuid() != 0 || ::unshare(CLONE_NEWNET) != 0) {
+        QSKIP("Requires root to create a network namespace.");
+    }
+    if (!run(QString("ip link set lo up && "
+                     "ip link add wdc0 type veth peer name wds0 && "
+                     "ip link set wdc0 up && ip link set wds0 up && "
+                     "ip addr add 10.77.0.1/24 dev wds0"))) {
+        QSKIP("Unable to create the veth pair.");
+    }
+    QVERIFY(m_dir.isValid());
+    QVERIFY(m_server.open());
+
+    qputenv("WIFI_DHCPC_LEASES", m_dir.filePath(QString("dhcpc.leases")).toLocal8Bit());
+    qputenv("WIFI_DHCPC_RESOLV_CONF", m_dir.filePath(QString("resolv.conf")).toLocal8Bit());
+    qputenv("WIFI_DHCPC_RETRY", "200");
+}
+
+/* 每个测试都从没有缓存租约开始，需要缓存租约的测试调用 seedLease() 。
+ */
+void WiFiDhcpClientUnit::init()
+{
+    m_server.received.clear();
+    m_server.nakNext = false;
+    QFile::remove(m_dir.filePath(QString("dhcpc.leases")));
+}
+
+/* 写入 test_discover 获得的租约，按 BSSID 和 SSID 缓存。
+ */
+void WiFiDhcpClientUnit::seedLease()
+{
+    WiFiDhcpLease lease;
+    lease.address = CLIENT_ADDRESS;
+    lease.netmask = CLIENT_NETMASK;
+    lease.router = SERVER_ADDRESS;
+    lease.server = SERVER_ADDRESS;
+    lease.dns << SERVER_ADDRESS;
+    lease.leaseTime = LEASE_TIME;
+    lease.renewalTime = LEASE_TIME / 2;
+    lease.rebindingTime = LEASE_TIME * 7 / 8;
+    lease.obtained = QDateTime::currentMSecsSinceEpoch();
+
+    QVariantMap map;
+    map.insert(QString("bssid:") + BSSID, lease.toMap());
+    map.insert(QString("ssid:") + SSID, lease.toMap());
+
+    QFile file(m_dir.filePath(QString("dhcpc.leases")));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVERIFY(file.write(QJsonDocument::fromVariant(map).toJson()) > 0);
+}
+
+void WiFiDhcpClientUnit::test_discover()
+{
+    WiFiDhcpClient client(QString::fromLatin1(CLIENT_IFNAME));
+    QSignalSpy obtained(&client, SIGNAL(leaseObtained(WiFiDhcpLease)));
+    QSignalSpy lost(&client, SIGNAL(leaseLost()));
+
+    client.start(BSSID, SSID);
+    QTRY_COMPARE(client.state(), WiFiDhcpClient::Bound);
+    QCOMPARE(obtained.count(), 1);
+    QCOMPARE(m_server.received, QList<int>() << DHCPDISCOVER << DHCPREQUEST);
+
+    QCOMPARE(client.lease().address, CLIENT_ADDRESS);
+    QCOMPARE(client.lease().netmask, CLIENT_NETMASK);
+    QCOMPARE(client.lease().router, SERVER_ADDRESS);
+    QCOMPARE(client.lease().leaseTime, LEASE_TIME);
+    QCOMPARE(interfaceAddress(CLIENT_IFNAME), CLIENT_ADDRESS);
+
+    QFile resolv(m_dir.filePath(QString("resolv.conf")));
+    QVERIFY(resolv.open(QIODevice::ReadOnly));
+    QCOMPARE(resolv.readAll(), QByteArray("nameserver 10.77.0.1\n"));
+
+    // 链路断开：移除地址，保留缓存租约
+    client.stop();
+    QCOMPARE(client.state(), WiFiDhcpClient::Stopped);
+    QCOMPARE(lost.count(), 1);
+    QCOMPARE(interfaceAddress(CLIENT_IFNAME), quint32(0));
+    QCOMPARE(client.cachedLease(BSSID, QString()).address, CLIENT_ADDRESS);
+    QCOMPARE(client.cachedLease(QString(), SSID).address, CLIENT_ADDRESS);
+
+    // 每次 DISCONNECTED 都会调用，已经停止时不做任何事
+    QSignalSpy stateChanged(&client, SIGNAL(stateChanged(WiFiDhcpClient::State)));
+    client.stop();
+    QCOMPARE(stateChanged.count(), 0);
+    QCOMPARE(lost.count(), 1);
+}
+
+void WiFiDhcpClientUnit::test_reboot()
+{
+    // 新的客户端从 WIFI_DHCPC_LEASES 读取缓存租约
+    seedLease();
+    WiFiDhcpClient client(QString::fromLatin1(CLIENT_IFNAME));
+    QCOMPARE(client.cachedLease(BSSID, SSID).address, CLIENT_ADDRESS);
+
+    client.start(BSSID, SSID);
+    QCOMPARE(client.state(), WiFiDhcpClient::Rebooting);
+    QTRY_COMPARE(client.state(), WiFiDhcpClient::Bound);
+    QCOMPARE(m_server.received, QList<int>() << DHCPREQUEST);
+    QCOMPARE(interfaceAddress(CLIENT_IFNAME), CLIENT_ADDRESS);
+
+    client.stop();
+}
+
+void WiFiDhcpClientUnit::test_nak()
+{
+    seedLease();
+    WiFiDhcpClient client(QString::fromLatin1(CLIENT_IFNAME));
+    QSignalSpy obtained(&client, SIGNAL(leaseObtained(WiFiDhcpLease)));
+
+    m_server.nakNext = true;
+    client.start(BSSID, SSID);
+    QCOMPARE(client.state(), WiFiDhcpClient::Rebooting);
+    QTRY_COMPARE(client.state(), WiFiDhcpClient::Bound);
+    QCOMPARE(obtained.count(), 1);
+    QCOMPARE(m_server.received,
+             QList<int>() << DHCPREQUEST << DHCPDISCOVER << DHCPREQUEST);
+
+    client.release();
+    QCOMPARE(client.state(), WiFiDhcpClient::Stopped);
+    QVERIFY(!client.cachedLease(BSSID, SSID).isValid());
+}
+
+QTEST_GUILESS_MAIN(WiFiDhcpClientUnit)
+
+#include "tst_wifidhcpclientunit.moc"
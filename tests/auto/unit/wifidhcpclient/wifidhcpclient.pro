@@ -0,0 +1,12 @@
+QT += testlib wifi wifi-private
+QT -= gui
+
+CONFIG += testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../../../../src/3rdparty/wpa_supplicant/src \
+               $$PWD/../../../../src/3rdparty/wpa_supplicant/src/utils
+
+SOURCES +=  tst_wifidhcpclientunit.cpp
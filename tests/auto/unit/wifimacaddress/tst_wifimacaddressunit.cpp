@@ -21,6 +21,38 @@
 // add necessary includes here
 #include <WiFi/wifimacaddress.h>
 
+Q_STATIC_ASSERT(sizeof(WiFiMacAddress) == sizeof(quint64));
+Q_STATIC_ASSERT(!QTypeInfo<WiFiMacAddress>::isComplex);
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+Q_STATIC_ASSERT(WiFiMacAddress(QLatin1String("0c:4b:54:7a:21:21", 17)).toUInt64()
+                == Q_UINT64_C(0x0c4b547a2121));
+#endif
+
+/* 旧实现，仅用于基准测试对比 */
+static quint64 legacyParse(const QString &address)
+{
+    QString a = address;
+    if (a.length() == 17) {
+        a.remove(QLatin1Char(':'));
+    }
+    if (a.length() == 12) {
+        bool ok;
+        const quint64 result = a.toULongLong(&ok, 16);
+        return ok ? result : 0;
+    }
+    return 0;
+}
+
+static QString legacyToString(quint64 address)
+{
+    QString s(QStringLiteral("%1:%2:%3:%4:%5:%6"));
+    for (int i = 5; i >= 0; --i) {
+        const quint8 a = (address >> (i * 8)) & 0xff;
+        s = s.arg(a, 2, 16, QLatin1Char('0'));
+    }
+    return s.toUpper();
+}
+
 class WiFiMacAddressUnit : public QObject
 {
     Q_OBJECT
@@ -50,6 +82,20 @@ private slots:
 
     void test_clear_data();
     void test_clear();
+
+    void test_invalid_data();
+    void test_invalid();
+
+    void test_latin1();
+    void test_hash();
+
+    void benchmark_parse_data();
+    void benchmark_parse();
+
+    void benchmark_toString_data();
+    void benchmark_toString();
+
+    void benchmark_copy();
 };
 
 WiFiMacAddressUnit::WiFiMacAddressUnit()
@@ -265,6 +311,115 @@ void WiFiMacAddressUnit::test_clear()
     QVERIFY(address.toString() == QString("00:00:00:00:00:00"));
 }
 
+void WiFiMacAddressUnit::test_invalid_data()
+{
+    QTest::addColumn<QString>("address");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("short") << QString("11:22:33:44:55");
+    QTest::newRow("long") << QString("11:22:33:44:55:66:77");
+    QTest::newRow("separator") << QString("11-22-33-44-55-66");
+    QTest::newRow("misplaced") << QString("1:122:33:44:55:66");
+    QTest::newRow("digit") << QString("11:22:33:44:55:6G");
+    QTest::newRow("digit12") << QString("11223344556x");
+    QTest::newRow("unicode") << QString::fromUtf8("11:22:33:44:55:6\xe4\xb8\x80");
+}
+
+void WiFiMacAddressUnit::test_invalid()
+{
+    QFETCH(QString, address);
+    QVERIFY(WiFiMacAddress(address).isNull());
+}
+
+void WiFiMacAddressUnit::test_latin1()
+{
+    const WiFiMacAddress address(QLatin1String("0c:4b:54:7a:21:21"));
+    QCOMPARE(address.toUInt64(), Q_UINT64_C(0x0c4b547a2121));
+    QCOMPARE(address, WiFiMacAddress(QString("0C4B547A2121")));
+    QCOMPARE(address.toString(), QString("0C:4B:54:7A:21:21"));
+    QVERIFY(WiFiMacAddress(QLatin1String("any")).isNull());
+}
+
+void WiFiMacAddressUnit::test_hash()
+{
+    const WiFiMacAddress a(Q_UINT64_C(0x112233445566));
+    const WiFiMacAddress b(QString("11:22:33:44:55:66"));
+    QCOMPARE(qHash(a), qHash(b));
+    QCOMPARE(qHash(a, 7), qHash(b, 7));
+
+    QSet<WiFiMacAddress> set;
+    set.insert(a);
+    set.insert(b);
+    set.insert(WiFiMacAddress(Q_UINT64_C(0xaabbccddeeff)));
+    QCOMPARE(set.size(), 2);
+    QVERIFY(set.contains(WiFiMacAddress(QString("aa:bb:cc:dd:ee:ff"))));
+}
+
+void WiFiMacAddressUnit::benchmark_parse_data()
+{
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("legacy") << true;
+    QTest::newRow("inline") << false;
+}
+
+void WiFiMacAddressUnit::benchmark_parse()
+{
+    QFETCH(bool, legacy);
+    const QString address("0c:4b:54:7a:21:21");
+    quint64 result = 0;
+
+    if (legacy) {
+        QBENCHMARK {
+            result = legacyParse(address);
+        }
+    } else {
+        QBENCHMARK {
+            result = WiFiMacAddress(address).toUInt64();
+        }
+    }
+    QCOMPARE(result, Q_UINT64_C(0x0c4b547a2121));
+}
+
+void WiFiMacAddressUnit::benchmark_toString_data()
+{
+    benchmark_parse_data();
+}
+
+void WiFiMacAddressUnit::benchmark_toString()
+{
+    QFETCH(bool, legacy);
+    const WiFiMacAddress address(Q_UINT64_C(0x0c4b547a2121));
+    QString result;
+
+    if (legacy) {
+        QBENCHMARK {
+            result = legacyToString(address.toUInt64());
+        }
+    } else {
+        QBENCHMARK {
+            result = address.toString();
+        }
+    }
+    QCOMPARE(result, QString("0C:4B:54:7A:21:21"));
+}
+
+void WiFiMacAddressUnit::benchmark_copy()
+{
+    QVector<WiFiMacAddress> addresses;
+    for (int i = 0; i < 1000; ++i) {
+        addresses.append(WiFiMacAddress(Q_UINT64_C(0x0c4b547a0000) + i));
+    }
+
+    QBENCHMARK {
+        QVector<WiFiMacAddress> copy;
+        copy.reserve(addresses.size());
+        for (const WiFiMacAddress &address : addresses) {
+            copy.append(address);
+        }
+        QCOMPARE(copy.size(), addresses.size());
+    }
+}
 
 QTEST_APPLESS_MAIN(WiFiMacAddressUnit)
 
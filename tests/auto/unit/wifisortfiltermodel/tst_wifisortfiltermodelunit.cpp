@@ -0,0 +1,367 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include <QtTest/QtTest>
+#include <QtGui/qstandarditemmodel.h>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+#include <QtTest/qabstractitemmodeltester.h>
+#endif
+
+// add necessary includes here
+#include "qquickwifisortfiltermodel_p.h"
+
+enum {
+    SsidRole = Qt::UserRole + 1,
+    RssiRole
+};
+
+/* 支持 moveRows 的一维列表，与 WiFiScanResultModel 一样以行移动调整顺序 */
+class WiFiListModel : public QAbstractListModel
+{
+public:
+    void append(const QString &ssid, int rssi)
+    {
+        beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size());
+        m_rows.append(qMakePair(ssid, rssi));
+        endInsertRows();
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE
+    {
+        return parent.isValid() ? 0 : m_rows.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const Q_DECL_OVERRIDE
+    {
+        if (!index.isValid()) {
+            return QVariant();
+        }
+        if (role == SsidRole) {
+            return m_rows.at(index.row()).first;
+        }
+        if (role == RssiRole) {
+            return m_rows.at(index.row()).second;
+        }
+        return QVariant();
+    }
+
+    QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE
+    {
+        QHash<int, QByteArray> roles;
+        roles.insert(SsidRole, "ssid");
+        roles.insert(RssiRole, "rssi");
+        return roles;
+    }
+
+    bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count,
+                  const QModelIndex &destinationParent, int destinationChild) Q_DECL_OVERRIDE
+    {
+        if (!beginMoveRows(sourceParent, sourceRow, sourceRow + count - 1,
+                           destinationParent, destinationChild)) {
+            return false;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (destinationChild > sourceRow) {
+                m_rows.move(sourceRow, destinationChild - 1);
+            } else {
+                m_rows.move(sourceRow + i, destinationChild + i);
+            }
+        }
+        endMoveRows();
+        return true;
+    }
+
+private:
+    QVector<QPair<QString, int> > m_rows;
+};
+
+class WiFiSortFilterModelUnit : public QObject
+{
+    Q_OBJECT
+
+public:
+    WiFiSortFilterModelUnit();
+    ~WiFiSortFilterModelUnit();
+
+public slots:
+    void init();
+    void cleanup();
+
+private slots:
+    void test_sort();
+    void test_move();
+    void test_hysteresis();
+    void test_insert();
+    void test_remove();
+    void test_filter();
+    void test_layout();
+    void test_sourceMove();
+
+private:
+    void append(const QString &ssid, int rssi);
+    void setRssi(int sourceRow, int rssi);
+    QStringList order() const;
+
+    QStandardItemModel *m_source;
+    QQuickWiFiSortFilterModel *m_model;
+};
+
+WiFiSortFilterModelUnit::WiFiSortFilterModelUnit()
+    : m_source(NULL)
+    , m_model(NULL)
+{
+
+}
+
+WiFiSortFilterModelUnit::~WiFiSortFilterModelUnit()
+{
+
+}
+
+void WiFiSortFilterModelUnit::init()
+{
+    m_source = new QStandardItemModel(this);
+    QHash<int, QByteArray> roles;
+    roles.insert(SsidRole, "ssid");
+    roles.insert(RssiRole, "rssi");
+    m_source->setItemRoleNames(roles);
+    append(QString("A"), -40);
+    append(QString("B"), -50);
+    append(QString("C"), -60);
+    append(QString("D"), -70);
+
+    m_model = new QQuickWiFiSortFilterModel(this);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    new QAbstractItemModelTester(m_model, QAbstractItemModelTester::FailureReportingMode::QtTest,
+                                 m_model);
+#endif
+    m_model->setSource(m_source);
+    m_model->setSortRole("rssi");
+    m_model->setSortOrder(Qt::DescendingOrder);
+    m_model->setIncrementalSort(true);
+    m_model->componentComplete();
+}
+
+void WiFiSortFilterModelUnit::cleanup()
+{
+    delete m_model;
+    delete m_source;
+    m_model = NULL;
+    m_source = NULL;
+}
+
+void WiFiSortFilterModelUnit::append(const QString &ssid, int rssi)
+{
+    QStandardItem *item = new QStandardItem;
+    item->setData(ssid, SsidRole);
+    item->setData(rssi, RssiRole);
+    m_source->appendRow(item);
+}
+
+void WiFiSortFilterModelUnit::setRssi(int sourceRow, int rssi)
+{
+    m_source->setData(m_source->index(sourceRow, 0), rssi, RssiRole);
+}
+
+/* 代理模型当前的 SSID 顺序，同时检查两个方向的映射一致 */
+QStringList WiFiSortFilterModelUnit::order() const
+{
+    QStringList ssids;
+    for (int row = 0; row < m_model->rowCount(); ++row) {
+        const QModelIndex index = m_model->index(row, 0);
+        const QModelIndex source = m_model->mapToSource(index);
+        if (m_model->mapFromSource(source) != index) {
+            return QStringList();
+        }
+        ssids << m_model->data(index, SsidRole).toString();
+    }
+    return ssids;
+}
+
+void WiFiSortFilterModelUnit::test_sort()
+{
+    QCOMPARE(m_model->count(), 4);
+    QCOMPARE(order(), QString("A,B,C,D").split(','));
+
+    m_model->setSortOrder(Qt::AscendingOrder);
+    QCOMPARE(order(), QString("D,C,B,A").split(','));
+}
+
+/* 排序键变化只移动该行，不发出 layoutChanged 或删除/插入 */
+void WiFiSortFilterModelUnit::test_move()
+{
+    QSignalSpy moved(m_model, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)));
+    QSignalSpy layout(m_model, SIGNAL(layoutChanged(QList<QPersistentModelIndex>,
+                                                    QAbstractItemModel::LayoutChangeHint)));
+    QSignalSpy removed(m_model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+    QSignalSpy inserted(m_model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+    QPersistentModelIndex c = m_model->index(2, 0);
+
+    setRssi(2, -45);
+    QCOMPARE(order(), QString("A,C,B,D").split(','));
+    QCOMPARE(moved.count(), 1);
+    QCOMPARE(c.row(), 1);
+
+    setRssi(0, -90);
+    QCOMPARE(order(), QString("C,B,D,A").split(','));
+    QCOMPARE(moved.count(), 2);
+
+    // 不改变顺序的变化不移动
+    setRssi(1, -51);
+    QCOMPARE(order(), QString("C,B,D,A").split(','));
+    QCOMPARE(moved.count(), 2);
+
+    QCOMPARE(layout.count(), 0);
+    QCOMPARE(removed.count(), 0);
+    QCOMPARE(inserted.count(), 0);
+}
+
+void WiFiSortFilterModelUnit::test_hysteresis()
+{
+    QSignalSpy moved(m_model, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)));
+    m_model->setSortHysteresis(2);
+
+    // 与相邻行相差不超过 2 dBm 时保持原位
+    setRssi(1, -39);
+    QCOMPARE(order(), QString("A,B,C,D").split(','));
+    QCOMPARE(moved.count(), 0);
+
+    setRssi(1, -30);
+    QCOMPARE(order(), QString("B,A,C,D").split(','));
+    QCOMPARE(moved.count(), 1);
+}
+
+void WiFiSortFilterModelUnit::test_insert()
+{
+    QSignalSpy inserted(m_model, SIGNAL(rowsInserted(QModelIndex, int, int)));
+    QSignalSpy count(m_model, SIGNAL(countChanged()));
+
+    append(QString("E"), -55);
+    QCOMPARE(order(), QString("A,B,E,C,D").split(','));
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted.at(0).at(1).toInt(), 2);
+
+    QStandardItem *item = new QStandardItem;
+    item->setData(QString("F"), SsidRole);
+    item->setData(-80, RssiRole);
+    m_source->insertRow(0, item);
+    QCOMPARE(order(), QString("A,B,E,C,D,F").split(','));
+    QCOMPARE(inserted.at(1).at(1).toInt(), 5);
+    QCOMPARE(count.count(), 2);
+
+    // 插入后源行号整体后移，变化仍作用于正确的行
+    setRssi(1, -75);
+    QCOMPARE(order(), QString("B,E,C,D,A,F").split(','));
+}
+
+void WiFiSortFilterModelUnit::test_remove()
+{
+    QSignalSpy removed(m_model, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+
+    m_source->removeRow(1);
+    QCOMPARE(order(), QString("A,C,D").split(','));
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(1).toInt(), 1);
+
+    setRssi(2, -30);
+    QCOMPARE(order(), QString("D,A,C").split(','));
+}
+
+void WiFiSortFilterModelUnit::test_filter()
+{
+    m_model->setFilterRole("ssid");
+    m_model->setFilterSyntax(QQuickWiFiSortFilterModel::RegExp);
+    m_model->setFilterString(QString("^[BD]$"));
+    QCOMPARE(order(), QString("B,D").split(','));
+
+    m_source->setData(m_source->index(0, 0), QString("D"), SsidRole);
+    QCOMPARE(order(), QString("D,B,D").split(','));
+
+    m_source->setData(m_source->index(1, 0), QString("X"), SsidRole);
+    QCOMPARE(order(), QString("D,D").split(','));
+
+    m_model->setFilterString(QString());
+    QCOMPARE(order(), QString("D,X,C,D").split(','));
+}
+
+/* 未启用增量排序时整体重新排序 */
+void WiFiSortFilterModelUnit::test_layout()
+{
+    m_model->setIncrementalSort(false);
+    QSignalSpy moved(m_model, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)));
+    QSignalSpy layout(m_model, SIGNAL(layoutChanged(QList<QPersistentModelIndex>,
+                                                    QAbstractItemModel::LayoutChangeHint)));
+    QPersistentModelIndex d = m_model->index(3, 0);
+
+    setRssi(3, -10);
+    QCOMPARE(order(), QString("D,A,B,C").split(','));
+    QCOMPARE(layout.count(), 1);
+    QCOMPARE(moved.count(), 0);
+    QCOMPARE(d.row(), 0);
+}
+
+/* 源模型的行移动只更新映射，排序后的顺序不变时视图收不到任何结构变化 */
+void WiFiSortFilterModelUnit::test_sourceMove()
+{
+    WiFiListModel source;
+    source.append(QString("A"), -40);
+    source.append(QString("B"), -50);
+    source.append(QString("C"), -60);
+    source.append(QString("D"), -70);
+
+    QQuickWiFiSortFilterModel model;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+#endif
+    model.setSource(&source);
+    model.setSortRole("rssi");
+    model.setSortOrder(Qt::DescendingOrder);
+    model.setIncrementalSort(true);
+    model.componentComplete();
+
+    QSignalSpy reset(&model, SIGNAL(modelReset()));
+    QSignalSpy moved(&model, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)));
+    QSignalSpy layout(&model, SIGNAL(layoutChanged(QList<QPersistentModelIndex>,
+                                                   QAbstractItemModel::LayoutChangeHint)));
+
+    QVERIFY(source.moveRow(QModelIndex(), 3, QModelIndex(), 0));
+    QVERIFY(source.moveRow(QModelIndex(), 1, QModelIndex(), 4));
+    // 源顺序 D,B,C,A
+    for (int row = 0; row < model.rowCount(); ++row) {
+        const QModelIndex index = model.index(row, 0);
+        QCOMPARE(model.mapFromSource(model.mapToSource(index)), index);
+    }
+    QCOMPARE(model.data(model.index(0, 0), SsidRole).toString(), QString("A"));
+    QCOMPARE(model.data(model.index(3, 0), SsidRole).toString(), QString("D"));
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(moved.count(), 0);
+    QCOMPARE(layout.count(), 0);
+
+    // 不排序时代理顺序跟随源模型，以行移动通知
+    model.sort(-1);
+    QCOMPARE(model.data(model.index(0, 0), SsidRole).toString(), QString("D"));
+    QVERIFY(source.moveRow(QModelIndex(), 3, QModelIndex(), 0));
+    QCOMPARE(model.data(model.index(0, 0), SsidRole).toString(), QString("A"));
+    QCOMPARE(model.data(model.index(1, 0), SsidRole).toString(), QString("D"));
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(moved.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(WiFiSortFilterModelUnit)
+
+#include "tst_wifisortfiltermodelunit.moc"
@@ -0,0 +1,13 @@
+QT += testlib qml
+
+CONFIG += testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../../../../src/imports/wifi
+
+HEADERS += $$PWD/../../../../src/imports/wifi/qquickwifisortfiltermodel_p.h
+
+SOURCES +=  tst_wifisortfiltermodelunit.cpp \
+            $$PWD/../../../../src/imports/wifi/qquickwifisortfiltermodel.cpp
@@ -0,0 +1,449 @@
+/**
+ ** This file is part of the WiFi project.
+ ** Copyright 2019 张作深 <zhangzuoshen@hangsheng.com.cn>.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#include <QtTest/QtTest>
+
+// add necessary includes here
+#include <WiFi/private/wifisupplicantparser_p.h>
+
+#if defined(__GLIBC__)
+/* 统计堆分配次数，QString/QByteArray 直接使用 malloc/realloc ，
+ * 因此在这里而不是 operator new 中计数。
+ */
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static bool s_counting = false;
+static int s_allocations = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    if (s_counting) {
+        s_allocations++;
+    }
+    return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    if (s_counting) {
+        s_allocations++;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+#define WIFI_COUNT_ALLOCATIONS(allocations, code) \
+    do { \
+        s_allocations = 0; \
+        s_counting = true; \
+        code; \
+        s_counting = false; \
+        allocations = s_allocations; \
+    } while (0)
+#else
+#define WIFI_COUNT_ALLOCATIONS(allocations, code) \
+    do { \
+        code; \
+        allocations = -1; \
+    } while (0)
+#endif
+
+static const char STATUS_REPLY[] =
+    "bssid=a4:50:46:78:0c:f6\n"
+    "freq=2472\n"
+    "ssid=ZZS\n"
+    "id=0\n"
+    "mode=station\n"
+    "pairwise_cipher=CCMP\n"
+    "group_cipher=CCMP\n"
+    "key_mgmt=WPA2-PSK\n"
+    "wpa_state=COMPLETED\n"
+    "ip_address=192.168.1.21\n"
+    "p2p_device_address=38:d2:69:c3:f8:3b\n"
+    "address=38:d2:69:c3:f8:3b\n"
+    "uuid=7a8b5c2e-1d4f-5a6b-9c0d-e1f2a3b4c5d6\n";
+
+static const char BSS_REPLY[] =
+    "id=12\n"
+    "bssid=0c:4b:54:7a:21:21\n"
+    "freq=2437\n"
+    "beacon_int=100\n"
+    "capabilities=0x0431\n"
+    "qual=0\n"
+    "noise=-89\n"
+    "level=-47\n"
+    "tsf=0000012345678901\n"
+    "age=3\n"
+    "ie=000668736165797a010882848b960c1218240301060706434e20010d1e2a01"
+    "0032043048606c30140100000fac040100000fac040100000fac020c000b0500"
+    "00127a00dd180050f2020101800003a4000027a4000042435e0062322f00dd09"
+    "0010180200001c0000\n"
+    "flags=[WPA2-PSK-CCMP][ESS]\n"
+    "ssid=hsaeyz\n"
+    "snr=42\n"
+    "est_throughput=65000\n";
+
+static const char LIST_NETWORKS_REPLY[] =
+    "network id / ssid / bssid / flags\n"
+    "0\texample network\tany\t[CURRENT]\n"
+    "1\thsaeyz\t0c:4b:54:7a:21:21\t[DISABLED]\n";
+
+static const char SCAN_RESULTS_REPLY[] =
+    "bssid / frequency / signal level / flags / ssid\n"
+    "00:09:5b:95:e0:4e\t2412\t-40\t[WPA-PSK-CCMP]\tjkm private\n"
+    "02:55:24:33:77:a3\t2462\t-69\t[WPA-PSK-TKIP]\ttesting\n"
+    "00:09:5b:95:e0:4f\t2412\t-78\t\tjkm guest\n";
+
+/* 改造前基于 QRegExp/split/section 的实现，作为基准对照。
+ */
+static WiFiScanResult legacyFromBSS(const QString &bss)
+{
+    QString bssid, ssid, flags;
+    qint16 rssi = WiFi::MIN_RSSI;
+    int frequency = 0;
+    QStringList items = bss.split(QRegExp(QStringLiteral("\\n")));
+    for (int i = 0; i < items.size(); i++) {
+        QString str = items.at(i);
+        if (str.startsWith(QStringLiteral("bssid="))) {
+            bssid = str.section(QLatin1Char('='), 1);
+        } else if (str.startsWith(QStringLiteral("ssid="))) {
+            ssid = str.section(QLatin1Char('='), 1);
+        } else if (str.startsWith(QStringLiteral("level="))) {
+            bool ok;
+            short level = str.section(QLatin1Char('='), 1).trimmed().toShort(&ok);
+            if(ok) {
+                rssi = level;
+            }
+        } else if (str.startsWith(QStringLiteral("freq="))) {
+            bool ok;
+            int freq = str.section(QLatin1Char('='), 1).trimmed().toInt(&ok);
+            if(ok) {
+                frequency = freq;
+            }
+        } else if (str.startsWith(QStringLiteral("flags="))) {
+            flags = str.section(QLatin1Char('='), 1);
+        }
+    }
+    WiFiScanResult result(bssid, ssid);
+    result.setRssi(rssi);
+    result.setFrequency(frequency);
+    result.setFlags(flags);
+    return result;
+}
+
+static WiFiInfo legacyFromStatus(const QString &status)
+{
+    WiFiMacAddress address, bssid;
+    QString ssid, ip_address;
+    int frequency = 0, networkId = -1;
+    QStringList items = status.split(QRegExp(QStringLiteral("\\n")));
+    for (int i = 0; i < items.size(); i++) {
+        QString str = items.at(i);
+        if (str.startsWith(QStringLiteral("address="))) {
+            address = WiFiMacAddress(str.section(QLatin1Char('='), 1));
+        } else if(str.startsWith(QStringLiteral("bssid="))) {
+            bssid = WiFiMacAddress(str.section(QLatin1Char('='), 1));
+        } else if(str.startsWith(QStringLiteral("ssid="))) {
+            ssid = str.section(QLatin1Char('='), 1);
+        } else if(str.startsWith(QStringLiteral("freq="))) {
+            bool ok;
+            int freq = str.section(QLatin1Char('='), 1).trimmed().toInt(&ok);
+            if(ok) {
+                frequency = freq;
+            }
+        } else if(str.startsWith(QStringLiteral("ip_address="))) {
+            ip_address = str.section(QLatin1Char('='), 1);
+        } else if(str.startsWith(QStringLiteral("id="))) {
+            bool ok;
+            int id = str.section(QLatin1Char('='), 1).trimmed().toInt(&ok);
+            if(ok) {
+                networkId = id;
+            }
+        }
+    }
+
+    WiFiInfo info;
+    info.setMacAddress(address);
+    info.setBSSID(bssid);
+    info.setSSID(ssid);
+    info.setFrequency(frequency);
+    info.setIpAddress(ip_address);
+    info.setNetworkId(networkId);
+    return info;
+}
+
+class WiFiSupplicantParserUnit : public QObject
+{
+    Q_OBJECT
+
+public:
+    WiFiSupplicantParserUnit();
+    ~WiFiSupplicantParserUnit();
+
+private slots:
+    void test_keyHash();
+
+    void test_tokenizer();
+
+    void test_fromStatus();
+    void test_fromBSS();
+    void test_fromBSSRange();
+    void test_fromListNetworks();
+    void test_fromScanResult();
+
+    void test_allocations();
+
+    void benchmark_fromBSS_data();
+    void benchmark_fromBSS();
+
+    void benchmark_fromStatus_data();
+    void benchmark_fromStatus();
+
+private:
+    WiFiSupplicantParser parser;
+};
+
+WiFiSupplicantParserUnit::WiFiSupplicantParserUnit()
+{
+
+}
+
+WiFiSupplicantParserUnit::~WiFiSupplicantParserUnit()
+{
+
+}
+
+void WiFiSupplicantParserUnit::test_keyHash()
+{
+    Q_STATIC_ASSERT(wifiKeyHash("bssid") != wifiKeyHash("ssid"));
+
+    const QByteArray reply = QByteArrayLiteral("bssid=1\nssid=2\n");
+    WiFiSupplicantTokenizer tokenizer(reply);
+    QVERIFY(tokenizer.readPair());
+    QCOMPARE(tokenizer.keyHash(), wifiKeyHash("bssid"));
+    QVERIFY(tokenizer.readPair());
+    QCOMPARE(tokenizer.keyHash(), wifiKeyHash("ssid"));
+}
+
+void WiFiSupplicantParserUnit::test_tokenizer()
+{
+    const QByteArray reply = QByteArrayLiteral("OK\nkey=value=1\nempty=\n\nlast=x");
+    WiFiSupplicantTokenizer tokenizer(reply);
+
+    QVERIFY(tokenizer.readPair());
+    QCOMPARE(QString(tokenizer.key()), QStringLiteral("key"));
+    QCOMPARE(QString(tokenizer.value()), QStringLiteral("value=1"));
+    QVERIFY(tokenizer.readPair());
+    QCOMPARE(QString(tokenizer.key()), QStringLiteral("empty"));
+    QVERIFY(tokenizer.value().size() == 0);
+    QVERIFY(tokenizer.readPair());
+    QCOMPARE(QString(tokenizer.key()), QStringLiteral("last"));
+    QCOMPARE(QString(tokenizer.value()), QStringLiteral("x"));
+    QVERIFY(!tokenizer.readPair());
+
+    bool ok;
+    QCOMPARE(WiFiSupplicantTokenizer::toInt(QLatin1String("-47"), &ok), -47);
+    QVERIFY(ok);
+    WiFiSupplicantTokenizer::toInt(QLatin1String("4a"), &ok);
+    QVERIFY(!ok);
+    QCOMPARE(WiFiSupplicantTokenizer::toMacAddress(QLatin1String("0c:4b:54:7a:21:21")),
+             Q_UINT64_C(0x0c4b547a2121));
+    QCOMPARE(WiFiSupplicantTokenizer::toMacAddress(QLatin1String("any")),
+             Q_UINT64_C(0));
+}
+
+void WiFiSupplicantParserUnit::test_fromStatus()
+{
+    const QByteArray reply = QByteArray::fromRawData(STATUS_REPLY,
+                             sizeof(STATUS_REPLY) - 1);
+    WiFiInfo info = parser.fromStatus(reply);
+    QCOMPARE(info, legacyFromStatus(QString::fromLatin1(reply)));
+    QCOMPARE(info.bssid(), WiFiMacAddress(QStringLiteral("a4:50:46:78:0c:f6")));
+    QCOMPARE(info.macAddress(), WiFiMacAddress(QStringLiteral("38:d2:69:c3:f8:3b")));
+    QCOMPARE(info.ssid(), QStringLiteral("ZZS"));
+    QCOMPARE(info.frequency(), 2472);
+    QCOMPARE(info.networkId(), 0);
+    QCOMPARE(info.ipAddress(), QStringLiteral("192.168.1.21"));
+}
+
+void WiFiSupplicantParserUnit::test_fromBSS()
+{
+    const QByteArray reply = QByteArray::fromRawData(BSS_REPLY,
+                             sizeof(BSS_REPLY) - 1);
+    WiFiScanResult result = parser.fromBSS(reply);
+    WiFiScanResult legacy = legacyFromBSS(QString::fromLatin1(reply));
+    QCOMPARE(result.bssid(), legacy.bssid());
+    QCOMPARE(result.ssid(), legacy.ssid());
+    QCOMPARE(result.rssi(), legacy.rssi());
+    QCOMPARE(result.frequency(), legacy.frequency());
+    QCOMPARE(result.flags(), legacy.flags());
+    QCOMPARE(result.ssid(), QStringLiteral("hsaeyz"));
+    QCOMPARE(result.rssi(), qint16(-47));
+}
+
+void WiFiSupplicantParserUnit::test_fromBSSRange()
+{
+    const QByteArray partial = QByteArrayLiteral(
+                                   "id=3\nbssid=0c:4b:54:7a:21:21\nfreq=2437\nlevel=-47\n"
+                                   "flags=[WPA2-PSK-CCMP][ESS]\nssid=hsaeyz\n====\n"
+                                   "id=5\nbssid=00:09:5b:95:e0:4e\nfreq=5180\nlevel=-60\n"
+                                   "flags=[ESS]\nssid=guest\n====\n");
+    QList<int> ids;
+    bool finished = true;
+    WiFiScanResultList list = parser.fromBSSRange(partial, &ids, &finished);
+    QVERIFY(!finished);
+    QCOMPARE(ids, QList<int>() << 3 << 5);
+    QCOMPARE(list.length(), 2);
+    QCOMPARE(list.at(0).ssid(), QStringLiteral("hsaeyz"));
+    QCOMPARE(list.at(1).bssid(), WiFiMacAddress(QStringLiteral("00:09:5b:95:e0:4e")));
+    QCOMPARE(list.at(1).frequency(), 5180);
+
+    const QByteArray last = QByteArrayLiteral(
+                                "id=9\nbssid=02:55:24:33:77:a3\nfreq=2462\nlevel=-69\n"
+                                "flags=[WPA-PSK-TKIP]\nssid=testing\n####\n");
+    ids.clear();
+    list = parser.fromBSSRange(last, &ids, &finished);
+    QVERIFY(finished);
+    QCOMPARE(ids, QList<int>() << 9);
+    QCOMPARE(list.at(0).rssi(), qint16(-69));
+
+    ids.clear();
+    list = parser.fromBSSRange(QByteArray(), &ids, &finished);
+    QVERIFY(list.isEmpty());
+    QVERIFY(ids.isEmpty());
+}
+
+void WiFiSupplicantParserUnit::test_fromListNetworks()
+{
+    WiFiNetworkList list = parser.fromListNetworks(QByteArray(LIST_NETWORKS_REPLY));
+    QCOMPARE(list.length(), 2);
+    QCOMPARE(list.at(0).networkId(), 0);
+    QCOMPARE(list.at(0).ssid(), QStringLiteral("example network"));
+    QVERIFY(list.at(0).bssid().isNull());
+    QCOMPARE(list.at(1).networkId(), 1);
+    QCOMPARE(list.at(1).bssid(), WiFiMacAddress(QStringLiteral("0c:4b:54:7a:21:21")));
+}
+
+void WiFiSupplicantParserUnit::test_fromScanResult()
+{
+    QStringList bssids = parser.fromScanResult(QByteArray(SCAN_RESULTS_REPLY));
+    QCOMPARE(bssids, QStringList() << QStringLiteral("00:09:5b:95:e0:4e")
+             << QStringLiteral("02:55:24:33:77:a3")
+             << QStringLiteral("00:09:5b:95:e0:4f"));
+}
+
+void WiFiSupplicantParserUnit::test_allocations()
+{
+#if defined(__GLIBC__)
+    const QByteArray bss = QByteArray::fromRawData(BSS_REPLY, sizeof(BSS_REPLY) - 1);
+    const QString bssString = QString::fromLatin1(bss);
+    int before, after;
+    WIFI_COUNT_ALLOCATIONS(before, legacyFromBSS(bssString));
+    WIFI_COUNT_ALLOCATIONS(after, parser.fromBSS(bss));
+    qInfo("BSS allocations per parse: %d -> %d", before, after);
+    QVERIFY(after < before);
+
+    const QByteArray status = QByteArray::fromRawData(STATUS_REPLY,
+                              sizeof(STATUS_REPLY) - 1);
+    const QString statusString = QString::fromLatin1(status);
+    WIFI_COUNT_ALLOCATIONS(before, legacyFromStatus(statusString));
+    WIFI_COUNT_ALLOCATIONS(after, parser.fromStatus(status));
+    qInfo("STATUS allocations per parse: %d -> %d", before, after);
+    QVERIFY(after < before);
+
+    int tokenizer;
+    WIFI_COUNT_ALLOCATIONS(tokenizer, {
+        WiFiSupplicantTokenizer t(bss);
+        while (t.readPair()) {}
+    });
+    QCOMPARE(tokenizer, 0);
+#else
+    QSKIP("Allocation counting requires glibc.");
+#endif
+}
+
+void WiFiSupplicantParserUnit::benchmark_fromBSS_data()
+{
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("legacy") << true;
+    QTest::newRow("tokenizer") << false;
+}
+
+void WiFiSupplicantParserUnit::benchmark_fromBSS()
+{
+    QFETCH(bool, legacy);
+    const QByteArray bss = QByteArray::fromRawData(BSS_REPLY, sizeof(BSS_REPLY) - 1);
+    const QString bssString = QString::fromLatin1(bss);
+
+    int allocations;
+    if (legacy) {
+        WIFI_COUNT_ALLOCATIONS(allocations, legacyFromBSS(bssString));
+    } else {
+        WIFI_COUNT_ALLOCATIONS(allocations, parser.fromBSS(bss));
+    }
+    qInfo("allocations per parse: %d", allocations);
+
+    if (legacy) {
+        QBENCHMARK {
+            legacyFromBSS(bssString);
+        }
+    } else {
+        QBENCHMARK {
+            parser.fromBSS(bss);
+        }
+    }
+}
+
+void WiFiSupplicantParserUnit::benchmark_fromStatus_data()
+{
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("legacy") << true;
+    QTest::newRow("tokenizer") << false;
+}
+
+void WiFiSupplicantParserUnit::benchmark_fromStatus()
+{
+    QFETCH(bool, legacy);
+    const QByteArray status = QByteArray::fromRawData(STATUS_REPLY,
+                              sizeof(STATUS_REPLY) - 1);
+    const QString statusString = QString::fromLatin1(status);
+
+    int allocations;
+    if (legacy) {
+        WIFI_COUNT_ALLOCATIONS(allocations, legacyFromStatus(statusString));
+    } else {
+        WIFI_COUNT_ALLOCATIONS(allocations, parser.fromStatus(status));
+    }
+    qInfo("allocations per parse: %d", allocations);
+
+    if (legacy) {
+        QBENCHMARK {
+            legacyFromStatus(statusString);
+        }
+    } else {
+        QBENCHMARK {
+            parser.fromStatus(status);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(WiFiSupplicantParserUnit)
+
+#include "tst_wifisupplicantparserunit.moc"
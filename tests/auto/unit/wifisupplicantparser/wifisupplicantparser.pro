@@ -0,0 +1,9 @@
+QT += testlib wifi wifi-private
+QT -= gui
+
+CONFIG += testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_wifisupplicantparserunit.cpp